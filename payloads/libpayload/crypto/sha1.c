@@ -117,6 +117,81 @@ SHA1Transform(u_int32_t state[5], const u_int8_t buffer[SHA1_BLOCK_LENGTH])
 }
 
 
+#if IS_ENABLED(CONFIG_LP_ARM64_SHA_CE)
+#include <arch/lib_helpers.h>
+
+void sha1_ce_transform(u32 state[5], const u8 *data, size_t blocks);
+
+/*
+ * Run the padded FIPS 180-2 "abc" block and a few pattern blocks through
+ * both the Crypto Extension routine and SHA1Transform(). Returns 0 if they
+ * agree with each other and with the known answer.
+ */
+static int sha1_ce_self_test(void)
+{
+	static const u_int32_t init[5] = {
+		0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+	};
+	static const u_int32_t abc[5] = {
+		0xa9993e36, 0x4706816a, 0xba3e2571, 0x7850c26c, 0x9cd0d89d,
+	};
+	u_int8_t data[4 * SHA1_BLOCK_LENGTH];
+	u_int32_t ce[5], c[5];
+	size_t i;
+
+	memset(data, 0, SHA1_BLOCK_LENGTH);
+	memcpy(data, "abc\200", 4);
+	data[SHA1_BLOCK_LENGTH - 1] = 24;
+	memcpy(ce, init, sizeof(init));
+	memcpy(c, init, sizeof(init));
+	sha1_ce_transform(ce, data, 1);
+	SHA1Transform(c, data);
+	if (memcmp(ce, abc, sizeof(abc)) || memcmp(c, abc, sizeof(abc)))
+		return -1;
+
+	for (i = 0; i < sizeof(data); i++)
+		data[i] = i * 7 + 1;
+	sha1_ce_transform(ce, data, 4);
+	for (i = 0; i < 4; i++)
+		SHA1Transform(c, data + i * SHA1_BLOCK_LENGTH);
+
+	return memcmp(ce, c, sizeof(c)) ? -1 : 0;
+}
+
+static int sha1_ce_supported(void)
+{
+	static int supported = -1;
+
+	if (supported < 0) {
+		supported = !!((raw_read_aa64isar0_el1() >>
+				ID_AA64ISAR0_SHA1_SHIFT) &
+			       ID_AA64ISAR0_FIELD_MASK);
+		if (supported && IS_ENABLED(CONFIG_LP_ARM64_SHA_CE_SELF_TEST) &&
+		    sha1_ce_self_test()) {
+			printf("SHA1 CE: self-test failed, using C code\n");
+			supported = 0;
+		}
+	}
+	return supported;
+}
+#endif
+
+/*
+ * Hash a run of whole 512-bit blocks.
+ */
+static void
+SHA1Blocks(u_int32_t state[5], const u_int8_t *data, size_t blocks)
+{
+#if IS_ENABLED(CONFIG_LP_ARM64_SHA_CE)
+	if (sha1_ce_supported()) {
+		sha1_ce_transform(state, data, blocks);
+		return;
+	}
+#endif
+	for ( ; blocks; blocks--, data += SHA1_BLOCK_LENGTH)
+		SHA1Transform(state, data);
+}
+
 /*
  * SHA1Init - Initialize new context
  */
@@ -146,9 +221,9 @@ SHA1Update(SHA1_CTX *context, const u_int8_t *data, size_t len)
 	context->count += (len << 3);
 	if ((j + len) > 63) {
 		(void)memcpy(&context->buffer[j], data, (i = 64-j));
-		SHA1Transform(context->state, context->buffer);
-		for ( ; i + 63 < len; i += 64)
-			SHA1Transform(context->state, (u_int8_t *)&data[i]);
+		SHA1Blocks(context->state, context->buffer, 1);
+		SHA1Blocks(context->state, &data[i], (len - i) / 64);
+		i += (len - i) & ~(size_t)63;
 		j = 0;
 	} else {
 		i = 0;
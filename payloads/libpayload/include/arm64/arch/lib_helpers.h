@@ -103,6 +103,10 @@
 #define DAIF_IRQ_BIT      (1 << 1)
 #define DAIF_FIQ_BIT      (1 << 0)
 
+#define ID_AA64ISAR0_SHA1_SHIFT	(8)
+#define ID_AA64ISAR0_SHA2_SHIFT	(12)
+#define ID_AA64ISAR0_FIELD_MASK	(0xf)
+
 #define SWITCH_CASE_READ(func, var, type, el)	 do {	\
 	type var = -1;					\
 	switch (el) {					\
@@ -285,6 +289,7 @@ void raw_write_far(uint64_t far, uint32_t el);
 uint64_t raw_read_hcr_el2(void);
 void raw_write_hcr_el2(uint64_t hcr_el2);
 uint64_t raw_read_aa64pfr0_el1(void);
+uint64_t raw_read_aa64isar0_el1(void);
 uint64_t raw_read_mair_el1(void);
 void raw_write_mair_el1(uint64_t mair_el1);
 uint64_t raw_read_mair_el2(void);
@@ -46,11 +46,12 @@ void arm_tf_run_bl31(u64 payload_entry, u64 payload_arg0, u64 payload_spsr)
 {
 	struct prog bl31 = PROG_INIT(PROG_BL31, CONFIG_CBFS_PREFIX"/bl31");
 	void (*bl31_entry)(bl31_params_t *params, void *plat_params) = NULL;
+	struct cbfs_load_verify verify;
 
-	if (prog_locate(&bl31))
+	if (prog_locate_load(&bl31, &verify))
 		die("BL31 not found");
 
-	bl31_entry = selfload(&bl31, false);
+	bl31_entry = selfload(&bl31, false, &verify);
 	if (!bl31_entry)
 		die("BL31 load failed");
 
@@ -60,10 +61,10 @@ void arm_tf_run_bl31(u64 payload_entry, u64 payload_arg0, u64 payload_spsr)
 		struct prog bl32 = PROG_INIT(PROG_BL32,
 					     CONFIG_CBFS_PREFIX"/secure_os");
 
-		if (prog_locate(&bl32))
+		if (prog_locate_load(&bl32, &verify))
 			die("BL32 not found");
 
-		if (cbfs_prog_stage_load(&bl32))
+		if (cbfs_prog_stage_load(&bl32, &verify))
 			die("BL32 load failed");
 
 		SET_PARAM_HEAD(&bl32_ep_info, PARAM_EP, VERSION_1,
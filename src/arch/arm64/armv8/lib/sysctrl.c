@@ -536,6 +536,16 @@ uint64_t raw_read_aa64pfr0_el1(void)
 	return aa64pfr0_el1;
 }
 
+/* AA64ISAR0 */
+uint64_t raw_read_aa64isar0_el1(void)
+{
+	uint64_t aa64isar0_el1;
+
+	__asm__ __volatile__("mrs %0, ID_AA64ISAR0_EL1\n\t" : "=r" (aa64isar0_el1) :  : "memory");
+
+	return aa64isar0_el1;
+}
+
 /* MAIR */
 uint64_t raw_read_mair_el1(void)
 {
@@ -1059,3 +1069,21 @@ void raw_write_cntfrq_el0(uint32_t cntfrq_el0)
 {
 	__asm__ __volatile__("msr CNTFRQ_EL0, %0\n\t" : : "r" ((uint64_t)cntfrq_el0) : "memory");
 }
+
+uint32_t raw_read_cntps_ctl_el1(void)
+{
+	uint64_t cntps_ctl_el1;
+
+	__asm__ __volatile__("mrs %0, CNTPS_CTL_EL1\n\t" : "=r" (cntps_ctl_el1) : : "memory");
+	return cntps_ctl_el1;
+}
+
+void raw_write_cntps_ctl_el1(uint32_t cntps_ctl_el1)
+{
+	__asm__ __volatile__("msr CNTPS_CTL_EL1, %0\n\t" : : "r" ((uint64_t)cntps_ctl_el1) : "memory");
+}
+
+void raw_write_cntps_tval_el1(uint32_t cntps_tval_el1)
+{
+	__asm__ __volatile__("msr CNTPS_TVAL_EL1, %0\n\t" : : "r" ((uint64_t)cntps_tval_el1) : "memory");
+}
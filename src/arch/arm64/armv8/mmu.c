@@ -38,11 +38,15 @@
 #include <arch/lib_helpers.h>
 #include <arch/cache.h>
 
-/* This just caches the next free table slot (okay to do since they fill up from
- * bottom to top and can never be freed up again). It will reset to its initial
- * value on stage transition, so we still need to check it for UNUSED_DESC. */
+/* This just caches the lowest table slot that may be free. Tables that get
+ * replaced by a block descriptor are handed back by free_table(), which moves
+ * it down again. It will reset to its initial value on stage transition, so we
+ * still need to check it for UNUSED_DESC. */
 static uint64_t *next_free_table = (void *)_ttb;
 
+/* Descriptor bits that are neither output address nor descriptor type. */
+#define DESC_ATTR_MASK (~(XLAT_ADDR_MASK | DESC_MASK))
+
 static void print_tag(int level, uint64_t tag)
 {
 	printk(level, tag & MA_MEM_NC ? "non-cacheable | " :
@@ -114,6 +118,68 @@ static uint64_t *setup_new_table(uint64_t desc, size_t xlat_size)
 	return next_free_table;
 }
 
+/* Func : free_table
+ * Desc : Return a table whose entries each map xlat_size bytes to the pool,
+ * together with any next level tables it points to.
+ */
+static void free_table(uint64_t *table, size_t xlat_size)
+{
+	int i;
+
+	assert((u8 *)table != _ttb);
+
+	/* L3 entries are pages, even though they look like table descs. */
+	if (xlat_size > L3_XLAT_SIZE) {
+		for (i = 0; i < GRANULE_SIZE/sizeof(*table); i++) {
+			if ((table[i] & DESC_MASK) == TABLE_DESC)
+				free_table((uint64_t *)(table[i] &
+							XLAT_ADDR_MASK),
+					   xlat_size >> BITS_RESOLVED_PER_LVL);
+		}
+	}
+
+	table[0] = UNUSED_DESC;
+	if (table < next_free_table)
+		next_free_table = table;
+}
+
+/* Func : write_desc
+ * Desc : Replace a descriptor. While the MMU is on, a valid entry has to be
+ * invalidated and flushed from the TLBs before anything else is written to it
+ * (break-before-make), or the old and the new translation might both be used.
+ */
+static void write_desc(uint64_t *ptr, uint64_t desc)
+{
+	uint64_t old = *ptr;
+
+	if (old == desc)
+		return;
+
+	if ((old & BLOCK_DESC) && (raw_read_sctlr_el3() & SCTLR_M)) {
+		*ptr = INVALID_DESC;
+		dsb();
+		tlbiall_current();
+		dsb();
+		isb();
+	}
+
+	*ptr = desc;
+}
+
+/* Func : set_block_desc
+ * Desc : Store a block descriptor, releasing the table it replaces (if any).
+ * The table is only reused once no TLB entry can refer to it anymore.
+ */
+static void set_block_desc(uint64_t *ptr, uint64_t desc, size_t xlat_size)
+{
+	uint64_t old = *ptr;
+
+	write_desc(ptr, desc);
+	if (xlat_size > L3_XLAT_SIZE && (old & DESC_MASK) == TABLE_DESC)
+		free_table((uint64_t *)(old & XLAT_ADDR_MASK),
+			   xlat_size >> BITS_RESOLVED_PER_LVL);
+}
+
 /* Func: get_next_level_table
  * Desc: Check if the table entry is a valid descriptor. If not, initialize new
  * table, update the entry and return the table addr. If valid, return the addr
@@ -125,7 +191,7 @@ static uint64_t *get_next_level_table(uint64_t *ptr, size_t xlat_size)
 	if ((desc & DESC_MASK) != TABLE_DESC) {
 		uint64_t *new_table = setup_new_table(desc, xlat_size);
 		desc = ((uint64_t)new_table) | TABLE_DESC;
-		*ptr = desc;
+		write_desc(ptr, desc);
 	}
 	return (uint64_t *)(desc & XLAT_ADDR_MASK);
 }
@@ -158,7 +224,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 			 * or equal to size addressed by each L1 entry, we can
 			 * directly store a block desc */
 			desc = base_addr | BLOCK_DESC | attr;
-			table[l1_index] = desc;
+			set_block_desc(&table[l1_index], desc, L1_XLAT_SIZE);
 			/* L2 lookup is not required */
 			return L1_XLAT_SIZE;
 		}
@@ -174,7 +240,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 		 * or equal to size addressed by each L2 entry, we can
 		 * directly store a block desc */
 		desc = base_addr | BLOCK_DESC | attr;
-		table[l2_index] = desc;
+		set_block_desc(&table[l2_index], desc, L2_XLAT_SIZE);
 		/* L3 lookup is not required */
 		return L2_XLAT_SIZE;
 	}
@@ -184,7 +250,7 @@ static uint64_t init_xlat_table(uint64_t base_addr,
 
 	/* L3 table lookup */
 	desc = base_addr | PAGE_DESC | attr;
-	table[l3_index] = desc;
+	write_desc(&table[l3_index], desc);
 	return L3_XLAT_SIZE;
 }
 
@@ -218,11 +284,105 @@ static uint64_t get_pte(void *addr)
 	}
 }
 
+/* Func : merge_table
+ * Desc : If the table *ptr points to (entries mapping xlat_size bytes each)
+ * maps one contiguous range with identical attributes, or nothing at all,
+ * replace it with a single block (or invalid) descriptor and free it.
+ */
+static void merge_table(uint64_t *ptr, size_t xlat_size)
+{
+	uint64_t *table;
+	uint64_t first;
+	int i;
+
+	if ((*ptr & DESC_MASK) != TABLE_DESC)
+		return;
+
+	table = (uint64_t *)(*ptr & XLAT_ADDR_MASK);
+	first = table[0];
+
+	if (first == INVALID_DESC) {
+		for (i = 1; i < GRANULE_SIZE/sizeof(*table); i++)
+			if (table[i] != INVALID_DESC)
+				return;
+		set_block_desc(ptr, INVALID_DESC, xlat_size <<
+			       BITS_RESOLVED_PER_LVL);
+		return;
+	}
+
+	/* Next level tables must have been merged already. */
+	if (xlat_size > L3_XLAT_SIZE && (first & DESC_MASK) == TABLE_DESC)
+		return;
+	if (!IS_ALIGNED(first & XLAT_ADDR_MASK,
+			xlat_size << BITS_RESOLVED_PER_LVL))
+		return;
+
+	for (i = 1; i < GRANULE_SIZE/sizeof(*table); i++)
+		if (table[i] != first + i * xlat_size)
+			return;
+
+	set_block_desc(ptr, (first & ~DESC_MASK) | BLOCK_DESC,
+		       xlat_size << BITS_RESOLVED_PER_LVL);
+}
+
+/* Func : merge_range
+ * Desc : Fold every table touched by [base, base + size) back into a block
+ * descriptor where possible, bottom up (L3 into L2, then L2 into L1).
+ */
+static void merge_range(uint64_t base, uint64_t size)
+{
+	uint64_t *l1 = (uint64_t *)_ttb;
+	uint64_t *l2;
+	uint64_t addr, end = base + size;
+
+	if (BITS_PER_VA <= L1_ADDR_SHIFT) {
+		for (addr = ALIGN_DOWN(base, L2_XLAT_SIZE); addr < end;
+		     addr += L2_XLAT_SIZE)
+			merge_table(&l1[(addr & L2_ADDR_MASK) >> L2_ADDR_SHIFT],
+				    L3_XLAT_SIZE);
+		return;
+	}
+
+	for (addr = ALIGN_DOWN(base, L1_XLAT_SIZE); addr < end;
+	     addr += L1_XLAT_SIZE) {
+		uint64_t *l1e = &l1[(addr & L1_ADDR_MASK) >> L1_ADDR_SHIFT];
+		uint64_t l2_addr;
+
+		if ((*l1e & DESC_MASK) != TABLE_DESC)
+			continue;
+
+		l2 = (uint64_t *)(*l1e & XLAT_ADDR_MASK);
+		for (l2_addr = MAX(addr, ALIGN_DOWN(base, L2_XLAT_SIZE));
+		     l2_addr < MIN(end, addr + L1_XLAT_SIZE);
+		     l2_addr += L2_XLAT_SIZE)
+			merge_table(&l2[(l2_addr & L2_ADDR_MASK) >>
+					L2_ADDR_SHIFT], L3_XLAT_SIZE);
+
+		merge_table(l1e, L2_XLAT_SIZE);
+	}
+}
+
+/* Func : tables_used
+ * Desc : Count the translation tables currently allocated in the TTB.
+ */
+static size_t tables_used(void)
+{
+	uint64_t *table = (uint64_t *)_ttb;
+	size_t count = 0;
+
+	for (; _ettb - (u8 *)table > 0; table += GRANULE_SIZE/sizeof(*table))
+		if (table[0] != UNUSED_DESC)
+			count++;
+
+	return count;
+}
+
 /* Func : mmu_config_range
  * Desc : This function repeatedly calls init_xlat_table with the base
  * address. Based on size returned from init_xlat_table, base_addr is updated
  * and subsequent calls are made for initializing the xlat table until the whole
- * region is initialized.
+ * region is initialized. Tables that end up describing a uniform range are
+ * then merged back into larger blocks.
  */
 void mmu_config_range(void *start, size_t size, uint64_t tag)
 {
@@ -239,6 +399,8 @@ void mmu_config_range(void *start, size_t size, uint64_t tag)
 		temp_size -= init_xlat_table(base_addr + (size - temp_size),
 					     temp_size, tag);
 
+	merge_range(base_addr, size);
+
 	/* ARMv8 MMUs snoop L1 data cache, no need to flush it. */
 	dsb();
 	tlbiall_current();
@@ -281,6 +443,9 @@ void mmu_enable(void)
 	    != BLOCK_INDEX_MEM_NORMAL)
 		die("TTB memory type must match TCR (normal, cacheable)!");
 
+	printk(BIOS_DEBUG, "MMU: %zu of %zu page tables in use\n",
+	       tables_used(), (size_t)_ttb_size / GRANULE_SIZE);
+
 	uint32_t sctlr = raw_read_sctlr_el3();
 	sctlr |= SCTLR_C | SCTLR_M | SCTLR_I;
 	raw_write_sctlr_el3(sctlr);
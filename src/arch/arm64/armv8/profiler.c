@@ -0,0 +1,92 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/barrier.h>
+#include <arch/exception.h>
+#include <arch/lib_helpers.h>
+#include <gic.h>
+#include <profiler.h>
+#include <stdint.h>
+
+/*
+ * The secure physical timer of the generic timer drives the sampling. Its
+ * private interrupt is routed as a Group 1 IRQ by gic_init(), which is taken
+ * at EL3 once SCR_EL3.IRQ is set.
+ */
+
+#define CNTPS_PPI		29
+#define CNT_CTL_ENABLE		(1 << 0)
+#define CNT_CTL_IMASK		(1 << 1)
+#define GICC_IAR_ID(iar)	((iar) & 0x3ff)
+
+static uint32_t interval_ticks;
+static uint32_t saved_scr;
+
+static int profiler_irq(struct exc_state *state, uint64_t vector_id)
+{
+	uint32_t iar = gic_irq_ack();
+
+	if (GICC_IAR_ID(iar) != CNTPS_PPI) {
+		gic_irq_eoi(iar);
+		return EXC_RET_IGNORED;
+	}
+
+	/* Rearm first so the time spent here isn't added to the interval. */
+	raw_write_cntps_tval_el1(interval_ticks);
+	profiler_add_sample(state->elx.elr);
+	gic_irq_eoi(iar);
+
+	return EXC_RET_HANDLED;
+}
+
+static struct exception_handler irq_sp0 = { .handler = &profiler_irq };
+static struct exception_handler irq_spx = { .handler = &profiler_irq };
+
+int arch_profiler_start(unsigned int interval_us)
+{
+	if (get_current_el() != EL3)
+		return -1;
+
+	interval_ticks = (uint64_t)raw_read_cntfrq_el0() * interval_us /
+		1000000;
+	if (!interval_ticks)
+		interval_ticks = 1;
+
+	exception_handler_register(EXC_VID_CUR_SP_EL0_IRQ, &irq_sp0);
+	exception_handler_register(EXC_VID_CUR_SP_ELX_IRQ, &irq_spx);
+
+	gic_init();
+	gic_irq_enable(CNTPS_PPI);
+
+	raw_write_cntps_tval_el1(interval_ticks);
+	raw_write_cntps_ctl_el1(CNT_CTL_ENABLE);
+
+	saved_scr = raw_read_scr_el3();
+	raw_write_scr_el3(saved_scr | SCR_IRQ_ENABLE);
+	isb();
+	enable_irq();
+
+	return 0;
+}
+
+void arch_profiler_stop(void)
+{
+	disable_irq();
+	raw_write_cntps_ctl_el1(CNT_CTL_IMASK);
+	gic_irq_disable(CNTPS_PPI);
+	raw_write_scr_el3(saved_scr);
+	isb();
+
+	exception_handler_unregister(EXC_VID_CUR_SP_EL0_IRQ, &irq_sp0);
+	exception_handler_unregister(EXC_VID_CUR_SP_ELX_IRQ, &irq_spx);
+}
@@ -0,0 +1,248 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/lib_helpers.h>
+#include <commonlib/endian.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <string.h>
+#include <vb2_api.h>
+
+#define SHA_CE_BLOCK_SIZE	64
+
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data, size_t blocks);
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 size_t blocks);
+
+static const uint32_t sha1_init[5] = {
+	0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0,
+};
+
+static const uint32_t sha256_init[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/* vboot only ever runs one hwcrypto digest at a time. */
+static struct {
+	enum vb2_hash_algorithm alg;
+	uint32_t state[8];
+	uint8_t buf[SHA_CE_BLOCK_SIZE];
+	size_t buf_used;
+	uint64_t total;
+} sha_ce;
+
+static int sha_ce_supported(enum vb2_hash_algorithm alg)
+{
+	uint64_t isar0 = raw_read_aa64isar0_el1();
+
+	switch (alg) {
+	case VB2_HASH_SHA1:
+		return (isar0 >> ID_AA64ISAR0_SHA1_SHIFT) &
+			ID_AA64ISAR0_FIELD_MASK;
+	case VB2_HASH_SHA256:
+		return (isar0 >> ID_AA64ISAR0_SHA2_SHIFT) &
+			ID_AA64ISAR0_FIELD_MASK;
+	default:
+		return 0;
+	}
+}
+
+/* FIPS 180-2 appendix A and B vectors. */
+static const struct {
+	const char *msg;
+	uint8_t sha1[VB2_SHA1_DIGEST_SIZE];
+	uint8_t sha256[VB2_SHA256_DIGEST_SIZE];
+} sha_ce_kats[] = {
+	{
+		"abc",
+		{ 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+		  0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+		{ 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+		  0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+		  0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+		  0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+	},
+	{
+		"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+		{ 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+		  0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+		{ 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+		  0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+		  0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+		  0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+	},
+};
+
+static void sha_ce_blocks(const uint8_t *data, size_t blocks)
+{
+	if (sha_ce.alg == VB2_HASH_SHA1)
+		sha1_ce_transform(sha_ce.state, data, blocks);
+	else
+		sha256_ce_transform(sha_ce.state, data, blocks);
+}
+
+static void sha_ce_start(enum vb2_hash_algorithm hash_alg)
+{
+	sha_ce.alg = hash_alg;
+	sha_ce.buf_used = 0;
+	sha_ce.total = 0;
+	if (hash_alg == VB2_HASH_SHA1)
+		memcpy(sha_ce.state, sha1_init, sizeof(sha1_init));
+	else
+		memcpy(sha_ce.state, sha256_init, sizeof(sha256_init));
+}
+
+/*
+ * Check the CE path against the known answers, then against vboot's C code
+ * on a buffer that is split across a partial block, whole blocks and a
+ * tail. Returns 0 on success.
+ */
+static int sha_ce_self_test(enum vb2_hash_algorithm hash_alg)
+{
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	uint8_t expect[VB2_SHA256_DIGEST_SIZE];
+	uint8_t pattern[3 * SHA_CE_BLOCK_SIZE + 13];
+	size_t size, i;
+
+	if (hash_alg == VB2_HASH_SHA1)
+		size = VB2_SHA1_DIGEST_SIZE;
+	else
+		size = VB2_SHA256_DIGEST_SIZE;
+
+	for (i = 0; i < ARRAY_SIZE(sha_ce_kats); i++) {
+		sha_ce_start(hash_alg);
+		vb2ex_hwcrypto_digest_extend((const uint8_t *)sha_ce_kats[i].msg,
+					     strlen(sha_ce_kats[i].msg));
+		vb2ex_hwcrypto_digest_finalize(digest, sizeof(digest));
+		if (memcmp(digest, hash_alg == VB2_HASH_SHA1 ?
+			   sha_ce_kats[i].sha1 : sha_ce_kats[i].sha256, size))
+			return -1;
+	}
+
+	for (i = 0; i < sizeof(pattern); i++)
+		pattern[i] = i * 7 + 1;
+
+	sha_ce_start(hash_alg);
+	vb2ex_hwcrypto_digest_extend(pattern, 5);
+	vb2ex_hwcrypto_digest_extend(pattern + 5, sizeof(pattern) - 5);
+	vb2ex_hwcrypto_digest_finalize(digest, sizeof(digest));
+	if (vb2_digest_buffer(pattern, sizeof(pattern), hash_alg, expect,
+			      size) != VB2_SUCCESS)
+		return -1;
+
+	return memcmp(digest, expect, size) ? -1 : 0;
+}
+
+/* Run the self-test once per algorithm and stage. */
+static int sha_ce_working(enum vb2_hash_algorithm hash_alg)
+{
+	static int sha1_ok = -1, sha256_ok = -1;
+	int *ok = hash_alg == VB2_HASH_SHA1 ? &sha1_ok : &sha256_ok;
+
+	if (*ok < 0) {
+		*ok = !sha_ce_self_test(hash_alg);
+		if (!*ok)
+			printk(BIOS_ERR, "SHA CE: %s self-test failed, "
+			       "using the C code.\n",
+			       hash_alg == VB2_HASH_SHA1 ? "SHA-1" : "SHA-256");
+	}
+	return *ok;
+}
+
+int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
+			       uint32_t data_size)
+{
+	if (!sha_ce_supported(hash_alg))
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	/* SIMD instructions must not trap while coreboot runs at EL3. */
+	if (get_current_el() == EL3)
+		raw_write_cptr_el3(raw_read_cptr_el3() & ~CPTR_EL3_TFP_ENABLE);
+
+	if (IS_ENABLED(CONFIG_ARMV8_SHA_CE_SELF_TEST) &&
+	    !sha_ce_working(hash_alg))
+		return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+
+	sha_ce_start(hash_alg);
+
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size)
+{
+	uint8_t *pending = sha_ce.buf;
+	size_t used = sha_ce.buf_used;
+	size_t blocks;
+
+	sha_ce.total += size;
+
+	/* Complete a partially filled block first. */
+	if (used) {
+		size_t fill = MIN(SHA_CE_BLOCK_SIZE - used, size);
+
+		memcpy(pending + used, buf, fill);
+		used += fill;
+		buf += fill;
+		size -= fill;
+		if (used < SHA_CE_BLOCK_SIZE) {
+			sha_ce.buf_used = used;
+			return VB2_SUCCESS;
+		}
+		sha_ce_blocks(pending, 1);
+	}
+
+	/* Hash whole blocks straight from the caller's buffer. */
+	blocks = size / SHA_CE_BLOCK_SIZE;
+	if (blocks)
+		sha_ce_blocks(buf, blocks);
+
+	used = size % SHA_CE_BLOCK_SIZE;
+	memcpy(pending, buf + blocks * SHA_CE_BLOCK_SIZE, used);
+	sha_ce.buf_used = used;
+
+	return VB2_SUCCESS;
+}
+
+int vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size)
+{
+	uint8_t *pending = sha_ce.buf;
+	size_t used = sha_ce.buf_used;
+	size_t words;
+	int i;
+
+	if (sha_ce.alg == VB2_HASH_SHA1)
+		words = 5;
+	else
+		words = 8;
+
+	if (digest_size < words * sizeof(uint32_t))
+		return VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE;
+
+	/* Append the 0x80 terminator and the bit length in big endian. */
+	pending[used++] = 0x80;
+	if (used > SHA_CE_BLOCK_SIZE - sizeof(uint64_t)) {
+		memset(pending + used, 0, SHA_CE_BLOCK_SIZE - used);
+		sha_ce_blocks(pending, 1);
+		used = 0;
+	}
+	memset(pending + used, 0, SHA_CE_BLOCK_SIZE - used);
+	write_be64(pending + SHA_CE_BLOCK_SIZE - sizeof(uint64_t),
+		   sha_ce.total * 8);
+	sha_ce_blocks(pending, 1);
+
+	for (i = 0; i < words; i++)
+		write_be32(digest + i * sizeof(uint32_t), sha_ce.state[i]);
+
+	return VB2_SUCCESS;
+}
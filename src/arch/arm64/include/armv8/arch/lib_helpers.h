@@ -46,7 +46,7 @@
 #define SCR_NS_DISABLE       (0 << SCR_NS_SHIFT)
 #define SCR_NS               SCR_NS_ENABLE
 #define SCR_RES1             (0x3 << 4)
-#define SCR_IRQ_SHIFT        2
+#define SCR_IRQ_SHIFT        1
 #define SCR_IRQ_MASK         (1 << SCR_IRQ_SHIFT)
 #define SCR_IRQ_ENABLE       (1 << SCR_IRQ_SHIFT)
 #define SCR_IRQ_DISABLE      (0 << SCR_IRQ_SHIFT)
@@ -124,6 +124,10 @@
 #define CPTR_EL3_TFP_DISABLE	(0 << CPTR_EL3_TFP_SHIFT)
 #define CPTR_EL3_TFP_ENABLE	(1 << CPTR_EL3_TFP_SHIFT)
 
+#define ID_AA64ISAR0_SHA1_SHIFT	(8)
+#define ID_AA64ISAR0_SHA2_SHIFT	(12)
+#define ID_AA64ISAR0_FIELD_MASK	(0xf)
+
 #define CPACR_TTA_SHIFT	(28)
 #define CPACR_TTA_ENABLE	(1 << CPACR_TTA_SHIFT)
 #define CPACR_TTA_DISABLE	(0 << CPACR_TTA_SHIFT)
@@ -479,6 +483,7 @@ void raw_write_far(uint64_t far, uint32_t el);
 uint64_t raw_read_hcr_el2(void);
 void raw_write_hcr_el2(uint64_t hcr_el2);
 uint64_t raw_read_aa64pfr0_el1(void);
+uint64_t raw_read_aa64isar0_el1(void);
 uint64_t raw_read_mair_el1(void);
 void raw_write_mair_el1(uint64_t mair_el1);
 uint64_t raw_read_mair_el2(void);
@@ -557,6 +562,9 @@ uint64_t raw_read_vbar(uint32_t el);
 void raw_write_vbar(uint64_t vbar, uint32_t el);
 uint32_t raw_read_cntfrq_el0(void);
 void raw_write_cntfrq_el0(uint32_t cntfrq_el0);
+uint32_t raw_read_cntps_ctl_el1(void);
+void raw_write_cntps_ctl_el1(uint32_t cntps_ctl_el1);
+void raw_write_cntps_tval_el1(uint32_t cntps_tval_el1);
 
 /* Cache maintenance system instructions */
 void dccisw(uint64_t cisw);
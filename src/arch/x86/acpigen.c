@@ -40,9 +40,11 @@ void acpigen_write_len_f(void)
 {
 	ASSERT(ltop < (ACPIGEN_LENSTACK_SIZE - 1))
 	len_stack[ltop++] = gencurrent;
-	acpigen_emit_byte(0);
-	acpigen_emit_byte(0);
-	acpigen_emit_byte(0);
+	/* Filled in by acpigen_pop_len() */
+	gencurrent[0] = 0;
+	gencurrent[1] = 0;
+	gencurrent[2] = 0;
+	gencurrent += 3;
 }
 
 void acpigen_pop_len(void)
@@ -69,6 +71,39 @@ char *acpigen_get_current(void)
 	return gencurrent;
 }
 
+/*
+ * A blob records the AML emitted between acpigen_blob_begin() and
+ * acpigen_blob_end() so that identical objects, like the _CST of every
+ * core, are generated once and copied afterwards. The recorded bytes stay
+ * where they were emitted, so a blob can only be replayed into the table
+ * it was recorded in. It has to cover complete objects: any length opened
+ * inside it must be closed inside it as well.
+ */
+void acpigen_blob_begin(struct acpigen_blob *blob)
+{
+	blob->start = gencurrent;
+	blob->size = 0;
+	blob->depth = ltop;
+	blob->valid = 0;
+}
+
+void acpigen_blob_end(struct acpigen_blob *blob)
+{
+	ASSERT(blob->depth == ltop)
+	if (blob->depth != ltop)
+		return;
+	blob->size = gencurrent - blob->start;
+	blob->valid = 1;
+}
+
+int acpigen_blob_emit(const struct acpigen_blob *blob)
+{
+	if (!blob->valid)
+		return -1;
+	acpigen_emit_stream(blob->start, blob->size);
+	return 0;
+}
+
 void acpigen_emit_byte(unsigned char b)
 {
 	(*gencurrent++) = b;
@@ -82,16 +117,18 @@ void acpigen_emit_ext_op(uint8_t op)
 
 void acpigen_emit_word(unsigned int data)
 {
-	acpigen_emit_byte(data & 0xff);
-	acpigen_emit_byte((data >> 8) & 0xff);
+	gencurrent[0] = data & 0xff;
+	gencurrent[1] = (data >> 8) & 0xff;
+	gencurrent += 2;
 }
 
 void acpigen_emit_dword(unsigned int data)
 {
-	acpigen_emit_byte(data & 0xff);
-	acpigen_emit_byte((data >> 8) & 0xff);
-	acpigen_emit_byte((data >> 16) & 0xff);
-	acpigen_emit_byte((data >> 24) & 0xff);
+	gencurrent[0] = data & 0xff;
+	gencurrent[1] = (data >> 8) & 0xff;
+	gencurrent[2] = (data >> 16) & 0xff;
+	gencurrent[3] = (data >> 24) & 0xff;
+	gencurrent += 4;
 }
 
 char *acpigen_write_package(int nr_el)
@@ -204,9 +241,10 @@ void acpigen_write_name_string(const char *name, const char *string)
 
 void acpigen_emit_stream(const char *data, int size)
 {
-	int i;
-	for (i = 0; i < size; i++)
-		acpigen_emit_byte(data[i]);
+	if (size <= 0)
+		return;
+	memcpy(gencurrent, data, size);
+	gencurrent += size;
 }
 
 void acpigen_emit_string(const char *string)
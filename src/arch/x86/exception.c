@@ -382,11 +382,16 @@ static void put_packet(char *buffer)
 #endif /* CONFIG_GDB_STUB */
 
 #include <arch/registers.h>
+#include <profiler.h>
 
 void x86_exception(struct eregs *info);
 
 void x86_exception(struct eregs *info)
 {
+	/* The sampling profiler raises NMIs. */
+	if (info->vector == 2 && profiler_handle_nmi(info->eip))
+		return;
+
 #if IS_ENABLED(CONFIG_GDB_STUB)
 	int signo;
 	memcpy(gdb_stub_registers, info, 8*sizeof(uint32_t));
@@ -166,12 +166,23 @@ struct dsm_uuid {
 	void *arg;
 };
 
+/* AML recorded once and emitted again, see acpigen_blob_begin() */
+struct acpigen_blob {
+	const char *start;
+	size_t size;
+	int depth;
+	int valid;
+};
+
 void acpigen_write_return_integer(uint64_t arg);
 void acpigen_write_return_string(const char *arg);
 void acpigen_write_len_f(void);
 void acpigen_pop_len(void);
 void acpigen_set_current(char *curr);
 char *acpigen_get_current(void);
+void acpigen_blob_begin(struct acpigen_blob *blob);
+void acpigen_blob_end(struct acpigen_blob *blob);
+int acpigen_blob_emit(const struct acpigen_blob *blob);
 char *acpigen_write_package(int nr_el);
 void acpigen_write_zero(void);
 void acpigen_write_one(void);
@@ -22,6 +22,7 @@
 #include <program_loading.h>
 #include <rmodule.h>
 #include <romstage_handoff.h>
+#include <stage_usage.h>
 #include <stage_cache.h>
 
 static inline void stack_push(struct postcar_frame *pcf, uint32_t val)
@@ -171,5 +172,8 @@ void run_postcar_phase(struct postcar_frame *pcf)
 	} else
 		load_postcar_cbfs(&prog, pcf);
 
+	/* Last point in romstage where cache-as-RAM is still up. */
+	stage_usage_record();
+
 	prog_run(&prog);
 }
@@ -46,6 +46,7 @@ int smbios_add_string(u8 *start, const char *str)
 {
 	int i = 1;
 	char *p = (char *)start;
+	const char *s;
 
 	/*
 	 * Return 0 as required for empty strings.
@@ -63,7 +64,10 @@ int smbios_add_string(u8 *start, const char *str)
 			return i;
 		}
 
-		if (!strcmp(p, str))
+		/* Compare and skip the string in the same pass. */
+		for (s = str; *s && *p == *s; p++, s++)
+			;
+		if (*p == *s)
 			return i;
 
 		p += strlen(p)+1;
@@ -370,3 +370,64 @@ int cbfs_vb2_hash_contents(const struct region_device *cbfs,
 
 	return vb2_digest_finalize(&ctx, digest, digest_sz);
 }
+
+int cbfsf_hash_start(struct cbfsf_hash *hash, const struct cbfsf *fh)
+{
+	size_t metadata_size = region_device_sz(&fh->metadata);
+	void *metadata = rdev_mmap_full(&fh->metadata);
+	size_t offs = 0;
+	int rv = -1;
+
+	if (!metadata)
+		return -1;
+
+	while ((offs = cbfs_for_each_attr(metadata, metadata_size, offs))) {
+		struct cbfs_file_attr_hash *attr = metadata + offs;
+		enum vb2_hash_algorithm hash_alg;
+		int digest_sz;
+
+		if (read_be32(&attr->tag) != CBFS_FILE_ATTR_TAG_HASH)
+			continue;
+
+		hash_alg = read_be32(&attr->hash_type);
+		digest_sz = vb2_digest_size(hash_alg);
+		if (digest_sz <= 0 || digest_sz > sizeof(hash->digest) ||
+		    offs + sizeof(*attr) + digest_sz > metadata_size)
+			break;
+
+		if (vb2_digest_init(&hash->ctx, hash_alg))
+			break;
+
+		memcpy(hash->digest, attr->hash_data, digest_sz);
+		hash->digest_sz = digest_sz;
+		rv = 0;
+		break;
+	}
+
+	if (!offs)
+		ERROR("No hash attribute for file @ %zx\n",
+			region_device_offset(&fh->metadata));
+
+	rdev_munmap(&fh->metadata, metadata);
+	return rv;
+}
+
+int cbfsf_hash_extend(struct cbfsf_hash *hash, const void *data, size_t size)
+{
+	return vb2_digest_extend(&hash->ctx, data, size);
+}
+
+int cbfsf_hash_finish(struct cbfsf_hash *hash)
+{
+	uint8_t digest[VB2_SHA512_DIGEST_SIZE];
+
+	if (vb2_digest_finalize(&hash->ctx, digest, hash->digest_sz))
+		return -1;
+
+	if (memcmp(digest, hash->digest, hash->digest_sz)) {
+		ERROR("Hash mismatch\n");
+		return -1;
+	}
+
+	return 0;
+}
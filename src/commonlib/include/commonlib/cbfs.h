@@ -79,4 +79,23 @@ int cbfs_vb2_hash_contents(const struct region_device *cbfs,
 				enum vb2_hash_algorithm hash_alg, void *digest,
 				size_t digest_sz);
 
+/* State of checking a CBFS file's data against its hash attribute. */
+struct cbfsf_hash {
+	struct vb2_digest_context ctx;
+	uint8_t digest[VB2_SHA512_DIGEST_SIZE];	/* expected */
+	size_t digest_sz;
+};
+
+/*
+ * Check the data of a CBFS file against the digest recorded in its
+ * CBFS_FILE_ATTR_TAG_HASH attribute while it is being read: start with
+ * cbfsf_hash_start(), pass all of the data in order to cbfsf_hash_extend()
+ * and compare with cbfsf_hash_finish(). All return 0 on success.
+ * cbfsf_hash_start() fails if the file carries no usable hash attribute,
+ * cbfsf_hash_finish() if the data did not match.
+ */
+int cbfsf_hash_start(struct cbfsf_hash *hash, const struct cbfsf *fh);
+int cbfsf_hash_extend(struct cbfsf_hash *hash, const void *data, size_t size);
+int cbfsf_hash_finish(struct cbfsf_hash *hash);
+
 #endif
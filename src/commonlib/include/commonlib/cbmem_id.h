@@ -28,6 +28,7 @@
 #define CBMEM_ID_CBTABLE_FWD	0x43425443
 #define CBMEM_ID_CONSOLE	0x434f4e53
 #define CBMEM_ID_COVERAGE	0x47434f56
+#define CBMEM_ID_CPU_MICROCODE	0x55434f44
 #define CBMEM_ID_EHCI_DEBUG	0xe4c1deb9
 #define CBMEM_ID_ELOG		0x454c4f47
 #define CBMEM_ID_FREESPACE	0x46524545
@@ -44,14 +45,17 @@
 #define CBMEM_ID_MRCDATA	0x4d524344
 #define CBMEM_ID_VAR_MRCDATA	0x4d524345
 #define CBMEM_ID_MTC		0xcb31d31c
+#define CBMEM_ID_MTRR_SOLUTION	0x4d545252
 #define CBMEM_ID_NONE		0x00000000
 #define CBMEM_ID_PIRQ		0x49525154
 #define CBMEM_ID_POWER_STATE	0x50535454
+#define CBMEM_ID_PROFILE	0x50524f46
 #define CBMEM_ID_RAM_OOPS	0x05430095
 #define CBMEM_ID_RAMSTAGE	0x9a357a9e
 #define CBMEM_ID_RAMSTAGE_CACHE	0x9a3ca54e
 #define CBMEM_ID_REFCODE	0x04efc0de
 #define CBMEM_ID_REFCODE_CACHE	0x4efc0de5
+#define CBMEM_ID_REGF_HINTS	0x52474648
 #define CBMEM_ID_RESUME		0x5245534d
 #define CBMEM_ID_RESUME_SCRATCH	0x52455343
 #define CBMEM_ID_ROMSTAGE_INFO	0x47545352
@@ -62,9 +66,11 @@
 #define CBMEM_ID_STAGEx_META	0x57a9e000
 #define CBMEM_ID_STAGEx_CACHE	0x57a9e100
 #define CBMEM_ID_STAGEx_RAW	0x57a9e200
+#define CBMEM_ID_STAGE_USAGE	0x53545553
 #define CBMEM_ID_STORAGE_DATA	0x53746f72
 #define CBMEM_ID_TCPA_LOG	0x54435041
 #define CBMEM_ID_TIMESTAMP	0x54494d45
+#define CBMEM_ID_TIMESTAMP_SPANS 0x5453504e
 #define CBMEM_ID_VBOOT_HANDOFF	0x780074f0
 #define CBMEM_ID_VBOOT_SEL_REG	0x780074f1
 #define CBMEM_ID_VBOOT_WORKBUF	0x78007343
@@ -89,6 +95,7 @@
 	{ CBMEM_ID_CBTABLE_FWD,		"COREBOOTFWD" }, \
 	{ CBMEM_ID_CONSOLE,		"CONSOLE    " }, \
 	{ CBMEM_ID_COVERAGE,		"COVERAGE   " }, \
+	{ CBMEM_ID_CPU_MICROCODE,	"MICROCODE  " }, \
 	{ CBMEM_ID_EHCI_DEBUG,		"USBDEBUG   " }, \
 	{ CBMEM_ID_ELOG,		"ELOG       " }, \
 	{ CBMEM_ID_FREESPACE,		"FREE SPACE " }, \
@@ -104,12 +111,15 @@
 	{ CBMEM_ID_MRCDATA,		"MRC DATA   " }, \
 	{ CBMEM_ID_VAR_MRCDATA,		"VARMRC DATA" }, \
 	{ CBMEM_ID_MTC,			"MTC        " }, \
+	{ CBMEM_ID_MTRR_SOLUTION,	"MTRR SOL   " }, \
 	{ CBMEM_ID_PIRQ,		"IRQ TABLE  " }, \
 	{ CBMEM_ID_POWER_STATE,		"POWER STATE" }, \
+	{ CBMEM_ID_PROFILE,		"PROFILE    " }, \
 	{ CBMEM_ID_RAM_OOPS,		"RAMOOPS    " }, \
 	{ CBMEM_ID_RAMSTAGE_CACHE,	"RAMSTAGE $ " }, \
 	{ CBMEM_ID_RAMSTAGE,		"RAMSTAGE   " }, \
 	{ CBMEM_ID_REFCODE_CACHE,	"REFCODE $  " }, \
+	{ CBMEM_ID_REGF_HINTS,		"REGF HINTS " }, \
 	{ CBMEM_ID_REFCODE,		"REFCODE    " }, \
 	{ CBMEM_ID_RESUME,		"ACPI RESUME" }, \
 	{ CBMEM_ID_RESUME_SCRATCH,	"ACPISCRATCH" }, \
@@ -118,9 +128,11 @@
 	{ CBMEM_ID_ROOT,		"CBMEM ROOT " }, \
 	{ CBMEM_ID_SMBIOS,		"SMBIOS     " }, \
 	{ CBMEM_ID_SMM_SAVE_SPACE,	"SMM BACKUP " }, \
+	{ CBMEM_ID_STAGE_USAGE,		"STAGE USAGE" }, \
 	{ CBMEM_ID_STORAGE_DATA,	"SD/MMC/eMMC" }, \
 	{ CBMEM_ID_TCPA_LOG,		"TCPA LOG   " }, \
 	{ CBMEM_ID_TIMESTAMP,		"TIME STAMP " }, \
+	{ CBMEM_ID_TIMESTAMP_SPANS,	"TS SPANS   " }, \
 	{ CBMEM_ID_VBOOT_HANDOFF,	"VBOOT      " }, \
 	{ CBMEM_ID_VBOOT_SEL_REG,	"VBOOT SEL  " }, \
 	{ CBMEM_ID_VBOOT_WORKBUF,	"VBOOT WORK " }, \
@@ -0,0 +1,34 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __PROFILE_SERIALIZED_H__
+#define __PROFILE_SERIALIZED_H__
+
+#include <stdint.h>
+#include <compiler.h>
+
+/*
+ * Program counter samples taken by the ramstage sampling profiler. The
+ * samples are runtime addresses; subtract program_base and add the link
+ * address of _program in the stage ELF to symbolize them.
+ */
+struct profile_samples {
+	uint64_t	program_base;
+	uint32_t	interval_us;
+	uint32_t	num_samples;
+	uint32_t	dropped;	/* samples lost to a full buffer */
+	uint32_t	reserved;
+	uint64_t	samples[0];
+} __packed;
+
+#endif
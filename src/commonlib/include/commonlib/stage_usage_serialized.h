@@ -0,0 +1,54 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __STAGE_USAGE_SERIALIZED_H__
+#define __STAGE_USAGE_SERIALIZED_H__
+
+#include <stdint.h>
+#include <compiler.h>
+
+enum stage_usage_stage {
+	STAGE_USAGE_ROMSTAGE = 1,
+	STAGE_USAGE_RAMSTAGE = 2,
+};
+
+enum stage_usage_region {
+	STAGE_USAGE_STACK = 1,
+	STAGE_USAGE_HEAP = 2,
+	STAGE_USAGE_CBFS_CACHE = 3,
+	STAGE_USAGE_TIMESTAMP = 4,
+	STAGE_USAGE_CONSOLE = 5,
+	STAGE_USAGE_CAR = 6,
+};
+
+/*
+ * High-water marks of the fixed size memory regions, in bytes. Regions that
+ * are shared by all stages running before DRAM, like the cache-as-RAM stack,
+ * are recorded by romstage and include the usage of bootblock and verstage.
+ * used == size means the region ran full and may have overflowed.
+ */
+struct stage_usage_entry {
+	uint8_t		stage;
+	uint8_t		region;
+	uint16_t	reserved;
+	uint32_t	size;
+	uint32_t	used;
+} __packed;
+
+struct stage_usage_table {
+	uint32_t	max_entries;
+	uint32_t	num_entries;
+	struct stage_usage_entry entries[0];
+} __packed;
+
+#endif
@@ -32,6 +32,31 @@ struct timestamp_table {
 	struct timestamp_entry entries[0]; /* Variable number of entries */
 } __packed;
 
+enum timestamp_span_type {
+	TS_SPAN_BEGIN = 1,
+	TS_SPAN_END = 2,
+};
+
+/* Raw tick count (not relative to base_time) of a span begin or end. */
+struct timestamp_span_entry {
+	uint64_t	stamp;
+	uint16_t	id;		/* enum timestamp_id */
+	uint16_t	arg;		/* caller specific, e.g. an index */
+	uint8_t		type;		/* enum timestamp_span_type */
+	uint8_t		depth;		/* nesting level within the thread */
+	uint8_t		cpu;
+	uint8_t		thread;
+} __packed;
+
+struct timestamp_span_table {
+	uint64_t	base_time;
+	uint16_t	tick_freq_mhz;
+	uint16_t	reserved;
+	uint32_t	num_entries;
+	uint32_t	dropped;	/* events lost to full per-CPU buffers */
+	struct timestamp_span_entry entries[0];
+} __packed;
+
 enum timestamp_id {
 	TS_START_ROMSTAGE = 1,
 	TS_BEFORE_INITRAM = 2,
@@ -62,6 +87,13 @@ enum timestamp_id {
 	TS_ACPI_WAKE_JUMP = 98,
 	TS_SELFBOOT_JUMP = 99,
 
+	/* 100-199 reserved for span events */
+	TS_SPAN_BOOT_STATE = 100,
+	TS_SPAN_BS_CALLBACK = 101,
+	TS_SPAN_THREAD = 102,
+	TS_SPAN_MP_RECORD = 103,
+	TS_SPAN_MEMORY_CLEAR = 104,
+
 	/* 500+ reserved for vendorcode extensions (500-600: google/chromeos) */
 	TS_START_COPYVER = 501,
 	TS_END_COPYVER = 502,
@@ -77,6 +109,24 @@ enum timestamp_id {
 	TS_END_COPYVPD_RO = 551,
 	TS_END_COPYVPD_RW = 552,
 
+	/* 700-730 reserved for SoC extensions (700-730: NVIDIA Tegra210) */
+	TS_SDRAM_CONFIGURE_PMC = 700,
+	TS_SDRAM_SET_DPD = 701,
+	TS_SDRAM_START_CLOCKS = 702,
+	TS_SDRAM_SET_PAD_MACROS = 703,
+	TS_SDRAM_INIT_MC = 704,
+	TS_SDRAM_INIT_EMC = 705,
+	TS_SDRAM_SET_EMC_TIMING = 706,
+	TS_SDRAM_REL_DPD = 707,
+	TS_SDRAM_SET_ZQ_CALIBRATION = 708,
+	TS_SDRAM_SET_DDR_CONTROL = 709,
+	TS_SDRAM_CLOCK_ENABLE = 710,
+	TS_SDRAM_INIT_ZQ_CALIBRATION = 711,
+	TS_SDRAM_SET_REFRESH = 712,
+	TS_SDRAM_LOCK_CARVEOUTS = 713,
+	TS_START_ROM_MIRROR = 714,
+	TS_END_ROM_MIRROR = 715,
+
 	/* 900-920 reserved for vendorcode extensions (900-940: AMD AGESA) */
 	TS_AGESA_INIT_RESET_START = 900,
 	TS_AGESA_INIT_RESET_DONE = 901,
@@ -174,6 +224,12 @@ static const struct timestamp_id_to_name {
 	{ TS_ACPI_WAKE_JUMP,	"ACPI wake jump" },
 	{ TS_SELFBOOT_JUMP,	"selfboot jump" },
 
+	{ TS_SPAN_BOOT_STATE,	"boot state" },
+	{ TS_SPAN_BS_CALLBACK,	"boot state callback" },
+	{ TS_SPAN_THREAD,	"thread" },
+	{ TS_SPAN_MP_RECORD,	"MP flight record" },
+	{ TS_SPAN_MEMORY_CLEAR,	"clearing memory" },
+
 	{ TS_START_COPYVER,	"starting to load verstage" },
 	{ TS_END_COPYVER,	"finished loading verstage" },
 	{ TS_START_TPMINIT,	"starting to initialize TPM" },
@@ -203,6 +259,24 @@ static const struct timestamp_id_to_name {
 	{ TS_KERNEL_DECOMPRESSION, "starting kernel decompression/relocation" },
 	{ TS_START_KERNEL,	"jumping to kernel" },
 
+	/* NVIDIA Tegra210 SDRAM init related timestamps */
+	{ TS_SDRAM_CONFIGURE_PMC,	"SDRAM: configured PMC" },
+	{ TS_SDRAM_SET_DPD,		"SDRAM: programmed DPD" },
+	{ TS_SDRAM_START_CLOCKS,	"SDRAM: started MC/EMC clocks" },
+	{ TS_SDRAM_SET_PAD_MACROS,	"SDRAM: programmed pad macros" },
+	{ TS_SDRAM_INIT_MC,		"SDRAM: initialized MC" },
+	{ TS_SDRAM_INIT_EMC,		"SDRAM: initialized EMC" },
+	{ TS_SDRAM_SET_EMC_TIMING,	"SDRAM: programmed EMC timing" },
+	{ TS_SDRAM_REL_DPD,		"SDRAM: released DPD" },
+	{ TS_SDRAM_SET_ZQ_CALIBRATION,	"SDRAM: set up ZQ calibration" },
+	{ TS_SDRAM_SET_DDR_CONTROL,	"SDRAM: deasserted HOLD_CKE_LOW" },
+	{ TS_SDRAM_CLOCK_ENABLE,	"SDRAM: enabled CKE" },
+	{ TS_SDRAM_INIT_ZQ_CALIBRATION,	"SDRAM: initial ZQ calibration done" },
+	{ TS_SDRAM_SET_REFRESH,		"SDRAM: enabled refresh" },
+	{ TS_SDRAM_LOCK_CARVEOUTS,	"SDRAM: locked carveouts" },
+	{ TS_START_ROM_MIRROR,	"starting to mirror CBFS into SDRAM" },
+	{ TS_END_ROM_MIRROR,	"finished mirroring CBFS into SDRAM" },
+
 	/* AMD AGESA related timestamps */
 	{ TS_AGESA_INIT_RESET_START,	"calling AmdInitReset" },
 	{ TS_AGESA_INIT_RESET_DONE,	"back from AmdInitReset" },
@@ -29,6 +29,14 @@
 #include <cpu/intel/microcode.h>
 #include <rules.h>
 
+#if !defined(__ROMCC__) && (ENV_ROMSTAGE || ENV_RAMSTAGE)
+#define MICROCODE_CACHE 1
+#include <arch/early_variables.h>
+#include <cbmem.h>
+#else
+#define MICROCODE_CACHE 0
+#endif
+
 #if !defined(__PRE_RAM__)
 #include <smp/spinlock.h>
 DECLARE_SPIN_LOCK(microcode_lock)
@@ -112,14 +120,105 @@ void intel_microcode_load_unlocked(const void *microcode_patch)
 #endif
 }
 
-const void *intel_microcode_find(void)
+#if MICROCODE_CACHE
+/*
+ * The matching update is remembered, so the CBFS file is only scanned once.
+ * Romstage hands its result on to ramstage through CBMEM, where the BSP and
+ * every AP that loads microcode find it as well.
+ */
+struct microcode_cache {
+	u32 sig;
+	u32 pf;
+	u64 ptr;
+};
+
+static struct microcode_cache microcode_car_cache CAR_GLOBAL;
+
+static struct microcode_cache *microcode_cache_get(void)
+{
+	if (ENV_ROMSTAGE)
+		return car_get_var_ptr(&microcode_car_cache);
+
+	return cbmem_find(CBMEM_ID_CPU_MICROCODE);
+}
+
+/* Only updates in the memory mapped boot media stay valid across stages. */
+static int microcode_is_mapped(const struct microcode *m)
+{
+	const u64 addr = (uintptr_t)m;
+
+	return addr >= 0x100000000ULL - CONFIG_ROM_SIZE &&
+		addr < 0x100000000ULL;
+}
+
+static const struct microcode *microcode_cache_find(u32 sig, u32 pf)
+{
+	const struct microcode_cache *cache;
+	const struct microcode *m = NULL;
+
+#if ENV_RAMSTAGE
+	spin_lock(&microcode_lock);
+#endif
+	cache = microcode_cache_get();
+	if (cache != NULL && cache->ptr != 0 && cache->sig == sig &&
+	    cache->pf == pf)
+		m = (const struct microcode *)(uintptr_t)cache->ptr;
+#if ENV_RAMSTAGE
+	spin_unlock(&microcode_lock);
+#endif
+
+	/* Make sure the boot media still holds the same update. */
+	if (m != NULL && (m->sig != sig || !(m->pf & pf)))
+		return NULL;
+
+	return m;
+}
+
+static void microcode_cache_store(u32 sig, u32 pf, const struct microcode *m)
+{
+	struct microcode_cache *cache;
+
+	if (!microcode_is_mapped(m))
+		return;
+
+#if ENV_RAMSTAGE
+	spin_lock(&microcode_lock);
+#endif
+	cache = microcode_cache_get();
+	if (ENV_RAMSTAGE && cache == NULL)
+		cache = cbmem_add(CBMEM_ID_CPU_MICROCODE, sizeof(*cache));
+	if (cache != NULL) {
+		cache->sig = sig;
+		cache->pf = pf;
+		cache->ptr = (uintptr_t)m;
+	}
+#if ENV_RAMSTAGE
+	spin_unlock(&microcode_lock);
+#endif
+}
+
+static void microcode_cache_publish(int is_recovery)
+{
+	const struct microcode_cache *car_cache =
+		car_get_var_ptr(&microcode_car_cache);
+	struct microcode_cache *cache;
+
+	if (car_cache->ptr == 0)
+		return;
+
+	cache = cbmem_add(CBMEM_ID_CPU_MICROCODE, sizeof(*cache));
+	if (cache != NULL)
+		*cache = *car_cache;
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(microcode_cache_publish)
+#endif
+
+static const struct microcode *find_cbfs_microcode(u32 sig, u32 pf)
 {
 	const struct microcode *ucode_updates;
 	size_t microcode_len;
-	u32 eax;
-	u32 pf, rev, sig, update_size;
-	unsigned int x86_model, x86_family;
-	msr_t msr;
+	u32 update_size;
 
 #ifdef __ROMCC__
 	struct cbfs_file *microcode_file;
@@ -138,30 +237,6 @@ const void *intel_microcode_find(void)
 		return NULL;
 #endif
 
-	/* CPUID sets MSR 0x8B iff a microcode update has been loaded. */
-	msr.lo = 0;
-	msr.hi = 0;
-	wrmsr(0x8B, msr);
-	eax = cpuid_eax(1);
-	msr = rdmsr(0x8B);
-	rev = msr.hi;
-	x86_model = (eax >> 4) & 0x0f;
-	x86_family = (eax >> 8) & 0x0f;
-	sig = eax;
-
-	pf = 0;
-	if ((x86_model >= 5) || (x86_family > 6)) {
-		msr = rdmsr(0x17);
-		pf = 1 << ((msr.hi >> 18) & 7);
-	}
-#if !defined(__ROMCC__)
-	/* If this code is compiled with ROMCC we're probably in
-	 * the bootblock and don't have console output yet.
-	 */
-	printk(BIOS_DEBUG, "microcode: sig=0x%x pf=0x%x revision=0x%x\n",
-			sig, pf, rev);
-#endif
-
 	while (microcode_len >= sizeof(*ucode_updates)) {
 		/* Newer microcode updates include a size field, whereas older
 		 * containers set it at 0 and are exactly 2048 bytes long */
@@ -193,6 +268,54 @@ const void *intel_microcode_find(void)
 	return (void *)0;
 }
 
+const void *intel_microcode_find(void)
+{
+	const struct microcode *ucode;
+	u32 eax;
+	u32 pf, rev, sig;
+	unsigned int x86_model, x86_family;
+	msr_t msr;
+
+	/* CPUID sets MSR 0x8B iff a microcode update has been loaded. */
+	msr.lo = 0;
+	msr.hi = 0;
+	wrmsr(0x8B, msr);
+	eax = cpuid_eax(1);
+	msr = rdmsr(0x8B);
+	rev = msr.hi;
+	x86_model = (eax >> 4) & 0x0f;
+	x86_family = (eax >> 8) & 0x0f;
+	sig = eax;
+
+	pf = 0;
+	if ((x86_model >= 5) || (x86_family > 6)) {
+		msr = rdmsr(0x17);
+		pf = 1 << ((msr.hi >> 18) & 7);
+	}
+#if !defined(__ROMCC__)
+	/* If this code is compiled with ROMCC we're probably in
+	 * the bootblock and don't have console output yet.
+	 */
+	printk(BIOS_DEBUG, "microcode: sig=0x%x pf=0x%x revision=0x%x\n",
+			sig, pf, rev);
+#endif
+
+#if MICROCODE_CACHE
+	ucode = microcode_cache_find(sig, pf);
+	if (ucode != NULL)
+		return ucode;
+#endif
+
+	ucode = find_cbfs_microcode(sig, pf);
+
+#if MICROCODE_CACHE
+	if (ucode != NULL)
+		microcode_cache_store(sig, pf, ucode);
+#endif
+
+	return ucode;
+}
+
 void intel_update_microcode_from_cbfs(void)
 {
 	const void *patch = intel_microcode_find();
@@ -0,0 +1,137 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/cpu.h>
+#include <commonlib/helpers.h>
+#include <cpu/x86/lapic.h>
+#include <cpu/x86/msr.h>
+#include <cpu/x86/tsc.h>
+#include <profiler.h>
+#include <stdint.h>
+
+/*
+ * Ramstage runs with interrupts disabled, so the sampling interrupt is an NMI
+ * delivered through the local APIC performance counter LVT when general
+ * purpose counter 0, counting unhalted core cycles, overflows. Only the BSP
+ * is sampled.
+ */
+
+#define IA32_PMC0			0xc1
+#define IA32_PERFEVTSEL0		0x186
+#define  PERFEVTSEL_USR			(1 << 16)
+#define  PERFEVTSEL_OS			(1 << 17)
+#define  PERFEVTSEL_INT			(1 << 20)
+#define  PERFEVTSEL_EN			(1 << 22)
+#define  PERFEVTSEL_CORE_CYCLES		0x3c
+#define IA32_PERF_GLOBAL_STATUS		0x38e
+#define IA32_PERF_GLOBAL_CTRL		0x38f
+#define IA32_PERF_GLOBAL_OVF_CTRL	0x390
+#define  PERF_GLOBAL_PMC0		(1 << 0)
+
+/* Core frequency assumed when the TSC rate isn't known. */
+#define DEFAULT_CORE_MHZ		1000
+
+static uint32_t period;
+static unsigned int perfmon_version;
+static int running;
+
+static void pmc0_arm(void)
+{
+	msr_t msr;
+
+	/* Only the low 32 bits are written; they are sign extended. */
+	msr.lo = -period;
+	msr.hi = 0;
+	wrmsr(IA32_PMC0, msr);
+
+	/* The LVT entry gets masked on every delivery. */
+	lapic_write(LAPIC_LVTPC, LAPIC_DELIVERY_MODE_NMI);
+}
+
+int arch_profiler_start(unsigned int interval_us)
+{
+	struct cpuid_result res;
+	unsigned long mhz = 0;
+	msr_t msr;
+
+	if (cpuid_eax(0) < 0xa)
+		return -1;
+
+	/* Architectural performance monitoring with the core cycles event. */
+	res = cpuid(0xa);
+	perfmon_version = res.eax & 0xff;
+	if (perfmon_version < 1 || ((res.eax >> 8) & 0xff) < 1 ||
+	    (res.ebx & 1))
+		return -1;
+
+	if (IS_ENABLED(CONFIG_TSC_CONSTANT_RATE))
+		mhz = tsc_freq_mhz();
+	if (!mhz)
+		mhz = DEFAULT_CORE_MHZ;
+	period = MIN((uint64_t)interval_us * mhz, 0x7fffffff);
+
+	running = 1;
+	pmc0_arm();
+
+	msr.lo = PERFEVTSEL_CORE_CYCLES | PERFEVTSEL_USR | PERFEVTSEL_OS |
+		 PERFEVTSEL_INT | PERFEVTSEL_EN;
+	msr.hi = 0;
+	wrmsr(IA32_PERFEVTSEL0, msr);
+
+	if (perfmon_version >= 2) {
+		msr = rdmsr(IA32_PERF_GLOBAL_CTRL);
+		msr.lo |= PERF_GLOBAL_PMC0;
+		wrmsr(IA32_PERF_GLOBAL_CTRL, msr);
+	}
+
+	return 0;
+}
+
+void arch_profiler_stop(void)
+{
+	msr_t msr;
+
+	running = 0;
+
+	msr.lo = 0;
+	msr.hi = 0;
+	wrmsr(IA32_PERFEVTSEL0, msr);
+	lapic_write(LAPIC_LVTPC, LAPIC_LVT_MASKED | LAPIC_DELIVERY_MODE_NMI);
+}
+
+int profiler_handle_nmi(uintptr_t pc)
+{
+	msr_t msr;
+
+	if (!running)
+		return 0;
+
+	if (perfmon_version >= 2) {
+		msr = rdmsr(IA32_PERF_GLOBAL_STATUS);
+		if (!(msr.lo & PERF_GLOBAL_PMC0))
+			return 0;
+		msr.lo = PERF_GLOBAL_PMC0;
+		msr.hi = 0;
+		wrmsr(IA32_PERF_GLOBAL_OVF_CTRL, msr);
+	} else {
+		/* No overflow status; the counter only just wrapped to 0. */
+		msr = rdmsr(IA32_PMC0);
+		if ((int32_t)msr.lo < 0)
+			return 0;
+	}
+
+	profiler_add_sample(pc);
+	pmc0_arm();
+
+	return 1;
+}
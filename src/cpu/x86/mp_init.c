@@ -37,6 +37,7 @@
 #include <smp/spinlock.h>
 #include <symbols.h>
 #include <thread.h>
+#include <timestamp.h>
 
 #define MAX_APIC_IDS 256
 
@@ -207,8 +208,11 @@ static void ap_do_flight_plan(void)
 		atomic_inc(&rec->cpus_entered);
 		barrier_wait(&rec->barrier);
 
-		if (rec->ap_call != NULL)
+		if (rec->ap_call != NULL) {
+			timestamp_span_begin(TS_SPAN_MP_RECORD, i);
 			rec->ap_call();
+			timestamp_span_end(TS_SPAN_MP_RECORD, i);
+		}
 	}
 }
 
@@ -556,8 +560,11 @@ static int bsp_do_flight_plan(struct mp_params *mp_params)
 			}
 		}
 
-		if (rec->bsp_call != NULL)
+		if (rec->bsp_call != NULL) {
+			timestamp_span_begin(TS_SPAN_MP_RECORD, i);
 			rec->bsp_call();
+			timestamp_span_end(TS_SPAN_MP_RECORD, i);
+		}
 
 		release_barrier(&rec->barrier);
 	}
@@ -916,6 +923,59 @@ static int run_ap_work(mp_callback_t func, long expire_us)
 	return -1;
 }
 
+/*
+ * Each AP has a ring of job pointers. The BSP is the only producer and only
+ * moves head while the AP is the only consumer and only moves tail, so no
+ * locking is needed.
+ */
+struct mp_job_queue {
+	struct mp_job *jobs[MP_JOB_QUEUE_SIZE];
+	uint32_t head;
+	uint32_t tail;
+};
+
+static struct mp_job_queue ap_job_queues[CONFIG_MAX_CPUS];
+static int aps_parked;
+
+static uint32_t read_queue_index(uint32_t *index)
+{
+	return *(volatile uint32_t *)index;
+}
+
+static void store_queue_index(uint32_t *index, uint32_t value)
+{
+	*(volatile uint32_t *)index = value;
+}
+
+/* Run the next job queued for this AP. Returns 1 if one was run. */
+static int ap_run_job(struct mp_job_queue *q)
+{
+	uint32_t tail = q->tail;
+	struct mp_job *job;
+	int run;
+
+	if (tail == read_queue_index(&q->head))
+		return 0;
+	mfence();
+
+	job = q->jobs[tail % MP_JOB_QUEUE_SIZE];
+	/* The BSP may have taken the job back before it was picked up. */
+	run = __sync_bool_compare_and_swap(&job->state, MP_JOB_QUEUED,
+					   MP_JOB_RUNNING);
+
+	/* The slot can be reused as soon as the job has been picked up. */
+	store_queue_index(&q->tail, tail + 1);
+
+	if (!run)
+		return 1;
+
+	job->result = job->func(job->arg);
+	mfence();
+	job->state = MP_JOB_DONE;
+
+	return 1;
+}
+
 static void ap_wait_for_instruction(void)
 {
 	int cur_cpu = cpu_index();
@@ -927,7 +987,8 @@ static void ap_wait_for_instruction(void)
 		mp_callback_t func = read_callback(&ap_callbacks[cur_cpu]);
 
 		if (func == NULL) {
-			asm ("pause");
+			if (!ap_run_job(&ap_job_queues[cur_cpu]))
+				asm ("pause");
 			continue;
 		}
 
@@ -937,6 +998,141 @@ static void ap_wait_for_instruction(void)
 	}
 }
 
+int mp_get_num_aps(void)
+{
+	return global_num_aps;
+}
+
+int mp_queue_job(struct mp_job *job, int cpu, int (*func)(void *arg),
+		void *arg)
+{
+	struct mp_job_queue *q;
+	uint32_t head;
+
+	if (!IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK) || aps_parked) {
+		printk(BIOS_ERR, "APs not available to run jobs.\n");
+		return -1;
+	}
+
+	if (cpu <= 0 || cpu > global_num_aps)
+		return -1;
+
+	/* Queueing it again would put the same job into two slots. */
+	if (job->state == MP_JOB_QUEUED || job->state == MP_JOB_RUNNING) {
+		printk(BIOS_ERR, "AP job is still in use.\n");
+		return -1;
+	}
+
+	q = &ap_job_queues[cpu];
+	head = q->head;
+
+	if (head - read_queue_index(&q->tail) >= MP_JOB_QUEUE_SIZE)
+		return -1;
+
+	job->func = func;
+	job->arg = arg;
+	job->result = 0;
+	job->state = MP_JOB_QUEUED;
+	q->jobs[head % MP_JOB_QUEUE_SIZE] = job;
+	mfence();
+
+	store_queue_index(&q->head, head + 1);
+
+	return 0;
+}
+
+int mp_wait_job(struct mp_job *job, long expire_us)
+{
+	struct stopwatch sw;
+
+	stopwatch_init_usecs_expire(&sw, expire_us);
+
+	while (!mp_job_done(job)) {
+		if (stopwatch_expired(&sw)) {
+			printk(BIOS_ERR, "AP job expired in state %d.\n",
+				job->state);
+			return -1;
+		}
+		asm ("pause");
+	}
+
+	return 0;
+}
+
+/*
+ * Take back a job no AP has started yet, or wait for it to finish. Either
+ * way func won't touch arg anymore once this returns.
+ */
+static void mp_cancel_job(struct mp_job *job, int cpu)
+{
+	if (__sync_bool_compare_and_swap(&job->state, MP_JOB_QUEUED,
+					 MP_JOB_DONE)) {
+		job->result = -1;
+		return;
+	}
+
+	if (mp_job_done(job))
+		return;
+
+	printk(BIOS_ERR, "AP %d still running its job, waiting for it.\n",
+		cpu);
+	while (!mp_job_done(job))
+		asm ("pause");
+}
+
+static struct mp_job ap_broadcast_jobs[CONFIG_MAX_CPUS];
+
+int mp_run_job_on_aps(int (*func)(void *arg), void *arg, long expire_us)
+{
+	struct stopwatch sw;
+	int ret = 0;
+	int queued;
+	int i;
+
+	/* Jobs left behind by an earlier timeout can't be reused yet. */
+	for (i = 1; i <= global_num_aps; i++) {
+		int state = ap_broadcast_jobs[i].state;
+
+		if (state != MP_JOB_IDLE && state != MP_JOB_DONE) {
+			printk(BIOS_ERR, "AP %d still busy with a job.\n", i);
+			return -1;
+		}
+	}
+
+	for (queued = 0; queued < global_num_aps; queued++) {
+		if (mp_queue_job(&ap_broadcast_jobs[queued + 1], queued + 1,
+				 func, arg) < 0) {
+			ret = -1;
+			goto cancel;
+		}
+	}
+
+	stopwatch_init_usecs_expire(&sw, expire_us);
+
+	for (i = 1; i <= global_num_aps; i++) {
+		while (!mp_job_done(&ap_broadcast_jobs[i])) {
+			if (stopwatch_expired(&sw)) {
+				printk(BIOS_ERR, "AP %d job expired.\n", i);
+				ret = -1;
+				goto cancel;
+			}
+			asm ("pause");
+		}
+
+		if (ap_broadcast_jobs[i].result < 0)
+			ret = -1;
+	}
+
+	return ret;
+
+cancel:
+	/* arg is usually on the caller's stack, so nothing may run late. */
+	for (i = 1; i <= queued; i++)
+		mp_cancel_job(&ap_broadcast_jobs[i], i);
+
+	return ret;
+}
+
 int mp_run_on_aps(void (*func)(void), long expire_us)
 {
 	return run_ap_work(func, expire_us);
@@ -951,6 +1147,7 @@ int mp_run_on_all_cpus(void (*func)(void), long expire_us)
 
 int mp_park_aps(void)
 {
+	aps_parked = 1;
 	return mp_run_on_aps(park_this_cpu, 10 * USECS_PER_MSEC);
 }
 
@@ -25,6 +25,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <bootstate.h>
+#include <cbmem.h>
 #include <console/console.h>
 #include <device/device.h>
 #include <device/pci_ids.h>
@@ -129,21 +130,20 @@ static void enable_var_mtrr(unsigned char deftype)
 #define RANGE_TO_PHYS_ADDR(x) (((resource_t)(x)) << RANGE_SHIFT)
 #define NUM_FIXED_MTRRS (NUM_FIXED_RANGES / RANGES_PER_FIXED_MTRR)
 
-/* The minimum alignment while handling variable MTRR ranges is 64MiB. */
-#define MTRR_MIN_ALIGN PHYS_TO_RANGE_ADDR(64 << 20)
 /* Helpful constants. */
 #define RANGE_1MB PHYS_TO_RANGE_ADDR(1 << 20)
 #define RANGE_4GB (1 << (ADDR_SHIFT_TO_RANGE_SHIFT(32)))
+/* Largest address the hole search considers, so sizes fit into 32 bits. */
+#define RANGE_HOLE_LIMIT (1U << 31)
 
 /*
  * The default MTRR type selection uses 3 approaches for selecting the
  * optimal number of variable MTRRs.  For each range do 3 calculations:
- *   1. UC as default type with no holes at top of range.
- *   2. UC as default using holes at top of range.
+ *   1. UC as default type with no holes.
+ *   2. UC as default using holes at the ends of the range.
  *   3. WB as default.
  * If using holes is optimal for a range when UC is the default type the
- * tag is updated to direct the commit routine to use a hole at the top
- * of a range.
+ * tag is updated to direct the commit routine to use holes for the range.
  */
 #define MTRR_ALGO_SHIFT (8)
 #define MTRR_TAG_MASK ((1 << MTRR_ALGO_SHIFT) - 1)
@@ -411,6 +411,7 @@ static struct var_mtrr_solution mtrr_global_solution;
 
 struct var_mtrr_state {
 	struct memranges *addr_space;
+	struct range_entry *prev;
 	int above4gb;
 	int address_bits;
 	int prepare_msrs;
@@ -499,22 +500,45 @@ static void calc_var_mtrr_range(struct var_mtrr_state *var_state,
 	}
 }
 
+/* Number of MTRRs calc_var_mtrr_range() needs for a range. */
+static int count_var_mtrr_range(uint32_t base, uint32_t size)
+{
+	struct var_mtrr_state count_state = {
+		.prepare_msrs = 0,
+		.mtrr_index = 0,
+	};
+
+	calc_var_mtrr_range(&count_state, base, size, MTRR_TYPE_UNCACHEABLE);
+
+	return count_state.mtrr_index;
+}
+
 static void calc_var_mtrrs_with_hole(struct var_mtrr_state *var_state,
 				     struct range_entry *r)
 {
 	uint32_t a1, a2, b1, b2;
+	uint64_t lo_limit, hi_limit;
+	int hi_hole_needed;
+	int best;
+	int lo_shift, hi_shift;
 	int mtrr_type;
 	struct range_entry *next;
+	struct range_entry *prev;
 
 	/*
 	 * Determine MTRRs based on the following algorithm for the given entry:
 	 * +------------------+ b2 = ALIGN_UP(end)
-	 * |  0 or more bytes | <-- hole is carved out between b1 and b2
-	 * +------------------+ a2 = b1 = end
+	 * |  0 or more bytes | <-- hole is carved out between a2 and b2
+	 * +------------------+ a2 = end
 	 * |                  |
 	 * +------------------+ a1 = begin
+	 * |  0 or more bytes | <-- hole is carved out between b1 and a1
+	 * +------------------+ b1 = ALIGN_DOWN(begin)
 	 *
-	 * Thus, there are 3 sub-ranges to configure variable MTRRs for.
+	 * b1..b2 is covered with the type of the range, and the holes with
+	 * the default type which takes precedence as it is UC. The holes may
+	 * only extend into address space that has the default type anyway.
+	 * All alignments are tried and the one needing the fewest MTRRs wins.
 	 */
 	mtrr_type = range_entry_mtrr_type(r);
 
@@ -542,39 +566,68 @@ static void calc_var_mtrrs_with_hole(struct var_mtrr_state *var_state,
 		a2 = RANGE_4GB;
 
 	next = memranges_next_entry(var_state->addr_space, r);
+	prev = var_state->prev;
+
+	/* Nothing lives above the last entry, so if it starts above 4GiB it
+	 * can be rounded up without carving out a hole. Otherwise the holes
+	 * may extend over the neighbours if they have the default type. */
+	hi_hole_needed = 1;
+	if (next == NULL) {
+		hi_limit = RANGE_HOLE_LIMIT;
+		hi_hole_needed = a1 < RANGE_4GB;
+	} else if (range_entry_mtrr_type(next) == var_state->def_mtrr_type) {
+		hi_limit = range_entry_end_mtrr_addr(next);
+	} else {
+		hi_limit = range_entry_base_mtrr_addr(next);
+	}
 
-	b1 = a2;
+	if (!var_state->above4gb)
+		hi_limit = MIN(hi_limit, RANGE_4GB);
+	hi_limit = MIN(hi_limit, RANGE_HOLE_LIMIT);
 
-	/* First check if a1 is >= 4GiB and the current entry is the last
-	 * entry. If so perform an optimization of covering a larger range
-	 * defined by the base address' alignment. */
-	if (a1 >= RANGE_4GB && next == NULL) {
-		uint32_t addr_lsb;
+	if (prev == NULL)
+		lo_limit = 0;
+	else if (range_entry_mtrr_type(prev) == var_state->def_mtrr_type)
+		lo_limit = range_entry_base_mtrr_addr(prev);
+	else
+		lo_limit = range_entry_end_mtrr_addr(prev);
 
-		addr_lsb = fls(a1);
-		b2 = (1 << addr_lsb) + a1;
-		if (b2 >= a2) {
-			calc_var_mtrr_range(var_state, a1, b2 - a1, mtrr_type);
-			return;
-		}
-	}
+	/* Without holes the range is covered exactly. */
+	b1 = a1;
+	b2 = a2;
+	best = count_var_mtrr_range(a1, a2 - a1);
 
-	/* Handle the min alignment roundup case. */
-	b2 = ALIGN_UP(a2, MTRR_MIN_ALIGN);
-
-	/* Check against the next range. If the current range_entry is the
-	 * last entry then carving a hole is no problem. If the current entry
-	 * isn't the last entry then check that the last entry covers the
-	 * entire hole range with the default mtrr type. */
-	if (next != NULL &&
-	    (range_entry_mtrr_type(next) != var_state->def_mtrr_type ||
-	     range_entry_end_mtrr_addr(next) < b2)) {
-		calc_var_mtrr_range(var_state, a1, a2 - a1, mtrr_type);
-		return;
+	for (lo_shift = 0; lo_shift < 32; lo_shift++) {
+		uint64_t lo = ALIGN_DOWN((uint64_t)a1, 1ULL << lo_shift);
+
+		if (lo < lo_limit)
+			break;
+
+		for (hi_shift = 0; hi_shift < 32; hi_shift++) {
+			uint64_t hi = ALIGN_UP((uint64_t)a2, 1ULL << hi_shift);
+			int count;
+
+			if (hi > hi_limit)
+				break;
+
+			count = count_var_mtrr_range(lo, hi - lo) +
+				count_var_mtrr_range(lo, a1 - lo);
+			if (hi_hole_needed)
+				count += count_var_mtrr_range(a2, hi - a2);
+
+			if (count < best) {
+				best = count;
+				b1 = lo;
+				b2 = hi;
+			}
+		}
 	}
 
-	calc_var_mtrr_range(var_state, a1, b2 - a1, mtrr_type);
-	calc_var_mtrr_range(var_state, b1, b2 - b1, var_state->def_mtrr_type);
+	calc_var_mtrr_range(var_state, b1, b2 - b1, mtrr_type);
+	calc_var_mtrr_range(var_state, b1, a1 - b1, var_state->def_mtrr_type);
+	if (hi_hole_needed)
+		calc_var_mtrr_range(var_state, a2, b2 - a2,
+				    var_state->def_mtrr_type);
 }
 
 static void calc_var_mtrrs_without_hole(struct var_mtrr_state *var_state,
@@ -624,6 +677,7 @@ static void __calc_var_mtrrs(struct memranges *addr_space,
 	var_state.above4gb = above4gb;
 	var_state.address_bits = address_bits;
 	var_state.prepare_msrs = 0;
+	var_state.prev = NULL;
 
 	wb_deftype_count = 0;
 	uc_deftype_count = 0;
@@ -685,6 +739,8 @@ static void __calc_var_mtrrs(struct memranges *addr_space,
 			calc_var_mtrrs_without_hole(&var_state, r);
 			wb_deftype_count += var_state.mtrr_index;
 		}
+
+		var_state.prev = r;
 	}
 	*num_def_wb_mtrrs = wb_deftype_count;
 	*num_def_uc_mtrrs = uc_deftype_count;
@@ -736,15 +792,21 @@ static void prepare_var_mtrrs(struct memranges *addr_space, int def_type,
 	var_state.def_mtrr_type = def_type;
 	var_state.regs = &sol->regs[0];
 
+	var_state.prev = NULL;
+
 	memranges_each_entry(r, var_state.addr_space) {
-		if (range_entry_mtrr_type(r) == def_type)
+		if (range_entry_mtrr_type(r) == def_type) {
+			var_state.prev = r;
 			continue;
+		}
 
 		if (def_type == MTRR_TYPE_UNCACHEABLE &&
 		    (range_entry_tag(r) & MTRR_RANGE_UC_USE_HOLE))
 			calc_var_mtrrs_with_hole(&var_state, r);
 		else
 			calc_var_mtrrs_without_hole(&var_state, r);
+
+		var_state.prev = r;
 	}
 
 	/* Update the solution. */
@@ -776,19 +838,90 @@ static int commit_var_mtrrs(const struct var_mtrr_solution *sol)
 	return 0;
 }
 
+/*
+ * The solution is kept in CBMEM together with the address space it was
+ * calculated for, so that S3 resume can reuse it as long as the address
+ * space didn't change.
+ */
+#define MTRR_CACHE_ENTRIES 32
+
+struct var_mtrr_cache {
+	uint32_t address_bits;
+	uint32_t above4gb;
+	uint32_t total_mtrrs;
+	uint32_t num_entries;
+	struct {
+		uint64_t base;
+		uint64_t end;
+		uint64_t tag;
+	} entries[MTRR_CACHE_ENTRIES];
+	struct var_mtrr_solution sol;
+};
+
+/* Describe the address space in the cache. Returns < 0 if it can't be. */
+static int var_mtrr_cache_key(struct var_mtrr_cache *cache,
+			      struct memranges *addr_space,
+			      unsigned int above4gb, unsigned int address_bits)
+{
+	struct range_entry *r;
+	uint32_t i = 0;
+
+	memset(cache, 0, sizeof(*cache));
+	cache->address_bits = address_bits;
+	cache->above4gb = above4gb;
+	cache->total_mtrrs = total_mtrrs;
+
+	memranges_each_entry(r, addr_space) {
+		if (i == ARRAY_SIZE(cache->entries))
+			return -1;
+		cache->entries[i].base = range_entry_base(r);
+		cache->entries[i].end = range_entry_end(r);
+		cache->entries[i].tag = range_entry_tag(r);
+		i++;
+	}
+	cache->num_entries = i;
+
+	return 0;
+}
+
 void x86_setup_var_mtrrs(unsigned int address_bits, unsigned int above4gb)
 {
 	static struct var_mtrr_solution *sol = NULL;
 	struct memranges *addr_space;
+	static struct var_mtrr_cache key;
+	struct var_mtrr_cache *cache;
+	int have_key;
 
 	addr_space = get_physical_address_space();
 
 	if (sol == NULL) {
 		sol = &mtrr_global_solution;
-		sol->mtrr_default_type =
-			calc_var_mtrrs(addr_space, !!above4gb, address_bits);
-		prepare_var_mtrrs(addr_space, sol->mtrr_default_type,
-				  !!above4gb, address_bits, sol);
+
+		/* The key has to be taken before the calculation updates
+		 * the tags of the address space. */
+		have_key = var_mtrr_cache_key(&key, addr_space, !!above4gb,
+					      address_bits) == 0;
+
+		cache = cbmem_find(CBMEM_ID_MTRR_SOLUTION);
+		if (have_key && cache != NULL &&
+		    memcmp(cache, &key, offsetof(struct var_mtrr_cache, sol))
+		    == 0) {
+			printk(BIOS_DEBUG, "MTRR: Using cached solution.\n");
+			memcpy(sol, &cache->sol, sizeof(*sol));
+		} else {
+			sol->mtrr_default_type = calc_var_mtrrs(addr_space,
+						!!above4gb, address_bits);
+			prepare_var_mtrrs(addr_space, sol->mtrr_default_type,
+					  !!above4gb, address_bits, sol);
+
+			if (have_key && cache == NULL)
+				cache = cbmem_add(CBMEM_ID_MTRR_SOLUTION,
+						  sizeof(*cache));
+			if (have_key && cache != NULL) {
+				memcpy(cache, &key, sizeof(*cache));
+				memcpy(&cache->sol, sol, sizeof(*sol));
+			}
+		}
 	}
 
 	commit_var_mtrrs(sol);
@@ -13,6 +13,7 @@
  * GNU General Public License for more details.
  */
 
+#include <commonlib/helpers.h>
 #include <compiler.h>
 #include <console/console.h>
 #include <cpu/cpu.h>
@@ -115,3 +116,63 @@ void *map_2M_page(unsigned long page)
 		result = (void *)(0x80000000 | ((page & 0x3ff) << 21));
 	return result;
 }
+
+/* 2MiB pages, present, writable, accessed and dirty. */
+#define PAE_2M_PAGE_SIZE	(2 * 1024 * 1024)
+#define PAE_2M_PAGE_FLAGS	0xE3
+
+struct pae_entry {
+	uint32_t addr_lo;
+	uint32_t addr_hi;
+} __packed;
+
+/* BSP-only page tables for map_2M_page_at(). */
+static struct {
+	struct pae_entry pd[2048];
+	struct pae_entry pdp[4];
+} slot_pgtbl __attribute__((aligned(4096)));
+static int slot_paging;
+
+void *map_2M_page_at(uintptr_t slot, uint64_t phys)
+{
+	struct pae_entry *pde;
+	uint32_t i;
+
+	if (cpu_index() != 0 || slot % PAE_2M_PAGE_SIZE ||
+	    phys % PAE_2M_PAGE_SIZE)
+		return MAPPING_ERROR;
+
+	if (!slot_paging) {
+		for (i = 0; i < ARRAY_SIZE(slot_pgtbl.pdp); i++) {
+			slot_pgtbl.pdp[i].addr_lo =
+				(uint32_t)&slot_pgtbl.pd[512 * i] | 1;
+			slot_pgtbl.pdp[i].addr_hi = 0;
+		}
+		for (i = 0; i < ARRAY_SIZE(slot_pgtbl.pd); i++) {
+			slot_pgtbl.pd[i].addr_lo = (i << 21) | PAE_2M_PAGE_FLAGS;
+			slot_pgtbl.pd[i].addr_hi = 0;
+		}
+	}
+
+	pde = &slot_pgtbl.pd[slot / PAE_2M_PAGE_SIZE];
+	pde->addr_lo = (uint32_t)phys | PAE_2M_PAGE_FLAGS;
+	pde->addr_hi = phys >> 32;
+
+	if (slot_paging) {
+		__asm__ __volatile__("invlpg (%0)" : : "r" (slot) : "memory");
+	} else {
+		paging_on(slot_pgtbl.pdp);
+		slot_paging = 1;
+	}
+
+	return (void *)slot;
+}
+
+void unmap_2M_pages(void)
+{
+	if (!slot_paging)
+		return;
+
+	paging_off();
+	slot_paging = 0;
+}
@@ -245,61 +245,256 @@ static void read_resources(struct bus *bus)
 	       dev_path(bus->dev), bus->secondary, bus->link_num);
 }
 
-struct pick_largest_state {
-	struct resource *last;
-	struct device *result_dev;
-	struct resource *result;
-	int seen_last;
+/* A resource on a bus along with the device it belongs to. */
+struct bus_resource {
+	struct device *dev;
+	struct resource *res;
+};
+
+struct bus_resources {
+	struct bus_resource *list;
+	size_t count;
+	size_t capacity;
 };
 
-static void pick_largest_resource(void *gp, struct device *dev,
-				  struct resource *resource)
+/*
+ * compute_resources() sorts a bus after it is done with the buses below it
+ * and allocate_resources() before it moves on to them, so one list can be
+ * reused for every bus.
+ */
+static struct bus_resources sorted_resources;
+
+/* Larger alignments go first and for the same alignment larger sizes. */
+static int resource_goes_before(const struct resource *a,
+				const struct resource *b)
 {
-	struct pick_largest_state *state = gp;
-	struct resource *last;
+	if (a->align != b->align)
+		return a->align > b->align;
+	return a->size > b->size;
+}
 
-	last = state->last;
+static void add_sorted_resource(void *gp, struct device *dev,
+				struct resource *resource)
+{
+	struct bus_resources *sorted = gp;
+	size_t lo = 0;
+	size_t hi = sorted->count;
 
-	/* Be certain to pick the successor to last. */
-	if (resource == last) {
-		state->seen_last = 1;
-		return;
-	}
 	if (resource->flags & IORESOURCE_FIXED)
 		return;	/* Skip it. */
-	if (last && ((last->align < resource->align) ||
-		     ((last->align == resource->align) &&
-		      (last->size < resource->size)) ||
-		     ((last->align == resource->align) &&
-		      (last->size == resource->size) && (!state->seen_last)))) {
+
+	if (sorted->count == sorted->capacity) {
+		struct bus_resource *list;
+		size_t capacity = MAX(32, sorted->capacity * 2);
+
+		/* There is no free(), the old list is simply left behind. */
+		list = malloc(capacity * sizeof(*list));
+		if (sorted->count)
+			memcpy(list, sorted->list,
+			       sorted->count * sizeof(*list));
+		sorted->list = list;
+		sorted->capacity = capacity;
+	}
+
+	/* Equal resources stay in the order they were found in. */
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (resource_goes_before(resource, sorted->list[mid].res))
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+
+	memmove(&sorted->list[lo + 1], &sorted->list[lo],
+		(sorted->count - lo) * sizeof(sorted->list[0]));
+	sorted->list[lo].dev = dev;
+	sorted->list[lo].res = resource;
+	sorted->count++;
+}
+
+/**
+ * Collect the resources of a bus that need an address, in the order they
+ * are placed in.
+ *
+ * @param bus The bus to collect the resources of.
+ * @param type_mask This value gets ANDed with the resource type.
+ * @param type This value must match the result of the AND.
+ * @return The sorted resources, valid until the next call.
+ */
+static struct bus_resources *sort_resources(struct bus *bus,
+					    unsigned long type_mask,
+					    unsigned long type)
+{
+	struct bus_resources *sorted = &sorted_resources;
+
+	sorted->count = 0;
+	search_bus_resources(bus, type_mask, type, add_sorted_resource,
+			     sorted);
+
+	return sorted;
+}
+
+#define RESOURCE_MAX_HOLES 8
+
+/*
+ * Address space behind a bridge being handed out. Aligning a resource can
+ * leave a hole in front of it. Those holes are remembered, so the smaller
+ * resources that come later can be put into them instead of after
+ * everything else.
+ */
+struct resource_window {
+	/* Everything from here on is free. */
+	resource_t base;
+	/* Space lost to holes that were given up on. */
+	resource_t wasted;
+	size_t num_holes;
+	struct {
+		resource_t base;
+		resource_t end;
+	} holes[RESOURCE_MAX_HOLES];
+};
+
+static void window_init(struct resource_window *window, resource_t base)
+{
+	window->base = base;
+	window->wasted = 0;
+	window->num_holes = 0;
+}
+
+static void window_add_hole(struct resource_window *window, resource_t base,
+			    resource_t end)
+{
+	size_t smallest = 0;
+	resource_t size;
+	size_t i;
+
+	if (base >= end)
 		return;
+
+	if (window->num_holes < ARRAY_SIZE(window->holes)) {
+		i = window->num_holes++;
+	} else {
+		/* Give up on the smallest hole to make room. */
+		for (i = 1; i < window->num_holes; i++) {
+			if (window->holes[i].end - window->holes[i].base <
+			    window->holes[smallest].end -
+			    window->holes[smallest].base)
+				smallest = i;
+		}
+		i = smallest;
+		size = window->holes[i].end - window->holes[i].base;
+		if (end - base <= size) {
+			window->wasted += end - base;
+			return;
+		}
+		window->wasted += size;
+	}
+
+	window->holes[i].base = base;
+	window->holes[i].end = end;
+}
+
+/**
+ * Find where a resource goes: the smallest hole it fits in or, if there is
+ * none, the next aligned address. I/O resources aren't put into holes as
+ * the legacy alias rules only look at the base of the window.
+ *
+ * @param window The address space to place the resource in.
+ * @param resource The resource to place.
+ * @param hole Set to the index of the hole used or -1.
+ * @return The base address for the resource.
+ */
+static resource_t window_fit(const struct resource_window *window,
+			     const struct resource *resource, int *hole)
+{
+	resource_t best_left = 0;
+	resource_t base;
+	size_t i;
+
+	*hole = -1;
+
+	if (!(resource->flags & IORESOURCE_IO)) {
+		for (i = 0; i < window->num_holes; i++) {
+			resource_t start = round(window->holes[i].base,
+						 resource->align);
+			resource_t left;
+
+			if (start >= window->holes[i].end ||
+			    window->holes[i].end - start < resource->size)
+				continue;
+
+			left = window->holes[i].end - window->holes[i].base -
+			       resource->size;
+			if (*hole < 0 || left < best_left) {
+				*hole = i;
+				best_left = left;
+			}
+		}
 	}
-	if (!state->result ||
-	    (state->result->align < resource->align) ||
-	    ((state->result->align == resource->align) &&
-	     (state->result->size < resource->size))) {
-		state->result_dev = dev;
-		state->result = resource;
+
+	if (*hole >= 0)
+		return round(window->holes[*hole].base, resource->align);
+
+	base = window->base;
+
+	if (resource->flags & IORESOURCE_IO) {
+		/*
+		 * Don't allow potential aliases over the legacy PCI
+		 * expansion card addresses. The legacy PCI decodes
+		 * only 10 bits, uses 0x100 - 0x3ff. Therefore, only
+		 * 0x00 - 0xff can be used out of each 0x400 block of
+		 * I/O space.
+		 */
+		if ((base & 0x300) != 0) {
+			base = (base & ~0x3ff) + 0x400;
+		}
+		/*
+		 * Don't allow allocations in the VGA I/O range.
+		 * PCI has special cases for that.
+		 */
+		else if ((base >= 0x3b0) && (base <= 0x3df)) {
+			base = 0x3e0;
+		}
 	}
+
+	/* Base must be aligned. */
+	return round(base, resource->align);
 }
 
-static struct device *largest_resource(struct bus *bus,
-				       struct resource **result_res,
-				       unsigned long type_mask,
-				       unsigned long type)
+/* Take the space window_fit() found for a resource. */
+static void window_take(struct resource_window *window,
+			const struct resource *resource, resource_t start,
+			int hole)
 {
-	struct pick_largest_state state;
+	resource_t end = start + resource->size;
+
+	if (hole >= 0) {
+		resource_t hole_base = window->holes[hole].base;
+		resource_t hole_end = window->holes[hole].end;
+
+		/* Drop the hole and add back what is left on both sides. */
+		window->holes[hole] = window->holes[--window->num_holes];
+		window_add_hole(window, hole_base, start);
+		window_add_hole(window, end, hole_end);
+		return;
+	}
+
+	if (!(resource->flags & IORESOURCE_IO))
+		window_add_hole(window, window->base, start);
+	window->base = end;
+}
 
-	state.last = *result_res;
-	state.result_dev = NULL;
-	state.result = NULL;
-	state.seen_last = 0;
+/* The space behind a bridge that ended up unused. */
+static resource_t window_wasted(const struct resource_window *window)
+{
+	resource_t wasted = window->wasted;
+	size_t i;
 
-	search_bus_resources(bus, type_mask, type, pick_largest_resource,
-			     &state);
+	for (i = 0; i < window->num_holes; i++)
+		wasted += window->holes[i].end - window->holes[i].base;
 
-	*result_res = state.result;
-	return state.result_dev;
+	return wasted;
 }
 
 /**
@@ -340,7 +535,11 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 {
 	struct device *dev;
 	struct resource *resource;
+	struct bus_resources *sorted;
+	struct resource_window window;
 	resource_t base;
+	resource_t wasted;
+	size_t i;
 	base = round(bridge->base, bridge->align);
 
 	printk(BIOS_SPEW,  "%s %s: base: %llx size: %llx align: %d gran: %d"
@@ -389,15 +588,19 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 		}
 	}
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and compute the
 	 * amount of address space taken by them. Take granularity and
 	 * alignment into account.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	sorted = sort_resources(bus, type_mask, type);
+	window_init(&window, base);
+
+	for (i = 0; i < sorted->count; i++) {
+		int hole;
+
+		dev = sorted->list[i].dev;
+		resource = sorted->list[i].res;
 
 		/* Size 0 resources can be skipped. */
 		if (!resource->size)
@@ -420,29 +623,8 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 			       dev_path(dev), resource->index, resource->limit);
 		}
 
-		if (resource->flags & IORESOURCE_IO) {
-			/*
-			 * Don't allow potential aliases over the legacy PCI
-			 * expansion card addresses. The legacy PCI decodes
-			 * only 10 bits, uses 0x100 - 0x3ff. Therefore, only
-			 * 0x00 - 0xff can be used out of each 0x400 block of
-			 * I/O space.
-			 */
-			if ((base & 0x300) != 0) {
-				base = (base & ~0x3ff) + 0x400;
-			}
-			/*
-			 * Don't allow allocations in the VGA I/O range.
-			 * PCI has special cases for that.
-			 */
-			else if ((base >= 0x3b0) && (base <= 0x3df)) {
-				base = 0x3e0;
-			}
-		}
-		/* Base must be aligned. */
-		base = round(base, resource->align);
-		resource->base = base;
-		base += resource->size;
+		resource->base = window_fit(&window, resource, &hole);
+		window_take(&window, resource, resource->base, hole);
 
 		printk(BIOS_SPEW, "%s %02lx *  [0x%llx - 0x%llx] %s\n",
 		       dev_path(dev), resource->index, resource->base,
@@ -450,6 +632,9 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 		       resource2str(resource));
 	}
 
+	base = window.base;
+	wasted = window_wasted(&window);
+
 	/*
 	 * A PCI bridge resource does not need to be a power of two size, but
 	 * it does have a minimum granularity. Round the size up to that
@@ -463,6 +648,10 @@ static void compute_resources(struct bus *bus, struct resource *bridge,
 	       " limit: %llx done\n", dev_path(bus->dev),
 	       resource2str(bridge),
 	       base, bridge->size, bridge->align, bridge->gran, bridge->limit);
+
+	if (wasted)
+		printk(BIOS_DEBUG, "%s %s: 0x%llx bytes lost to alignment\n",
+		       dev_path(bus->dev), resource2str(bridge), wasted);
 }
 
 /**
@@ -484,7 +673,10 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 {
 	struct device *dev;
 	struct resource *resource;
+	struct bus_resources *sorted;
+	struct resource_window window;
 	resource_t base;
+	size_t i;
 	base = bridge->base;
 
 	printk(BIOS_SPEW, "%s %s: base:%llx size:%llx align:%d gran:%d "
@@ -492,14 +684,19 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 	       resource2str(bridge),
 	       base, bridge->size, bridge->align, bridge->gran, bridge->limit);
 
-	/* Remember we haven't found anything yet. */
-	resource = NULL;
-
 	/*
 	 * Walk through all the resources on the current bus and allocate them
 	 * address space.
 	 */
-	while ((dev = largest_resource(bus, &resource, type_mask, type))) {
+	sorted = sort_resources(bus, type_mask, type);
+	window_init(&window, base);
+
+	for (i = 0; i < sorted->count; i++) {
+		resource_t start;
+		int hole;
+
+		dev = sorted->list[i].dev;
+		resource = sorted->list[i].res;
 
 		/* Propagate the bridge limit to the resource register. */
 		if (resource->limit > bridge->limit)
@@ -513,42 +710,21 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 			continue;
 		}
 
-		if (resource->flags & IORESOURCE_IO) {
-			/*
-			 * Don't allow potential aliases over the legacy PCI
-			 * expansion card addresses. The legacy PCI decodes
-			 * only 10 bits, uses 0x100 - 0x3ff. Therefore, only
-			 * 0x00 - 0xff can be used out of each 0x400 block of
-			 * I/O space.
-			 */
-			if ((base & 0x300) != 0) {
-				base = (base & ~0x3ff) + 0x400;
-			}
-			/*
-			 * Don't allow allocations in the VGA I/O range.
-			 * PCI has special cases for that.
-			 */
-			else if ((base >= 0x3b0) && (base <= 0x3df)) {
-				base = 0x3e0;
-			}
-		}
+		start = window_fit(&window, resource, &hole);
 
-		if ((round(base, resource->align) + resource->size - 1) <=
-		    resource->limit) {
-			/* Base must be aligned. */
-			base = round(base, resource->align);
-			resource->base = base;
+		if ((start + resource->size - 1) <= resource->limit) {
+			window_take(&window, resource, start, hole);
+			resource->base = start;
 			resource->limit = resource->base + resource->size - 1;
 			resource->flags |= IORESOURCE_ASSIGNED;
 			resource->flags &= ~IORESOURCE_STORED;
-			base += resource->size;
 		} else {
 			printk(BIOS_ERR, "!! Resource didn't fit !!\n");
 			printk(BIOS_ERR, "   aligned base %llx size %llx "
-			       "limit %llx\n", round(base, resource->align),
+			       "limit %llx\n", start,
 			       resource->size, resource->limit);
 			printk(BIOS_ERR, "   %llx needs to be <= %llx "
-			       "(limit)\n", (round(base, resource->align) +
+			       "(limit)\n", (start +
 				resource->size) - 1, resource->limit);
 			printk(BIOS_ERR, "   %s%s %02lx *  [0x%llx - 0x%llx]"
 			       " %s\n", (resource->flags & IORESOURCE_ASSIGNED)
@@ -564,6 +740,8 @@ static void allocate_resources(struct bus *bus, struct resource *bridge,
 		       resource->base, resource2str(resource));
 	}
 
+	base = window.base;
+
 	/*
 	 * A PCI bridge resource does not need to be a power of two size, but
 	 * it does have a minimum granularity. Round the size up to that
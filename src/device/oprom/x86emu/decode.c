@@ -41,6 +41,140 @@
 
 /*----------------------------- Implementation ----------------------------*/
 
+#if IS_ENABLED(CONFIG_X86EMU_FETCH_CACHE)
+/*
+ * Instruction fetch cache. Option ROMs spend most of their time in short
+ * loops, and without the cache every opcode, ModRM byte and immediate goes
+ * through the (*sys_rdb) hook of the system emulation again. The cache is
+ * direct mapped and keyed by the linear address, so it doesn't matter how
+ * CS:IP is split. Every write through the sys_wr* hooks drops the lines it
+ * touches, and the whole cache is dropped when X86EMU_exec() starts or the
+ * memory functions change. Host interrupt handlers are not followed by a
+ * flush: ROMs call them in loops and refilling the lines would cost more
+ * than the cache saves. Their writes bypass the sys_wr* hooks, so they
+ * must not change code, which the ones of YABEL don't.
+ */
+#define FETCH_LINE_SHIFT    6
+#define FETCH_LINE_SIZE     (1 << FETCH_LINE_SHIFT)
+#define FETCH_LINES         256
+
+struct fetch_line {
+    u32 tag;                        /* line number + 1, 0 if unused */
+    u8  data[FETCH_LINE_SIZE];
+};
+
+static struct fetch_line fetch_cache[FETCH_LINES];
+
+/****************************************************************************
+REMARKS:
+Drops everything from the instruction fetch cache.
+****************************************************************************/
+void x86emu_flush_code_cache(void)
+{
+    int i;
+
+    for (i = 0; i < FETCH_LINES; i++)
+        fetch_cache[i].tag = 0;
+}
+
+/****************************************************************************
+PARAMETERS:
+addr    - Linear address that is written to
+size    - Number of bytes written
+
+REMARKS:
+Drops the lines of the instruction fetch cache that cover a write.
+****************************************************************************/
+void x86emu_invalidate_code(u32 addr, int size)
+{
+    u32 line = addr >> FETCH_LINE_SHIFT;
+    u32 last = (addr + size - 1) >> FETCH_LINE_SHIFT;
+
+    for (; line <= last; line++) {
+        if (fetch_cache[line % FETCH_LINES].tag == line + 1)
+            fetch_cache[line % FETCH_LINES].tag = 0;
+    }
+}
+
+/****************************************************************************
+RETURNS:
+True if code at the line starting at addr may be cached.
+
+REMARKS:
+The interrupt vectors and the BIOS data area are never executed, and the
+legacy VGA window may be remapped to device memory by the system emulation.
+****************************************************************************/
+static int fetch_cacheable(u32 addr)
+{
+    if (addr < 0x500 || (addr >= 0xa0000 && addr < 0xc0000))
+        return 0;
+    return addr + FETCH_LINE_SIZE <= M.mem_size;
+}
+
+/****************************************************************************
+PARAMETERS:
+addr    - Linear address of the code to read
+size    - Number of bytes to read
+
+RETURNS:
+Pointer to the code in the instruction fetch cache, or NULL if the access
+can't be served from the cache.
+****************************************************************************/
+static u8 *fetch_code_ptr(u32 addr, int size)
+{
+    u32 line = addr >> FETCH_LINE_SHIFT;
+    u32 offset = addr & (FETCH_LINE_SIZE - 1);
+    struct fetch_line *fl = &fetch_cache[line % FETCH_LINES];
+    int i;
+
+    if (offset + size > FETCH_LINE_SIZE)
+        return NULL;
+
+    if (fl->tag != line + 1) {
+        u32 base = line << FETCH_LINE_SHIFT;
+
+        if (!fetch_cacheable(base))
+            return NULL;
+        for (i = 0; i < FETCH_LINE_SIZE; i++)
+            fl->data[i] = (*sys_rdb)(base + i);
+        fl->tag = line + 1;
+    }
+    return &fl->data[offset];
+}
+
+/****************************************************************************
+PARAMETERS:
+addr    - Linear address of the code byte to read
+
+RETURNS:
+Code byte at addr, from the instruction fetch cache if possible.
+****************************************************************************/
+u8 fetch_code_byte(u32 addr)
+{
+    u8 *p = fetch_code_ptr(addr, 1);
+
+    return p ? *p : (*sys_rdb)(addr);
+}
+
+static u16 fetch_code_word(u32 addr)
+{
+    u8 *p = fetch_code_ptr(addr, 2);
+
+    return p ? p[0] | (p[1] << 8) : (*sys_rdw)(addr);
+}
+
+static u32 fetch_code_long(u32 addr)
+{
+    u8 *p = fetch_code_ptr(addr, 4);
+
+    return p ? p[0] | (p[1] << 8) | (p[2] << 16) | ((u32)p[3] << 24) :
+        (*sys_rdl)(addr);
+}
+#else
+#define fetch_code_word(addr)   (*sys_rdw)(addr)
+#define fetch_code_long(addr)   (*sys_rdl)(addr)
+#endif
+
 /****************************************************************************
 REMARKS:
 Handles any pending asynchronous interrupts.
@@ -94,6 +228,7 @@ void X86EMU_exec(void)
     u8 op1;
 
     M.x86.intr = 0;
+    x86emu_flush_code_cache();
     DB(x86emu_end_instr();)
 
     for (;;) {
@@ -119,7 +254,7 @@ DB(             if (M.x86.R_SP != 0) {
                 x86emu_intr_handle();
             }
         }
-        op1 = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+        op1 = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
         (*x86emu_optab[op1])(op1);
         //if (M.x86.debug & DEBUG_EXIT) {
         //    M.x86.debug &= ~DEBUG_EXIT;
@@ -158,7 +293,7 @@ void fetch_decode_modrm(
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
     INC_DECODED_INST_LEN(1);
     *mod  = (fetched >> 6) & 0x03;
     *regh = (fetched >> 3) & 0x07;
@@ -181,7 +316,7 @@ u8 fetch_byte_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdb)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
+    fetched = fetch_code_byte(((u32)M.x86.R_CS << 4) + (M.x86.R_IP++));
     INC_DECODED_INST_LEN(1);
     return fetched;
 }
@@ -202,7 +337,7 @@ u16 fetch_word_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdw)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    fetched = fetch_code_word(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
     M.x86.R_IP += 2;
     INC_DECODED_INST_LEN(2);
     return fetched;
@@ -224,7 +359,7 @@ u32 fetch_long_imm(void)
 
 DB( if (CHECK_IP_FETCH())
         x86emu_check_ip_access();)
-    fetched = (*sys_rdl)(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
+    fetched = fetch_code_long(((u32)M.x86.R_CS << 4) + (M.x86.R_IP));
     M.x86.R_IP += 4;
     INC_DECODED_INST_LEN(4);
     return fetched;
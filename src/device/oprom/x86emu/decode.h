@@ -56,6 +56,15 @@ extern "C" {            			/* Use "C" linkage when in C++ mode */
 #endif
 
 void 	x86emu_intr_raise (u8 type);
+#if IS_ENABLED(CONFIG_X86EMU_FETCH_CACHE)
+u8      fetch_code_byte (u32 addr);
+void    x86emu_invalidate_code (u32 addr, int size);
+void    x86emu_flush_code_cache (void);
+#else
+#define fetch_code_byte(addr)               (*sys_rdb)(addr)
+#define x86emu_invalidate_code(addr, size)  do { } while (0)
+#define x86emu_flush_code_cache()           do { } while (0)
+#endif
 void    fetch_decode_modrm (int *mod,int *regh,int *regl);
 u8      fetch_byte_imm (void);
 u16     fetch_word_imm (void);
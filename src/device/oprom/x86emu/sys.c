@@ -45,6 +45,7 @@
 #include <x86emu/regs.h>
 #include <device/oprom/include/io.h>
 #include "debug.h"
+#include "decode.h"
 #include "prim_ops.h"
 
 #ifdef IN_MODULE
@@ -300,9 +301,41 @@ static void X86API p_outl(X86EMU_pioAddr addr, u32 val)
 u8(X86APIP sys_rdb) (u32 addr) = rdb;
 u16(X86APIP sys_rdw) (u32 addr) = rdw;
 u32(X86APIP sys_rdl) (u32 addr) = rdl;
+#if IS_ENABLED(CONFIG_X86EMU_FETCH_CACHE)
+/*
+ * Writes go through these wrappers first so that code which is changed by
+ * the emulated program doesn't stay in the instruction fetch cache.
+ */
+static void (X86APIP mem_wrb) (u32 addr, u8 val) = wrb;
+static void (X86APIP mem_wrw) (u32 addr, u16 val) = wrw;
+static void (X86APIP mem_wrl) (u32 addr, u32 val) = wrl;
+
+static void X86API fetch_wrb(u32 addr, u8 val)
+{
+	x86emu_invalidate_code(addr, 1);
+	(*mem_wrb)(addr, val);
+}
+
+static void X86API fetch_wrw(u32 addr, u16 val)
+{
+	x86emu_invalidate_code(addr, 2);
+	(*mem_wrw)(addr, val);
+}
+
+static void X86API fetch_wrl(u32 addr, u32 val)
+{
+	x86emu_invalidate_code(addr, 4);
+	(*mem_wrl)(addr, val);
+}
+
+void (X86APIP sys_wrb) (u32 addr, u8 val) = fetch_wrb;
+void (X86APIP sys_wrw) (u32 addr, u16 val) = fetch_wrw;
+void (X86APIP sys_wrl) (u32 addr, u32 val) = fetch_wrl;
+#else
 void (X86APIP sys_wrb) (u32 addr, u8 val) = wrb;
 void (X86APIP sys_wrw) (u32 addr, u16 val) = wrw;
 void (X86APIP sys_wrl) (u32 addr, u32 val) = wrl;
+#endif
 u8(X86APIP sys_inb) (X86EMU_pioAddr addr) = p_inb;
 u16(X86APIP sys_inw) (X86EMU_pioAddr addr) = p_inw;
 u32(X86APIP sys_inl) (X86EMU_pioAddr addr) = p_inl;
@@ -326,9 +359,16 @@ void X86EMU_setupMemFuncs(X86EMU_memFuncs * funcs)
 	sys_rdb = funcs->rdb;
 	sys_rdw = funcs->rdw;
 	sys_rdl = funcs->rdl;
+#if IS_ENABLED(CONFIG_X86EMU_FETCH_CACHE)
+	mem_wrb = funcs->wrb;
+	mem_wrw = funcs->wrw;
+	mem_wrl = funcs->wrl;
+	x86emu_flush_code_cache();
+#else
 	sys_wrb = funcs->wrb;
 	sys_wrw = funcs->wrw;
 	sys_wrl = funcs->wrl;
+#endif
 }
 
 /****************************************************************************
@@ -403,4 +443,5 @@ void X86EMU_setMemBase(void *base, size_t size)
 {
 	M.mem_base = (unsigned long) base;
 	M.mem_size = size;
+	x86emu_flush_code_cache();
 }
@@ -34,6 +34,7 @@
 #include <arch/acpi.h>
 #include <arch/io.h>
 #include <bootmode.h>
+#include <bootstate.h>
 #include <console/console.h>
 #include <stdlib.h>
 #include <stdint.h>
@@ -969,6 +970,28 @@ static struct device *pci_scan_get_dev(struct device **list, unsigned int devfn)
 	return dev;
 }
 
+/*
+ * Returns a bitmap of the slots of a bus that need to be probed. With
+ * PCI_STATIC_ROOT_BUS the devicetree is trusted to list every populated
+ * slot of the root bus of a domain.
+ */
+static u32 pci_scan_slots(struct bus *bus, struct device *static_devices)
+{
+	struct device *dev;
+	u32 slots = 0;
+
+	if (!IS_ENABLED(CONFIG_PCI_STATIC_ROOT_BUS) || !static_devices ||
+	    bus->dev->path.type != DEVICE_PATH_DOMAIN)
+		return 0xffffffff;
+
+	for (dev = static_devices; dev; dev = dev->sibling) {
+		if (dev->path.type == DEVICE_PATH_PCI)
+			slots |= 1u << PCI_SLOT(dev->path.pci.devfn);
+	}
+
+	return slots;
+}
+
 /**
  * Scan a PCI bus.
  *
@@ -1109,6 +1132,7 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 {
 	unsigned int devfn;
 	struct device *old_devices;
+	u32 slots;
 
 	printk(BIOS_DEBUG, "PCI: pci_scan_bus for bus %02x\n", bus->secondary);
 
@@ -1124,6 +1148,9 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 	old_devices = bus->children;
 	bus->children = NULL;
 
+	slots = pci_scan_slots(bus, old_devices);
+	bus->skipped_slots = 0;
+
 	post_code(0x24);
 
 	/*
@@ -1133,6 +1160,13 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 	for (devfn = min_devfn; devfn <= max_devfn; devfn++) {
 		struct device *dev;
 
+		/* Leave slots the devicetree doesn't know about for later. */
+		if (!(slots & (1u << PCI_SLOT(devfn)))) {
+			bus->skipped_slots |= 1u << PCI_SLOT(devfn);
+			devfn |= 0x07;
+			continue;
+		}
+
 		/* First thing setup the device structure. */
 		dev = pci_scan_get_dev(&old_devices, devfn);
 
@@ -1180,6 +1214,57 @@ void pci_scan_bus(struct bus *bus, unsigned min_devfn,
 	post_code(0x55);
 }
 
+/* Report devices in the slots that pci_scan_bus() skipped. */
+static void pci_check_skipped_slots(struct bus *bus)
+{
+	struct device dummy;
+	unsigned int slot;
+	u32 id;
+
+	dummy.bus = bus;
+	dummy.path.type = DEVICE_PATH_PCI;
+
+	for (slot = 0; slot < 32; slot++) {
+		if (!(bus->skipped_slots & (1u << slot)))
+			continue;
+
+		dummy.path.pci.devfn = PCI_DEVFN(slot, 0);
+		id = pci_read_config32(&dummy, PCI_VENDOR_ID);
+		if ((id == 0xffffffff) || (id == 0x00000000) ||
+		    (id == 0x0000ffff) || (id == 0xffff0000))
+			continue;
+
+		printk(BIOS_WARNING, "PCI: %s [%04x/%04x] is not in the "
+		       "devicetree and was not enumerated.\n",
+		       dev_path(&dummy), id & 0xffff, id >> 16);
+	}
+
+	bus->skipped_slots = 0;
+}
+
+static void pci_check_static_root_buses(void *unused)
+{
+	struct device *dev;
+	struct bus *link;
+
+	if (!IS_ENABLED(CONFIG_PCI_STATIC_ROOT_BUS))
+		return;
+
+	for (dev = all_devices; dev; dev = dev->next) {
+		if (dev->path.type != DEVICE_PATH_DOMAIN)
+			continue;
+		for (link = dev->link_list; link; link = link->next)
+			pci_check_skipped_slots(link);
+	}
+}
+
+/*
+ * Checking the skipped slots is left until the devices are initialized so
+ * that it doesn't hold up enumeration and resource allocation.
+ */
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, pci_check_static_root_buses,
+			NULL);
+
 typedef enum {
 	PCI_ROUTE_CLOSE,
 	PCI_ROUTE_SCAN,
@@ -438,10 +438,36 @@ static void pciexp_tune_dev(device_t dev)
 		pciexp_enable_aspm(root, root_cap, dev, cap);
 }
 
+/*
+ * Root and downstream ports only forward configuration requests for device 0
+ * to their link as long as ARI forwarding is off, which it is as coreboot
+ * never enables it. Probing the other 31 slots would just get 31 times
+ * the same "no device" answer from the port.
+ */
+static int pciexp_is_downstream_port(struct device *dev)
+{
+	unsigned int cap;
+	u16 type;
+
+	cap = pci_find_capability(dev, PCI_CAP_ID_PCIE);
+	if (!cap)
+		return 0;
+
+	type = (pci_read_config16(dev, cap + PCI_EXP_FLAGS) &
+		PCI_EXP_FLAGS_TYPE) >> 4;
+
+	return type == PCI_EXP_TYPE_ROOT_PORT ||
+		type == PCI_EXP_TYPE_DOWNSTREAM;
+}
+
 void pciexp_scan_bus(struct bus *bus, unsigned int min_devfn,
 			     unsigned int max_devfn)
 {
 	device_t child;
+
+	if (pciexp_is_downstream_port(bus->dev))
+		max_devfn = MIN(max_devfn, PCI_DEVFN(0, 7));
+
 	pci_scan_bus(bus, min_devfn, max_devfn);
 
 	for (child = bus->children; child; child = child->sibling) {
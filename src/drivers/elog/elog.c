@@ -42,6 +42,13 @@
 #endif
 
 #define NV_NEEDS_ERASE (~(size_t)0)
+
+#if IS_ENABLED(CONFIG_ELOG_PING_PONG)
+#define ELOG_BANKS 2
+#else
+#define ELOG_BANKS 1
+#endif
+
 /*
  * Static variables for ELOG state
  */
@@ -56,7 +63,19 @@ static u16 shrink_size;
 static size_t mirror_last_write;
 static size_t nv_last_write;
 
+/*
+ * The RW_ELOG area is split into ELOG_BANKS equally sized banks of which
+ * nv_dev covers the one holding the live log. With two banks a full log is
+ * compacted into the other, already erased, bank and the header written last
+ * commits the switch. The bank left behind is erased later in the boot
+ * instead of in the middle of adding an event.
+ */
+static struct region_device nv_area;
 static struct region_device nv_dev;
+static size_t nv_bank_size;
+static int nv_bank;
+static u8 nv_generation;
+static bool nv_stale_bank;
 /* Device that mirrors the eventlog in memory. */
 static struct mem_region_device mirror_dev;
 
@@ -440,7 +459,7 @@ static int elog_scan_flash(void)
 
 static void elog_write_header_in_mirror(void)
 {
-	static const struct elog_header header = {
+	struct elog_header header = {
 		.magic = ELOG_SIGNATURE,
 		.version = ELOG_VERSION,
 		.header_size = sizeof(struct elog_header),
@@ -450,6 +469,10 @@ static void elog_write_header_in_mirror(void)
 		},
 	};
 
+	/* The generation tells which of the two banks is the newer one. */
+	if (IS_ENABLED(CONFIG_ELOG_PING_PONG))
+		header.reserved[0] = ++nv_generation;
+
 	rdev_writeat(mirror_dev_get(), &header, 0, sizeof(header));
 	elog_mirror_increment_last_write(elog_events_start());
 }
@@ -655,11 +678,108 @@ int elog_clear(void)
 	return elog_prepare_empty();
 }
 
+static int elog_select_bank(int bank)
+{
+	elog_debug("ELOG: using bank %d\n", bank);
+
+	nv_bank = bank;
+	return rdev_chain(&nv_dev, &nv_area, bank * nv_bank_size,
+				nv_bank_size);
+}
+
+/*
+ * Read the header of a bank without touching the mirror. Returns 1 and the
+ * generation of the bank if it holds a log, 0 otherwise.
+ */
+static int elog_bank_header_valid(int bank, u8 *generation)
+{
+	struct elog_header header;
+
+	if (rdev_readat(&nv_area, &header, bank * nv_bank_size,
+			sizeof(header)) != sizeof(header))
+		return 0;
+
+	if (header.magic != ELOG_SIGNATURE ||
+	    header.version != ELOG_VERSION ||
+	    header.header_size != sizeof(header))
+		return 0;
+
+	*generation = header.reserved[0];
+	return 1;
+}
+
+/*
+ * Pick the bank holding the live log by only looking at the two headers.
+ * A valid header in the other bank means a compaction completed but the
+ * old bank hasn't been erased yet.
+ */
+static int elog_find_active_bank(void)
+{
+	u8 generation[2] = { 0, 0 };
+	int valid[2];
+	int bank;
+
+	valid[0] = elog_bank_header_valid(0, &generation[0]);
+	valid[1] = elog_bank_header_valid(1, &generation[1]);
+
+	if (valid[0] && valid[1])
+		bank = (s8)(generation[1] - generation[0]) > 0;
+	else
+		bank = valid[1];
+
+	nv_generation = generation[bank];
+	nv_stale_bank = valid[!bank];
+
+	return elog_select_bank(bank);
+}
+
+/* Check that the bank covered by nv_dev is fully erased. */
+static int elog_nv_is_erased(void)
+{
+	u8 buffer[64];
+	size_t offset;
+	size_t i;
+
+	for (offset = 0; offset < region_device_sz(&nv_dev);
+	     offset += sizeof(buffer)) {
+		if (rdev_readat(&nv_dev, buffer, offset, sizeof(buffer)) !=
+		    sizeof(buffer))
+			return 0;
+
+		for (i = 0; i < sizeof(buffer); i++) {
+			if (buffer[i] != ELOG_TYPE_EOL)
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+ * Move the log over to the other bank. It has normally been erased during
+ * a previous boot, so the switch only costs the writes of the compacted log.
+ */
+static int elog_nv_switch_bank(void)
+{
+	if (elog_select_bank(!nv_bank) < 0)
+		return -1;
+
+	if (!elog_nv_is_erased()) {
+		printk(BIOS_INFO, "ELOG: bank %d not erased.\n", nv_bank);
+		elog_nv_erase();
+	}
+
+	/* Once the new header hits the flash the old bank is stale. */
+	nv_stale_bank = true;
+
+	return 0;
+}
+
 static int elog_find_flash(void)
 {
 	size_t total_size;
 	size_t reserved_space = ELOG_MIN_AVAILABLE_ENTRIES * MAX_EVENT_SIZE;
-	struct region_device *rdev = &nv_dev;
+	struct region_device *rdev = &nv_area;
 
 	elog_debug("%s()\n", __func__);
 
@@ -669,9 +789,9 @@ static int elog_find_flash(void)
 		return -1;
 	}
 
-	if (region_device_sz(rdev) < 4*KiB) {
-		printk(BIOS_WARNING, "ELOG: Needs a minium size of 4KiB: %zu\n",
-			region_device_sz(rdev));
+	if (region_device_sz(rdev) < ELOG_BANKS * 4*KiB) {
+		printk(BIOS_WARNING, "ELOG: Needs a minium size of %dKiB: %zu\n",
+			ELOG_BANKS * 4, region_device_sz(rdev));
 		return -1;
 	}
 
@@ -679,8 +799,15 @@ static int elog_find_flash(void)
 		region_device_offset(rdev), region_device_sz(rdev));
 
 	/* Keep 4KiB max size until large malloc()s have been fixed. */
-	total_size = MIN(4*KiB, region_device_sz(rdev));
-	rdev_chain(rdev, rdev, 0, total_size);
+	total_size = MIN(4*KiB, region_device_sz(rdev) / ELOG_BANKS);
+	nv_bank_size = total_size;
+
+	if (IS_ENABLED(CONFIG_ELOG_PING_PONG)) {
+		if (elog_find_active_bank() < 0)
+			return -1;
+	} else if (elog_select_bank(0) < 0) {
+		return -1;
+	}
 
 	full_threshold = total_size - reserved_space;
 	shrink_size = total_size * ELOG_SHRINK_PERCENTAGE / 100;
@@ -707,13 +834,25 @@ static int elog_sync_to_nv(void)
 
 	/* Erase if necessary. */
 	if (erase_needed) {
-		elog_nv_erase();
+		if (!IS_ENABLED(CONFIG_ELOG_PING_PONG))
+			elog_nv_erase();
+		else if (elog_nv_switch_bank() < 0)
+			return -1;
 		elog_nv_reset_last_write();
 	}
 
 	size = elog_nv_region_to_update(&offset);
 
-	elog_nv_write(offset, size);
+	/*
+	 * Write the header of a new bank last. Should the copy be interrupted
+	 * the previous bank is still the one picked on the next boot.
+	 */
+	if (IS_ENABLED(CONFIG_ELOG_PING_PONG) && erase_needed) {
+		elog_nv_write(elog_events_start(), size - elog_events_start());
+		elog_nv_write(0, elog_events_start());
+	} else {
+		elog_nv_write(offset, size);
+	}
 	elog_nv_increment_last_write(size);
 
 	/*
@@ -931,3 +1070,32 @@ int elog_add_event_wake(u8 source, u32 instance)
 /* Make sure elog_init() runs at least once to log System Boot event. */
 static void elog_bs_init(void *unused) { elog_init(); }
 BOOT_STATE_INIT_ENTRY(BS_POST_DEVICE, BS_ON_ENTRY, elog_bs_init, NULL);
+
+#if IS_ENABLED(CONFIG_ELOG_PING_PONG)
+/*
+ * Erase the bank left behind by a compaction so the next one only needs to
+ * write. This is done once devices are up and not at all on S3 resume.
+ */
+static void elog_erase_stale_bank(void *unused)
+{
+	struct region_device stale;
+	int bank = !nv_bank;
+
+	if (elog_initialized != ELOG_INITIALIZED || !nv_stale_bank)
+		return;
+
+	if (rdev_chain(&stale, &nv_area, bank * nv_bank_size, nv_bank_size))
+		return;
+
+	printk(BIOS_INFO, "ELOG: erasing stale bank %d\n", bank);
+
+	if (rdev_eraseat(&stale, 0, nv_bank_size) != nv_bank_size) {
+		printk(BIOS_ERR, "ELOG: erase failure.\n");
+		return;
+	}
+
+	nv_stale_bank = false;
+}
+BOOT_STATE_INIT_ENTRY(BS_WRITE_TABLES, BS_ON_ENTRY, elog_erase_stale_bank,
+			NULL);
+#endif
@@ -159,3 +159,32 @@ void gic_enable(void)
 	val |= (ENABLE_GRP0 | ENABLE_GRP1);
 	gic_write(&gicc->ctlr, val);
 }
+
+void gic_irq_enable(unsigned int irq)
+{
+	struct gic *gic = gic_get();
+
+	gic_write(&gic->gicd->isenabler[irq / 32], 1 << (irq % 32));
+}
+
+void gic_irq_disable(unsigned int irq)
+{
+	struct gic *gic = gic_get();
+
+	gic_write(&gic->gicd->icenabler[irq / 32], 1 << (irq % 32));
+}
+
+/* The aliased registers give the secure world access to Group 1. */
+uint32_t gic_irq_ack(void)
+{
+	struct gic *gic = gic_get();
+
+	return gic_read(&gic->gicc->aiar);
+}
+
+void gic_irq_eoi(uint32_t iar)
+{
+	struct gic *gic = gic_get();
+
+	gic_write(&gic->gicc->aeoir, iar);
+}
@@ -17,6 +17,7 @@
 #define _BOOT_DEVICE_H_
 
 #include <commonlib/region.h>
+#include <rules.h>
 
 /*
  * Please note that the read-only boot device may not be coherent with
@@ -44,6 +45,26 @@ int boot_device_ro_subregion(const struct region *sub,
 int boot_device_rw_subregion(const struct region *sub,
 				struct region_device *subrd);
 
+#if IS_ENABLED(CONFIG_BOOT_DEVICE_RW_WRITEBACK) && ENV_RAMSTAGE
+/*
+ * Return a region_device on top of the read-write boot device which queues
+ * erases and writes in memory until boot_device_writeback_flush() is called.
+ */
+const struct region_device *boot_device_writeback(
+					const struct region_device *rw);
+
+/* Write out the queued updates. Later writes go straight to the device. */
+void boot_device_writeback_flush(void);
+#else
+static inline const struct region_device *boot_device_writeback(
+					const struct region_device *rw)
+{
+	return rw;
+}
+
+static inline void boot_device_writeback_flush(void) {}
+#endif
+
 /*
  * Initialize the boot device. This may be called multiple times within
  * a stage so boot device implementations should account for this behavior.
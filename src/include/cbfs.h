@@ -30,6 +30,30 @@ void *cbfs_boot_map_optionrom(uint16_t vendor, uint16_t device);
 void *cbfs_boot_load_stage_by_name(const char *name);
 /* Locate file by name and optional type. Return 0 on success. < 0 on error. */
 int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type);
+
+/* A located file whose data is checked by its loader as it is read, see
+ * the verify hooks of struct cbfs_locator. */
+struct cbfs_load_verify {
+	struct cbfsf fh;
+	const char *name;
+	/* NULL if there is nothing (left) to check. */
+	const struct cbfs_locator *locator;
+	struct cbfsf_hash hash;
+};
+
+/* Locate file by name and optional type like cbfs_boot_locate(), but leave
+ * checking its data to the caller, which passes |verify| to the functions
+ * loading it. Return 0 on success. < 0 on error. */
+int cbfs_boot_locate_for_load(struct cbfs_load_verify *verify,
+			      const char *name, uint32_t *type);
+/* Pass the next |size| bytes of the file data to the check. |verify| may
+ * be NULL. Return 0 on success. < 0 on error. */
+int cbfs_load_verify_extend(struct cbfs_load_verify *verify, const void *data,
+			    size_t size);
+/* Pass the last |size| bytes of the file data to the check, and finish it.
+ * |verify| may be NULL. Return 0 if the file may be used. < 0 otherwise. */
+int cbfs_load_verify_end(struct cbfs_load_verify *verify, const void *data,
+			 size_t size);
 /* Map file into memory leaking the mapping. Only should be used when
  * leaking mappings are a no-op. Returns NULL on error, else returns
  * the mapping and sets the size of the file. */
@@ -46,17 +70,22 @@ size_t cbfs_boot_load_struct(const char *name, void *buf, size_t buf_size);
  * large |buffer|, decompressing it according to |compression| in the process.
  * Returns the decompressed file size, or 0 on error.
  * LZMA files will be mapped for decompression. LZ4 files will be decompressed
- * in-place with the buffer size requirements outlined in compression.h. */
+ * in-place with the buffer size requirements outlined in compression.h.
+ * Unless |verify| is NULL, the loaded bytes are the end of its file and are
+ * checked with cbfs_load_verify_end() before they are decompressed. */
 size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
-	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression);
+	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression,
+	struct cbfs_load_verify *verify);
 
 /* Return the size and fill base of the memory pstage will occupy after
  * loaded.
  */
 size_t cbfs_prog_stage_section(struct prog *pstage, uintptr_t *base);
 
-/* Load stage into memory filling in prog. Return 0 on success. < 0 on error. */
-int cbfs_prog_stage_load(struct prog *prog);
+/* Load stage into memory filling in prog. The stage is checked through
+ * |verify| as it is read, if that is not NULL. Return 0 on success. < 0 on
+ * error. */
+int cbfs_prog_stage_load(struct prog *prog, struct cbfs_load_verify *verify);
 
 /*****************************************************************
  * Support structures and functions. Direct field access should  *
@@ -87,6 +116,15 @@ struct cbfs_locator {
 	void (*prepare)(void);
 	/* Returns 0 on successful fill of cbfs properties. */
 	int (*locate)(struct cbfs_props *props);
+	/* Optional, all three or none. Check every file found in the CBFS
+	 * this locator provided, once per stage, while its data is read:
+	 * verify_start() comes first, verify_extend() gets all of the data in
+	 * order and verify_finish() returns 0 if the file may be used. The
+	 * others return 0 on success. */
+	int (*verify_start)(struct cbfsf_hash *hash, const struct cbfsf *fh);
+	int (*verify_extend)(struct cbfsf_hash *hash, const void *data,
+			     size_t size);
+	int (*verify_finish)(struct cbfsf_hash *hash);
 };
 
 #endif
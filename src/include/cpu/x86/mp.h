@@ -128,9 +128,61 @@ int mp_run_on_aps(void (*func)(void), long expire_us);
 /* Like mp_run_on_aps() but also runs func on BSP. */
 int mp_run_on_all_cpus(void (*func)(void), long expire_us);
 
+/*
+ * Jobs are a more flexible way of handing work to the APs. A job runs
+ * func(arg) on a single AP and records the return value in result. Each AP
+ * has a queue of MP_JOB_QUEUE_SIZE outstanding jobs which it works through
+ * in order, so the BSP can hand out work and carry on until it needs the
+ * results. Like the functions above, only the BSP may queue jobs. The job
+ * object has to stay around until the job is done.
+ */
+#define MP_JOB_QUEUE_SIZE 8
+
+enum mp_job_state {
+	MP_JOB_IDLE = 0,
+	MP_JOB_QUEUED,
+	MP_JOB_RUNNING,
+	MP_JOB_DONE,
+};
+
+struct mp_job {
+	int (*func)(void *arg);
+	void *arg;
+	/* Return value of func once the job is done. */
+	int result;
+	/* Owned by the queue while the job isn't done. */
+	volatile int state;
+};
+
+/* Return the number of APs available to run jobs, indexed 1 to count. */
+int mp_get_num_aps(void);
+
+/* Queue the job on the AP with the given index. Returns < 0 on error, when
+ * the AP's queue is full or when the job is still queued or running, 0 on
+ * success. */
+int mp_queue_job(struct mp_job *job, int cpu, int (*func)(void *arg),
+		void *arg);
+
+/* Return 1 if the job has completed, 0 otherwise. */
+static inline int mp_job_done(const struct mp_job *job)
+{
+	return job->state == MP_JOB_DONE;
+}
+
+/* Wait for the job to complete. Returns < 0 on timeout, 0 on success. */
+int mp_wait_job(struct mp_job *job, long expire_us);
+
+/*
+ * Run func(arg) on all the APs and wait for them to complete. Returns < 0
+ * on timeout or if func returned < 0 on any AP, 0 on success. On failure,
+ * jobs that haven't started yet are taken back and the ones still running
+ * are waited for, so func is never left running with arg after this returns.
+ */
+int mp_run_job_on_aps(int (*func)(void *arg), void *arg, long expire_us);
+
 /*
  * Park all APs to prepare for OS boot. This is handled automatically
- * by the coreboot infrastructure.
+ * by the coreboot infrastructure. Jobs still queued are not run.
  */
 int mp_park_aps(void);
 
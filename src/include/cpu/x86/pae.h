@@ -1,7 +1,19 @@
 #ifndef CPU_X86_PAE_H
 #define CPU_X86_PAE_H
 
+#include <stdint.h>
+
 #define MAPPING_ERROR ((void *)0xffffffffUL)
 void *map_2M_page(unsigned long page);
 
+/*
+ * Map the 2MiB page at physical address |phys| at the 2MiB aligned address
+ * |slot| while keeping the rest of the 32-bit address space identity mapped.
+ * Mapping another page replaces the previous one, and unmap_2M_pages() turns
+ * paging off again. BSP only, and not to be mixed with map_2M_page().
+ * Returns the slot or MAPPING_ERROR.
+ */
+void *map_2M_page_at(uintptr_t slot, uint64_t phys);
+void unmap_2M_pages(void);
+
 #endif /* CPU_X86_PAE_H  */
@@ -93,6 +93,7 @@ struct bus {
 	uint16_t	subordinate;	/* max subordinate bus number */
 	unsigned char   cap;		/* PCi capability offset */
 	uint32_t	hcdn_reg;		/* For HyperTransport link  */
+	uint32_t	skipped_slots;	/* Slots not probed during the scan */
 
 	unsigned int	reset_needed : 1;
 	unsigned int	disable_relaxed_ordering : 1;
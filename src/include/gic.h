@@ -16,6 +16,8 @@
 #ifndef GIC_H
 #define GIC_H
 
+#include <stdint.h>
+
 #if IS_ENABLED(CONFIG_GIC)
 
 /* Initialize the GIC on the currently processor, including GICD and GICC. */
@@ -29,6 +31,18 @@ void *gicd_base(void);
 /* Return a pointer to the base of the GIC CPU mmio region. */
 void *gicc_base(void);
 
+/* Enable or disable forwarding of a single interrupt. */
+void gic_irq_enable(unsigned int irq);
+void gic_irq_disable(unsigned int irq);
+
+/*
+ * Acknowledge the highest priority pending Group 1 interrupt and return the
+ * GICC_IAR value to pass to gic_irq_eoi() once it has been handled. Group 1
+ * is used since gic_init() puts every interrupt into it.
+ */
+uint32_t gic_irq_ack(void);
+void gic_irq_eoi(uint32_t iar);
+
 #else /* CONFIG_GIC */
 
 static inline void gic_init(void) {}
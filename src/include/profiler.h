@@ -0,0 +1,44 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <rules.h>
+
+#if IS_ENABLED(CONFIG_SAMPLING_PROFILER) && ENV_RAMSTAGE
+
+/* Record the interrupted program counter. Called from interrupt context. */
+void profiler_add_sample(uintptr_t pc);
+
+/*
+ * Architecture hooks. arch_profiler_start() arranges for
+ * profiler_add_sample() to be called about every interval_us microseconds.
+ * Return 0 on success, < 0 if sampling isn't supported.
+ */
+int arch_profiler_start(unsigned int interval_us);
+void arch_profiler_stop(void);
+
+#if IS_ENABLED(CONFIG_ARCH_RAMSTAGE_X86_32)
+/* Return 1 if the NMI was raised by the profiler and has been handled. */
+int profiler_handle_nmi(uintptr_t pc);
+#endif
+
+#else
+
+static inline int profiler_handle_nmi(uintptr_t pc) { return 0; }
+
+#endif
+
+#endif /* PROFILER_H */
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+struct cbfs_load_verify;
+
 enum {
 	/* Last segment of program. Can be used to take different actions for
 	 * cache maintenance of a program load. */
@@ -131,6 +133,10 @@ static inline void prog_set_entry(struct prog *prog, void *e, void *arg)
 
 /* Locate the identified program to run. Return 0 on success. < 0 on error. */
 int prog_locate(struct prog *prog);
+/* Same as prog_locate(), but the program is checked while it is loaded,
+ * by passing |verify| to the loader, instead of being read an extra time
+ * here. */
+int prog_locate_load(struct prog *prog, struct cbfs_load_verify *verify);
 
 /* Run the program described by prog. */
 void prog_run(struct prog *prog);
@@ -193,10 +199,12 @@ void mirror_payload(struct prog *payload);
 /*
  * Set check_regions to true to check that the payload targets usable memory.
  * With this flag set, if it does not, the load will fail and this function
- * will return NULL.
+ * will return NULL. Unless |verify| is NULL, the payload is checked through it
+ * before it is loaded, see prog_locate_load().
  *
  * Defined in src/lib/selfboot.c
  */
-void *selfload(struct prog *payload, bool check_regions);
+void *selfload(struct prog *payload, bool check_regions,
+	       struct cbfs_load_verify *verify);
 
 #endif /* PROGRAM_LOADING_H */
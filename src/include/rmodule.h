@@ -51,11 +51,14 @@ int rmodule_calc_region(unsigned int region_alignment, size_t rmodule_size,
  * using dynamic cbmem because it uses the dynamic cbmem API to obtain
  * the backing store region for the stage. */
 struct prog;
+struct cbfs_load_verify;
 
 struct rmod_stage_load {
 	uint32_t cbmem_id;
 	struct prog *prog;
 	void *params;
+	/* Optional. Checks the stage as it is read, see prog_locate_load(). */
+	struct cbfs_load_verify *verify;
 };
 
 /* Both of the following functions return 0 on success, -1 on error. */
@@ -0,0 +1,49 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef STAGE_USAGE_H
+#define STAGE_USAGE_H
+
+#include <commonlib/stage_usage_serialized.h>
+#include <rules.h>
+#include <stddef.h>
+
+#if IS_ENABLED(CONFIG_DEBUG_STAGE_USAGE) && !ENV_SMM && !defined(__ROMCC__)
+
+/*
+ * Fill the unused part of the stack and the CBFS cache with a pattern, so
+ * stage_usage_record() can tell how much of them was touched. Called at the
+ * start of bootblock and ramstage.
+ */
+void stage_usage_paint(void);
+
+/*
+ * Record the usage of the stack and the CBFS cache in CBMEM. Called at the
+ * end of romstage while cache-as-RAM is still up, and of ramstage.
+ */
+void stage_usage_record(void);
+
+/* Record the usage of a region of the current stage if CBMEM is up. */
+void stage_usage_add(enum stage_usage_region region, size_t size,
+		     size_t used);
+
+#else
+
+static inline void stage_usage_paint(void) {}
+static inline void stage_usage_record(void) {}
+static inline void stage_usage_add(enum stage_usage_region region,
+				   size_t size, size_t used) {}
+
+#endif
+
+#endif /* STAGE_USAGE_H */
@@ -59,6 +59,9 @@ int thread_yield_microseconds(unsigned int microsecs);
 void thread_cooperate(void);
 void thread_prevent_coop(void);
 
+/* Return the id of the running thread, 0 for the boot thread. */
+int thread_current_id(void);
+
 static inline void thread_init_cpu_info_non_bsp(struct cpu_info *ci)
 {
 	ci->thread = NULL;
@@ -80,6 +83,7 @@ static inline int thread_yield_microseconds(unsigned int microsecs)
 }
 static inline void thread_cooperate(void) {}
 static inline void thread_prevent_coop(void) {}
+static inline int thread_current_id(void) { return 0; }
 struct cpu_info;
 static inline void thread_init_cpu_info_non_bsp(struct cpu_info *ci) { }
 #endif
@@ -18,6 +18,7 @@
 #define __TIMESTAMP_H__
 
 #include <commonlib/timestamp_serialized.h>
+#include <rules.h>
 
 #if IS_ENABLED(CONFIG_COLLECT_TIMESTAMPS) && (IS_ENABLED(CONFIG_EARLY_CBMEM_INIT) \
 	|| !defined(__PRE_RAM__))
@@ -57,6 +58,26 @@ uint32_t get_us_since_boot(void);
 #define get_us_since_boot() 0
 #endif
 
+#if IS_ENABLED(CONFIG_TIMESTAMP_SPANS) && ENV_RAMSTAGE
+/*
+ * Mark the beginning and end of a span of work. Begin/end pairs must nest
+ * within a thread. Every event is tagged with the CPU and cooperative thread
+ * it was recorded on; 'arg' is free for the caller to tell apart instances
+ * of the same id.
+ */
+void timestamp_span_begin(enum timestamp_id id, uint16_t arg);
+void timestamp_span_end(enum timestamp_id id, uint16_t arg);
+/*
+ * Store the recorded spans in CBMEM. Called by the boot state machine right
+ * before leaving coreboot; events recorded afterwards are discarded.
+ */
+void timestamp_span_merge(void);
+#else
+static inline void timestamp_span_begin(enum timestamp_id id, uint16_t arg) {}
+static inline void timestamp_span_end(enum timestamp_id id, uint16_t arg) {}
+static inline void timestamp_span_merge(void) {}
+#endif
+
 /**
  * Workaround for guard combination above.
  * Looks like CONFIG_EARLY_CBMEM_INIT selects
@@ -45,5 +45,6 @@ int boot_device_rw_subregion(const struct region *sub,
 	/* Ensure boot device has been initialized at least once. */
 	boot_device_init();
 
-	return boot_device_subregion(sub, subrd, boot_device_rw());
+	return boot_device_subregion(sub, subrd,
+					boot_device_writeback(boot_device_rw()));
 }
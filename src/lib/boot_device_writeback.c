@@ -0,0 +1,555 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <boot_device.h>
+#include <bootstate.h>
+#include <commonlib/helpers.h>
+#include <compiler.h>
+#include <console/console.h>
+#include <fmap.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * Write-back layer on top of the read-write boot device. Erases and writes
+ * issued during ramstage are applied to a copy of the affected erase blocks
+ * in memory and only hit the flash when the queue is flushed. That way each
+ * erase block is erased at most once per boot and all the programming is
+ * done back to back instead of at different points of the boot.
+ *
+ * The flush goes through a journal in its own FMAP area: the final contents
+ * of the dirty part of each block are written there first, followed by a
+ * commit word. Only then are the blocks erased and programmed in place, and
+ * a done word marks the journal as applied. If power is lost between the
+ * commit and the done word, the next ramstage replays the journal before
+ * anything reads the boot device through this layer. Replaying is
+ * idempotent: erased blocks are erased again and programming only clears
+ * bits. Stages before ramstage may see a torn block until then and rely on
+ * the checksums of their data, as they do without the write-back. When the
+ * queue doesn't fit the journal it is flushed in several rounds.
+ *
+ * Within a round the blocks are applied in the reverse order they were
+ * first touched, and within a block from the last page to the first, so
+ * the part of an update its users write first (region_file metadata, the
+ * elog header) tends to reach the flash last.
+ *
+ * Areas that must reach the flash right away, like the flash console, and
+ * everything after the flush go straight to the boot device.
+ */
+
+#define WB_BLOCK_SIZE		(4 * KiB)
+#define WB_PAGE_SIZE		256
+#define WB_ERASED		0xff
+
+#define WB_JOURNAL_MAGIC	0x4c4e524a	/* "JRNL" */
+#define WB_JOURNAL_COMMIT	0x54494d43	/* "CMIT" */
+#define WB_JOURNAL_DONE		0x454e4f44	/* "DONE" */
+#define WB_JOURNAL_UNSET	0xffffffff
+
+/* Start of the journal area. commit and done are programmed last. */
+struct wb_journal_header {
+	uint32_t magic;
+	/* Bytes of records following the header. */
+	uint32_t size;
+	uint32_t commit;
+	uint32_t done;
+} __packed;
+
+/* Followed by len bytes of data, padded to 4 bytes. */
+struct wb_journal_record {
+	uint32_t offset;
+	uint16_t start;
+	uint16_t len;
+	uint32_t erase;
+} __packed;
+
+struct wb_block {
+	/* Offset of the erase block on the boot device. */
+	size_t offset;
+	/* Erase the block before programming it. */
+	bool erase;
+	/* Contents of the block, only filled in once it is written to. */
+	uint8_t *data;
+	/* Range within the block that needs to be programmed. */
+	size_t dirty_start;
+	size_t dirty_end;
+};
+
+static struct wb_block wb_blocks[CONFIG_BOOT_DEVICE_RW_WRITEBACK_BLOCKS];
+/* One copy per tracked block, so queueing never needs the heap. */
+static uint8_t wb_data[CONFIG_BOOT_DEVICE_RW_WRITEBACK_BLOCKS][WB_BLOCK_SIZE];
+static size_t wb_num_blocks;
+static bool wb_flushed;
+
+static const struct region_device *wb_backing;
+static struct region_device wb_rdev;
+
+/* Areas written straight to the boot device, journal included. */
+static const char * const wb_bypass_names[] = {
+	"CONSOLE",
+	CONFIG_BOOT_DEVICE_RW_WRITEBACK_JOURNAL,
+};
+static struct region wb_bypass[ARRAY_SIZE(wb_bypass_names)];
+static size_t wb_num_bypass;
+
+static struct region wb_journal;
+static bool wb_have_journal;
+
+static bool wb_bypassed(size_t offset, size_t size)
+{
+	size_t i;
+
+	for (i = 0; i < wb_num_bypass; i++) {
+		const struct region *r = &wb_bypass[i];
+
+		if (offset < region_offset(r) + region_sz(r) &&
+		    region_offset(r) < offset + size)
+			return true;
+	}
+
+	return false;
+}
+
+static struct wb_block *wb_get_block(size_t offset)
+{
+	struct wb_block *blk;
+	size_t i;
+
+	for (i = 0; i < wb_num_blocks; i++) {
+		if (wb_blocks[i].offset == offset)
+			return &wb_blocks[i];
+	}
+
+	if (wb_num_blocks == ARRAY_SIZE(wb_blocks))
+		return NULL;
+
+	blk = &wb_blocks[wb_num_blocks++];
+	blk->offset = offset;
+	blk->erase = false;
+	blk->data = NULL;
+	blk->dirty_start = WB_BLOCK_SIZE;
+	blk->dirty_end = 0;
+
+	return blk;
+}
+
+/* Fill in the copy of a block. Returns < 0 if it can't be tracked. */
+static int wb_fill_block(struct wb_block *blk)
+{
+	if (blk->data != NULL)
+		return 0;
+
+	if (!blk->erase &&
+	    rdev_readat(wb_backing, wb_data[blk - wb_blocks], blk->offset,
+			WB_BLOCK_SIZE) != WB_BLOCK_SIZE)
+		return -1;
+
+	blk->data = wb_data[blk - wb_blocks];
+
+	if (blk->erase) {
+		memset(blk->data, WB_ERASED, WB_BLOCK_SIZE);
+		return 0;
+	}
+
+	return 0;
+}
+
+static ssize_t wb_readat(const struct region_device *rd, void *b,
+				size_t offset, size_t size)
+{
+	uint8_t *buffer = b;
+	size_t i;
+
+	if (wb_flushed)
+		return rdev_readat(wb_backing, b, offset, size);
+
+	if (rdev_readat(wb_backing, b, offset, size) != size)
+		return -1;
+
+	/* Overlay whatever is still queued up. */
+	for (i = 0; i < wb_num_blocks; i++) {
+		const struct wb_block *blk = &wb_blocks[i];
+		size_t start = MAX(offset, blk->offset);
+		size_t end = MIN(offset + size, blk->offset + WB_BLOCK_SIZE);
+
+		if (start >= end)
+			continue;
+
+		if (blk->data != NULL)
+			memcpy(&buffer[start - offset],
+				&blk->data[start - blk->offset], end - start);
+		else if (blk->erase)
+			memset(&buffer[start - offset], WB_ERASED, end - start);
+	}
+
+	return size;
+}
+
+static ssize_t wb_writeat(const struct region_device *rd, const void *b,
+				size_t offset, size_t size)
+{
+	const uint8_t *buffer = b;
+	size_t end = offset + size;
+
+	if (wb_flushed || wb_bypassed(offset, size))
+		return rdev_writeat(wb_backing, b, offset, size);
+
+	while (offset < end) {
+		size_t blk_offset = ALIGN_DOWN(offset, WB_BLOCK_SIZE);
+		size_t start = offset - blk_offset;
+		size_t len = MIN(end - offset, WB_BLOCK_SIZE - start);
+		struct wb_block *blk = wb_get_block(blk_offset);
+		size_t i;
+
+		if (blk == NULL || wb_fill_block(blk) < 0) {
+			/* A queued erase can't be reordered with this write. */
+			if (blk != NULL && blk->erase)
+				return -1;
+			if (rdev_writeat(wb_backing, buffer, offset, len) != len)
+				return -1;
+		} else {
+			/* Programming can only clear bits. */
+			for (i = 0; i < len; i++)
+				blk->data[start + i] &= buffer[i];
+			blk->dirty_start = MIN(blk->dirty_start, start);
+			blk->dirty_end = MAX(blk->dirty_end, start + len);
+		}
+
+		buffer += len;
+		offset += len;
+	}
+
+	return size;
+}
+
+static ssize_t wb_eraseat(const struct region_device *rd, size_t offset,
+				size_t size)
+{
+	size_t end = offset + size;
+
+	if (wb_flushed || wb_bypassed(offset, size))
+		return rdev_eraseat(wb_backing, offset, size);
+
+	if (!IS_ALIGNED(offset, WB_BLOCK_SIZE) ||
+	    !IS_ALIGNED(size, WB_BLOCK_SIZE)) {
+		printk(BIOS_ERR, "BOOT DEVICE: unaligned erase 0x%zx+0x%zx\n",
+			offset, size);
+		return -1;
+	}
+
+	for (; offset < end; offset += WB_BLOCK_SIZE) {
+		struct wb_block *blk = wb_get_block(offset);
+
+		if (blk == NULL) {
+			if (rdev_eraseat(wb_backing, offset, WB_BLOCK_SIZE) !=
+			    WB_BLOCK_SIZE)
+				return -1;
+			continue;
+		}
+
+		/* Anything written before is gone with the erase. */
+		blk->erase = true;
+		blk->dirty_start = WB_BLOCK_SIZE;
+		blk->dirty_end = 0;
+		if (blk->data != NULL)
+			memset(blk->data, WB_ERASED, WB_BLOCK_SIZE);
+	}
+
+	return size;
+}
+
+static void *wb_mmap(const struct region_device *rd, size_t offset,
+			size_t size)
+{
+	size_t i;
+
+	if (wb_flushed)
+		return rdev_mmap(wb_backing, offset, size);
+
+	/* Mappings would bypass the queue, so only allow untouched areas. */
+	for (i = 0; i < wb_num_blocks; i++) {
+		const struct wb_block *blk = &wb_blocks[i];
+
+		if (offset < blk->offset + WB_BLOCK_SIZE &&
+		    blk->offset < offset + size)
+			return NULL;
+	}
+
+	return rdev_mmap(wb_backing, offset, size);
+}
+
+static int wb_munmap(const struct region_device *rd, void *mapping)
+{
+	return rdev_munmap(wb_backing, mapping);
+}
+
+static const struct region_device_ops wb_rdev_ops = {
+	.mmap = wb_mmap,
+	.munmap = wb_munmap,
+	.readat = wb_readat,
+	.writeat = wb_writeat,
+	.eraseat = wb_eraseat,
+};
+
+/* Erase a block if asked to and program data[start, end) of it. */
+static int wb_apply(size_t offset, bool erase, const uint8_t *data,
+			size_t start, size_t end)
+{
+	size_t page;
+
+	if (erase &&
+	    rdev_eraseat(wb_backing, offset, WB_BLOCK_SIZE) != WB_BLOCK_SIZE) {
+		printk(BIOS_ERR, "BOOT DEVICE: erase failed at 0x%zx\n",
+			offset);
+		return -1;
+	}
+
+	for (; end > start; end = page) {
+		page = MAX(ALIGN_DOWN(end - 1, WB_PAGE_SIZE), start);
+
+		if (rdev_writeat(wb_backing, &data[page], offset + page,
+				 end - page) != end - page) {
+			printk(BIOS_ERR, "BOOT DEVICE: write failed at 0x%zx\n",
+				offset + page);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static int wb_journal_mark(size_t field, uint32_t value)
+{
+	return rdev_writeat(wb_backing, &value,
+			    region_offset(&wb_journal) + field,
+			    sizeof(value)) == sizeof(value) ? 0 : -1;
+}
+
+/* Finish a flush that was committed but interrupted before it was done. */
+static void wb_journal_replay(void)
+{
+	const size_t base = region_offset(&wb_journal);
+	struct wb_journal_header hdr;
+	uint8_t *data = wb_data[0];
+	size_t pos;
+	size_t end;
+
+	if (rdev_readat(wb_backing, &hdr, base, sizeof(hdr)) != sizeof(hdr))
+		return;
+
+	if (hdr.magic != WB_JOURNAL_MAGIC || hdr.commit != WB_JOURNAL_COMMIT ||
+	    hdr.done != WB_JOURNAL_UNSET ||
+	    hdr.size > region_sz(&wb_journal) - sizeof(hdr))
+		return;
+
+	printk(BIOS_NOTICE, "BOOT DEVICE: replaying interrupted flush.\n");
+
+	end = sizeof(hdr) + hdr.size;
+	for (pos = sizeof(hdr); pos < end;) {
+		struct wb_journal_record rec;
+
+		if (rdev_readat(wb_backing, &rec, base + pos, sizeof(rec)) !=
+		    sizeof(rec))
+			return;
+		pos += sizeof(rec);
+
+		if (!IS_ALIGNED(rec.offset, WB_BLOCK_SIZE) ||
+		    rec.start + rec.len > WB_BLOCK_SIZE ||
+		    pos + rec.len > end)
+			return;
+
+		if (rdev_readat(wb_backing, &data[rec.start], base + pos,
+				rec.len) != rec.len)
+			return;
+		pos += ALIGN_UP(rec.len, sizeof(uint32_t));
+
+		if (wb_apply(rec.offset, rec.erase, data, rec.start,
+			     rec.start + rec.len))
+			return;
+	}
+
+	wb_journal_mark(offsetof(struct wb_journal_header, done),
+			WB_JOURNAL_DONE);
+}
+
+const struct region_device *boot_device_writeback(
+					const struct region_device *rw)
+{
+	size_t i;
+
+	if (rw == NULL)
+		return NULL;
+
+	if (wb_backing == NULL) {
+		wb_backing = rw;
+		region_device_init(&wb_rdev, &wb_rdev_ops, 0,
+					region_device_sz(rw));
+
+		for (i = 0; i < ARRAY_SIZE(wb_bypass_names); i++) {
+			if (!fmap_locate_area(wb_bypass_names[i],
+					      &wb_bypass[wb_num_bypass]))
+				wb_num_bypass++;
+		}
+
+		if (fmap_locate_area(CONFIG_BOOT_DEVICE_RW_WRITEBACK_JOURNAL,
+				     &wb_journal) == 0 &&
+		    region_sz(&wb_journal) >= sizeof(struct wb_journal_header) +
+			sizeof(struct wb_journal_record) + WB_BLOCK_SIZE &&
+		    IS_ALIGNED(region_offset(&wb_journal), WB_BLOCK_SIZE) &&
+		    IS_ALIGNED(region_sz(&wb_journal), WB_BLOCK_SIZE)) {
+			wb_have_journal = true;
+			wb_journal_replay();
+		} else {
+			printk(BIOS_WARNING, "BOOT DEVICE: no usable '%s' "
+				"area, flushes are not power-loss safe.\n",
+				CONFIG_BOOT_DEVICE_RW_WRITEBACK_JOURNAL);
+		}
+	}
+
+	return &wb_rdev;
+}
+
+static size_t wb_dirty_len(const struct wb_block *blk)
+{
+	if (blk->data == NULL || blk->dirty_end <= blk->dirty_start)
+		return 0;
+
+	return blk->dirty_end - blk->dirty_start;
+}
+
+static size_t wb_record_size(const struct wb_block *blk)
+{
+	return sizeof(struct wb_journal_record) +
+		ALIGN_UP(wb_dirty_len(blk), sizeof(uint32_t));
+}
+
+/* Write the records for blocks [first, last) in flush order. */
+static int wb_journal_write(size_t first, size_t last)
+{
+	const size_t base = region_offset(&wb_journal);
+	struct wb_journal_header hdr;
+	size_t pos = sizeof(hdr);
+	size_t i;
+
+	for (i = last; i > first; i--)
+		pos += wb_record_size(&wb_blocks[i - 1]);
+
+	if (rdev_eraseat(wb_backing, base, ALIGN_UP(pos, WB_BLOCK_SIZE)) !=
+	    ALIGN_UP(pos, WB_BLOCK_SIZE))
+		return -1;
+
+	pos = sizeof(hdr);
+	for (i = last; i > first; i--) {
+		const struct wb_block *blk = &wb_blocks[i - 1];
+		struct wb_journal_record rec = {
+			.offset = blk->offset,
+			.start = wb_dirty_len(blk) ? blk->dirty_start : 0,
+			.len = wb_dirty_len(blk),
+			.erase = blk->erase,
+		};
+
+		if (rdev_writeat(wb_backing, &rec, base + pos, sizeof(rec)) !=
+		    sizeof(rec))
+			return -1;
+		if (rec.len && rdev_writeat(wb_backing, &blk->data[rec.start],
+				base + pos + sizeof(rec), rec.len) != rec.len)
+			return -1;
+
+		pos += wb_record_size(blk);
+	}
+
+	hdr.magic = WB_JOURNAL_MAGIC;
+	hdr.size = pos - sizeof(hdr);
+	hdr.commit = WB_JOURNAL_UNSET;
+	hdr.done = WB_JOURNAL_UNSET;
+	if (rdev_writeat(wb_backing, &hdr, base, sizeof(hdr)) != sizeof(hdr))
+		return -1;
+
+	/* The commit record: from here on the round gets replayed. */
+	return wb_journal_mark(offsetof(struct wb_journal_header, commit),
+			       WB_JOURNAL_COMMIT);
+}
+
+static void wb_flush_block(const struct wb_block *blk)
+{
+	size_t start = wb_dirty_len(blk) ? blk->dirty_start : 0;
+
+	wb_apply(blk->offset, blk->erase, blk->data, start,
+		 start + wb_dirty_len(blk));
+}
+
+void boot_device_writeback_flush(void)
+{
+	const size_t room = region_sz(&wb_journal) -
+		sizeof(struct wb_journal_header);
+	size_t erased = 0;
+	size_t rounds = 0;
+	size_t last;
+	size_t i;
+
+	if (wb_flushed)
+		return;
+
+	/* Everything from here on goes straight to the boot device. */
+	wb_flushed = true;
+
+	for (last = wb_num_blocks; last > 0; last = i) {
+		bool journaled = false;
+		size_t used = 0;
+
+		/* As many blocks as fit in the journal. */
+		for (i = last; i > 0 && wb_have_journal; i--) {
+			if (used + wb_record_size(&wb_blocks[i - 1]) > room)
+				break;
+			used += wb_record_size(&wb_blocks[i - 1]);
+		}
+		if (i == last)
+			i = last - 1;
+		else if (wb_journal_write(i, last) == 0)
+			journaled = true;
+		else
+			printk(BIOS_ERR, "BOOT DEVICE: journal write failed, "
+				"flushing in place.\n");
+
+		for (; last > i; last--) {
+			wb_flush_block(&wb_blocks[last - 1]);
+			erased += wb_blocks[last - 1].erase;
+		}
+
+		if (journaled)
+			wb_journal_mark(offsetof(struct wb_journal_header,
+					done), WB_JOURNAL_DONE);
+		rounds++;
+	}
+
+	if (wb_num_blocks)
+		printk(BIOS_DEBUG, "BOOT DEVICE: flushed %zu blocks in %zu "
+			"rounds, %zu erased.\n", wb_num_blocks, rounds, erased);
+
+	/* The copies may be stale from now on, so nothing may use them. */
+	for (i = 0; i < wb_num_blocks; i++)
+		wb_blocks[i].data = NULL;
+	wb_num_blocks = 0;
+}
+
+static void wb_flush(void *unused)
+{
+	boot_device_writeback_flush();
+}
+
+/*
+ * Leaving BS_OS_RESUME_CHECK is the last point common to normal boot and
+ * S3 resume and it comes after the MRC cache has been updated.
+ */
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME_CHECK, BS_ON_EXIT, wb_flush, NULL);
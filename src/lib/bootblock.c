@@ -20,6 +20,7 @@
 #include <delay.h>
 #include <pc80/mc146818rtc.h>
 #include <program_loading.h>
+#include <stage_usage.h>
 #include <symbols.h>
 #include <timestamp.h>
 
@@ -32,6 +33,8 @@ __attribute__((weak)) void bootblock_mainboard_init(void) { /* do nothing */ }
 
 asmlinkage void bootblock_main_with_timestamp(uint64_t base_timestamp)
 {
+	stage_usage_paint();
+
 	/* Initialize timestamps if we have TIMESTAMP region in memlayout.ld. */
 	if (IS_ENABLED(CONFIG_COLLECT_TIMESTAMPS) && _timestamp_size > 0)
 		timestamp_init(base_timestamp);
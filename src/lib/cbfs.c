@@ -14,6 +14,7 @@
  * GNU General Public License for more details.
  */
 
+#include <arch/early_variables.h>
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
@@ -35,41 +36,206 @@
 #define DEBUG(x...)
 #endif
 
-int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
+static const struct cbfs_locator *cbfs_boot_locator(struct cbfs_props *props);
+
+/*
+ * Files that passed their locator's verify() in this stage, so that looking
+ * up the same file again (VBT, option ROMs, SPD data, ...) does not hash its
+ * data a second time.
+ */
+#define CBFS_VERIFIED_FILES 8
+
+struct cbfs_verified_files {
+	struct {
+		size_t offset;	/* of the metadata on the boot device */
+		size_t size;	/* of the data */
+	} file[CBFS_VERIFIED_FILES];
+	size_t count;
+};
+
+static struct cbfs_verified_files cbfs_verified CAR_GLOBAL;
+
+static int cbfs_file_verified(const struct cbfsf *fh)
+{
+	struct cbfs_verified_files *v = car_get_var_ptr(&cbfs_verified);
+	size_t i;
+
+	for (i = 0; i < MIN(v->count, CBFS_VERIFIED_FILES); i++) {
+		if (v->file[i].offset == region_device_offset(&fh->metadata) &&
+		    v->file[i].size == region_device_sz(&fh->data))
+			return 1;
+	}
+
+	return 0;
+}
+
+static void cbfs_file_set_verified(const struct cbfsf *fh)
+{
+	struct cbfs_verified_files *v = car_get_var_ptr(&cbfs_verified);
+	size_t i = v->count++ % CBFS_VERIFIED_FILES;
+
+	v->file[i].offset = region_device_offset(&fh->metadata);
+	v->file[i].size = region_device_sz(&fh->data);
+}
+
+/*
+ * Start checking the file in |verify| with the locator's verify hooks,
+ * unless it already passed in this stage.
+ */
+static int cbfs_load_verify_start(struct cbfs_load_verify *verify,
+				  const struct cbfs_locator *locator)
+{
+	verify->locator = NULL;
+
+	if (locator->verify_start == NULL || cbfs_file_verified(&verify->fh))
+		return 0;
+
+	if (locator->verify_start(&verify->hash, &verify->fh)) {
+		ERROR("'%s' failed verification.\n", verify->name);
+		return -1;
+	}
+
+	verify->locator = locator;
+
+	return 0;
+}
+
+int cbfs_load_verify_extend(struct cbfs_load_verify *verify, const void *data,
+			    size_t size)
+{
+	if (verify == NULL || verify->locator == NULL)
+		return 0;
+
+	if (verify->locator->verify_extend(&verify->hash, data, size)) {
+		ERROR("'%s' failed verification.\n", verify->name);
+		return -1;
+	}
+
+	return 0;
+}
+
+int cbfs_load_verify_end(struct cbfs_load_verify *verify, const void *data,
+			 size_t size)
+{
+	const struct cbfs_locator *locator;
+
+	if (verify == NULL || verify->locator == NULL)
+		return 0;
+
+	locator = verify->locator;
+	verify->locator = NULL;
+
+	if ((size && locator->verify_extend(&verify->hash, data, size)) ||
+	    locator->verify_finish(&verify->hash)) {
+		ERROR("'%s' failed verification.\n", verify->name);
+		return -1;
+	}
+
+	cbfs_file_set_verified(&verify->fh);
+
+	return 0;
+}
+
+/* Locate a file without verifying it. Returns the locator that provided the
+ * CBFS on success, NULL on error. */
+static const struct cbfs_locator *cbfs_boot_locate_file(struct cbfsf *fh,
+					const char *name, uint32_t *type)
 {
 	struct region_device rdev;
 	const struct region_device *boot_dev;
+	const struct cbfs_locator *locator;
 	struct cbfs_props props;
 
-	if (cbfs_boot_region_properties(&props))
-		return -1;
+	locator = cbfs_boot_locator(&props);
+	if (locator == NULL)
+		return NULL;
 
 	/* All boot CBFS operations are performed using the RO devie. */
 	boot_dev = boot_device_ro();
 
 	if (boot_dev == NULL)
-		return -1;
+		return NULL;
 
 	if (rdev_chain(&rdev, boot_dev, props.offset, props.size))
+		return NULL;
+
+	if (cbfs_locate(fh, &rdev, name, type))
+		return NULL;
+
+	return locator;
+}
+
+int cbfs_boot_locate_for_load(struct cbfs_load_verify *verify,
+			      const char *name, uint32_t *type)
+{
+	const struct cbfs_locator *locator;
+
+	locator = cbfs_boot_locate_file(&verify->fh, name, type);
+	if (locator == NULL)
 		return -1;
 
-	return cbfs_locate(fh, &rdev, name, type);
+	verify->name = name;
+
+	return cbfs_load_verify_start(verify, locator);
+}
+
+int cbfs_boot_locate(struct cbfsf *fh, const char *name, uint32_t *type)
+{
+	struct cbfs_load_verify verify;
+	uint8_t buffer[1024];
+	size_t offset;
+	size_t size;
+
+	if (cbfs_boot_locate_for_load(&verify, name, type))
+		return -1;
+
+	*fh = verify.fh;
+
+	/* The caller reads the file itself later, so check it now. */
+	if (verify.locator == NULL)
+		return 0;
+
+	size = region_device_sz(&fh->data);
+
+	for (offset = 0; offset < size; offset += sizeof(buffer)) {
+		size_t block_sz = MIN(size - offset, sizeof(buffer));
+
+		if (rdev_readat(&fh->data, buffer, offset, block_sz) !=
+		    block_sz)
+			return -1;
+
+		if (cbfs_load_verify_extend(&verify, buffer, block_sz))
+			return -1;
+	}
+
+	return cbfs_load_verify_end(&verify, NULL, 0);
 }
 
 void *cbfs_boot_map_with_leak(const char *name, uint32_t type, size_t *size)
 {
-	struct cbfsf fh;
+	struct cbfs_load_verify verify;
 	size_t fsize;
+	void *map;
 
-	if (cbfs_boot_locate(&fh, name, &type))
+	if (cbfs_boot_locate_for_load(&verify, name, &type))
 		return NULL;
 
-	fsize = region_device_sz(&fh.data);
+	fsize = region_device_sz(&verify.fh.data);
+
+	map = rdev_mmap(&verify.fh.data, 0, fsize);
+	if (map == NULL)
+		return NULL;
+
+	/* Verify the mapping itself instead of reading the file twice. */
+	if (cbfs_load_verify_end(&verify, map, fsize)) {
+		rdev_munmap(&verify.fh.data, map);
+		return NULL;
+	}
 
 	if (size != NULL)
 		*size = fsize;
 
-	return rdev_mmap(&fh.data, 0, fsize);
+	return map;
 }
 
 int cbfs_locate_file_in_region(struct cbfsf *fh, const char *region_name,
@@ -87,7 +253,8 @@ int cbfs_locate_file_in_region(struct cbfsf *fh, const char *region_name,
 }
 
 size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
-	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression)
+	size_t in_size, void *buffer, size_t buffer_size, uint32_t compression,
+	struct cbfs_load_verify *verify)
 {
 	size_t out_size;
 
@@ -97,6 +264,8 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 			return 0;
 		if (rdev_readat(rdev, buffer, offset, in_size) != in_size)
 			return 0;
+		if (cbfs_load_verify_end(verify, buffer, in_size))
+			return 0;
 		return in_size;
 
 	case CBFS_COMPRESS_LZ4:
@@ -111,6 +280,8 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		void *compr_start = buffer + buffer_size - in_size;
 		if (rdev_readat(rdev, compr_start, offset, in_size) != in_size)
 			return 0;
+		if (cbfs_load_verify_end(verify, compr_start, in_size))
+			return 0;
 
 		timestamp_add_now(TS_START_ULZ4F);
 		out_size = ulz4fn(compr_start, in_size, buffer, buffer_size);
@@ -126,6 +297,10 @@ size_t cbfs_load_and_decompress(const struct region_device *rdev, size_t offset,
 		void *map = rdev_mmap(rdev, offset, in_size);
 		if (map == NULL)
 			return 0;
+		if (cbfs_load_verify_end(verify, map, in_size)) {
+			rdev_munmap(rdev, map);
+			return 0;
+		}
 
 		/* Note: timestamp not useful for memory-mapped media (x86) */
 		timestamp_add_now(TS_START_ULZMA);
@@ -166,17 +341,17 @@ void *cbfs_boot_map_optionrom(uint16_t vendor, uint16_t device)
 
 void *cbfs_boot_load_stage_by_name(const char *name)
 {
-	struct cbfsf fh;
+	struct cbfs_load_verify verify;
 	struct prog stage = PROG_INIT(PROG_UNKNOWN, name);
 	uint32_t type = CBFS_TYPE_STAGE;
 
-	if (cbfs_boot_locate(&fh, name, &type))
+	if (cbfs_boot_locate_for_load(&verify, name, &type))
 		return NULL;
 
 	/* Chain data portion in the prog. */
-	cbfs_file_data(prog_rdev(&stage), &fh);
+	cbfs_file_data(prog_rdev(&stage), &verify.fh);
 
-	if (cbfs_prog_stage_load(&stage))
+	if (cbfs_prog_stage_load(&stage, &verify))
 		return NULL;
 
 	return prog_entry(&stage);
@@ -184,21 +359,24 @@ void *cbfs_boot_load_stage_by_name(const char *name)
 
 size_t cbfs_boot_load_struct(const char *name, void *buf, size_t buf_size)
 {
-	struct cbfsf fh;
+	struct cbfs_load_verify verify;
 	uint32_t compression_algo;
 	size_t decompressed_size;
 	uint32_t type = CBFS_TYPE_STRUCT;
 
-	if (cbfs_boot_locate(&fh, name, &type) < 0)
+	if (cbfs_boot_locate_for_load(&verify, name, &type))
 		return 0;
 
-	if (cbfsf_decompression_info(&fh, &compression_algo,
+	if (cbfsf_decompression_info(&verify.fh, &compression_algo,
 				     &decompressed_size) < 0
 				     || decompressed_size > buf_size)
 		return 0;
 
-	return cbfs_load_and_decompress(&fh.data, 0, region_device_sz(&fh.data),
-					buf, buf_size, compression_algo);
+	/* The file is verified on the copy that gets decompressed. */
+	return cbfs_load_and_decompress(&verify.fh.data, 0,
+					region_device_sz(&verify.fh.data),
+					buf, buf_size, compression_algo,
+					&verify);
 }
 
 size_t cbfs_prog_stage_section(struct prog *pstage, uintptr_t *base)
@@ -213,7 +391,7 @@ size_t cbfs_prog_stage_section(struct prog *pstage, uintptr_t *base)
 	return stage.memlen;
 }
 
-int cbfs_prog_stage_load(struct prog *pstage)
+int cbfs_prog_stage_load(struct prog *pstage, struct cbfs_load_verify *verify)
 {
 	struct cbfs_stage stage;
 	uint8_t *load;
@@ -225,6 +403,10 @@ int cbfs_prog_stage_load(struct prog *pstage)
 	if (rdev_readat(fh, &stage, 0, sizeof(stage)) != sizeof(stage))
 		return -1;
 
+	/* The header starts the file data, the body that follows ends it. */
+	if (cbfs_load_verify_extend(verify, &stage, sizeof(stage)))
+		return -1;
+
 	fsize = region_device_sz(fh);
 	fsize -= sizeof(stage);
 	foffset = 0;
@@ -242,13 +424,21 @@ int cbfs_prog_stage_load(struct prog *pstage)
 	if (ENV_VERSTAGE && !IS_ENABLED(CONFIG_NO_XIP_EARLY_STAGES) &&
 	    IS_ENABLED(CONFIG_BOOT_DEVICE_MEMORY_MAPPED)) {
 		void *mapping = rdev_mmap(fh, foffset, fsize);
+		int ret = 0;
+
+		/* The stage runs from the mapping, so check it there. */
+		if (mapping == load)
+			ret = cbfs_load_verify_end(verify, mapping, fsize);
 		rdev_munmap(fh, mapping);
+		if (ret)
+			return -1;
 		if (mapping == load)
 			goto out;
 	}
 
 	fsize = cbfs_load_and_decompress(fh, foffset, fsize, load,
-					 stage.memlen, stage.compression);
+					 stage.memlen, stage.compression,
+					 verify);
 	if (!fsize)
 		return -1;
 
@@ -322,7 +512,7 @@ static const struct cbfs_locator *locators[] = {
 	&cbfs_master_header_locator,
 };
 
-int cbfs_boot_region_properties(struct cbfs_props *props)
+static const struct cbfs_locator *cbfs_boot_locator(struct cbfs_props *props)
 {
 	int i;
 
@@ -342,10 +532,18 @@ int cbfs_boot_region_properties(struct cbfs_props *props)
 		LOG("'%s' located CBFS at [%zx:%zx)\n",
 			ops->name, props->offset, props->offset + props->size);
 
-		return 0;
+		return ops;
 	}
 
-	return -1;
+	return NULL;
+}
+
+int cbfs_boot_region_properties(struct cbfs_props *props)
+{
+	if (cbfs_boot_locator(props) == NULL)
+		return -1;
+
+	return 0;
 }
 
 void cbfs_prepare_program_locate(void)
@@ -19,6 +19,7 @@
 #include <console/uart.h>
 #include <cbmem.h>
 #include <arch/early_variables.h>
+#include <stage_usage.h>
 #include <symbols.h>
 #include <string.h>
 
@@ -156,6 +157,14 @@ static void copy_console_buffer(struct cbmem_console *src_cons_p)
 	if (!src_cons_p)
 		return;
 
+	if (ENV_ROMSTAGE && (u8 *)src_cons_p == _preram_cbmem_console) {
+		c = (src_cons_p->cursor & OVERFLOW) ? src_cons_p->size :
+			src_cons_p->cursor & CURSOR_MASK;
+		stage_usage_add(STAGE_USAGE_CONSOLE,
+				_preram_cbmem_console_size,
+				sizeof(*src_cons_p) + c);
+	}
+
 	if (src_cons_p->cursor & OVERFLOW) {
 		const char overflow_warning[] = "\n*** Pre-CBMEM " ENV_STRING
 			" console overflowed, log truncated! ***\n";
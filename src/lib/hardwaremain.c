@@ -24,6 +24,7 @@
 #include <console/console.h>
 #include <console/post_codes.h>
 #include <cbmem.h>
+#include <stage_usage.h>
 #include <version.h>
 #include <device/device.h>
 #include <device/pci.h>
@@ -117,6 +118,17 @@ static struct boot_state boot_states[] = {
 
 void __attribute__((weak)) arch_bootstate_coreboot_exit(void) { }
 
+/*
+ * The run_state() functions of BS_OS_RESUME and BS_PAYLOAD_BOOT don't return,
+ * so close the span of the state here before the spans are stored.
+ */
+static void bs_exit_coreboot(boot_state_t id)
+{
+	timestamp_span_end(TS_SPAN_BOOT_STATE, id);
+	timestamp_span_merge();
+	arch_bootstate_coreboot_exit();
+}
+
 static boot_state_t bs_pre_device(void *arg)
 {
 	return BS_DEV_INIT_CHIPS;
@@ -200,7 +212,7 @@ static boot_state_t bs_os_resume_check(void *arg)
 static boot_state_t bs_os_resume(void *wake_vector)
 {
 #if IS_ENABLED(CONFIG_HAVE_ACPI_RESUME)
-	arch_bootstate_coreboot_exit();
+	bs_exit_coreboot(BS_OS_RESUME);
 	acpi_resume(wake_vector);
 #endif
 	return BS_WRITE_TABLES;
@@ -230,7 +242,7 @@ static boot_state_t bs_payload_load(void *arg)
 
 static boot_state_t bs_payload_boot(void *arg)
 {
-	arch_bootstate_coreboot_exit();
+	bs_exit_coreboot(BS_PAYLOAD_BOOT);
 	payload_run();
 
 	printk(BIOS_EMERG, "Boot failed\n");
@@ -300,7 +312,11 @@ static void bs_call_callbacks(struct boot_state *state,
 			printk(BIOS_DEBUG, "BS: callback (%p) @ %s.\n",
 				bscb, bscb->location);
 #endif
+			timestamp_span_begin(TS_SPAN_BS_CALLBACK,
+					     state - boot_states);
 			bscb->callback(bscb->arg);
+			timestamp_span_end(TS_SPAN_BS_CALLBACK,
+					   state - boot_states);
 			continue;
 		}
 
@@ -344,6 +360,8 @@ static void bs_walk_state_machine(void)
 			printk(BIOS_DEBUG, "BS: Entering %s state.\n",
 				state->name);
 
+		timestamp_span_begin(TS_SPAN_BOOT_STATE, state - boot_states);
+
 		bs_run_timers(0);
 
 		bs_sample_time(state);
@@ -380,6 +398,8 @@ static void bs_walk_state_machine(void)
 
 		bs_report_time(state);
 
+		timestamp_span_end(TS_SPAN_BOOT_STATE, state - boot_states);
+
 		state->complete = 1;
 	}
 }
@@ -435,6 +455,8 @@ static void boot_state_schedule_static_entries(void)
 
 void main(void)
 {
+	stage_usage_paint();
+
 	/*
 	 * We can generally jump between C and Ada code back and forth
 	 * without trouble. But since we don't have an Ada main() we
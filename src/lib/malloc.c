@@ -1,6 +1,8 @@
 #include <stdlib.h>
+#include <bootstate.h>
 #include <console/console.h>
 #include <cpu/x86/smm.h>
+#include <stage_usage.h>
 
 #if IS_ENABLED(CONFIG_DEBUG_MALLOC)
 #define MALLOCDBG(x...) printk(BIOS_SPEW, x)
@@ -46,3 +48,14 @@ void *malloc(size_t size)
 {
 	return memalign(sizeof(u64), size);
 }
+
+#if IS_ENABLED(CONFIG_DEBUG_STAGE_USAGE) && ENV_RAMSTAGE
+static void record_heap_usage(void *unused)
+{
+	stage_usage_add(STAGE_USAGE_HEAP, &_eheap - &_heap,
+			(unsigned char *)free_mem_ptr - &_heap);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, record_heap_usage, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, record_heap_usage, NULL);
+#endif
@@ -0,0 +1,86 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/profile_serialized.h>
+#include <console/console.h>
+#include <profiler.h>
+#include <stdint.h>
+#include <symbols.h>
+
+/*
+ * Samples are only ever added from the profiling interrupt, which doesn't
+ * nest, straight into the CBMEM entry allocated when profiling starts.
+ */
+static struct profile_samples *profile;
+static uint32_t profile_capacity;
+
+void profiler_add_sample(uintptr_t pc)
+{
+	if (profile->num_samples < profile_capacity)
+		profile->samples[profile->num_samples++] = pc;
+	else
+		profile->dropped++;
+}
+
+/* On resume the entry of the previous boot is found again and reused. */
+static void profiler_start(void *unused)
+{
+	const struct cbmem_entry *entry;
+
+	entry = cbmem_entry_add(CBMEM_ID_PROFILE, sizeof(*profile) +
+				CONFIG_SAMPLING_PROFILER_SAMPLES *
+				sizeof(profile->samples[0]));
+	if (entry == NULL) {
+		printk(BIOS_ERR, "ERROR: No room for profile samples\n");
+		return;
+	}
+
+	profile = cbmem_entry_start(entry);
+	profile_capacity = (cbmem_entry_size(entry) - sizeof(*profile)) /
+		sizeof(profile->samples[0]);
+
+	profile->program_base = (uintptr_t)_program;
+	profile->interval_us = CONFIG_SAMPLING_PROFILER_INTERVAL_US;
+	profile->num_samples = 0;
+	profile->dropped = 0;
+	profile->reserved = 0;
+
+	if (arch_profiler_start(CONFIG_SAMPLING_PROFILER_INTERVAL_US)) {
+		printk(BIOS_WARNING, "Sampling profiler not supported.\n");
+		cbmem_entry_remove(entry);
+		profile = NULL;
+		return;
+	}
+
+	printk(BIOS_DEBUG, "Sampling profiler: every %d us.\n",
+	       CONFIG_SAMPLING_PROFILER_INTERVAL_US);
+}
+
+static void profiler_stop(void *unused)
+{
+	if (profile == NULL)
+		return;
+
+	arch_profiler_stop();
+
+	printk(BIOS_DEBUG, "Sampling profiler: %u samples, %u dropped.\n",
+	       profile->num_samples, profile->dropped);
+
+	profile = NULL;
+}
+
+BOOT_STATE_INIT_ENTRY(BS_PRE_DEVICE, BS_ON_ENTRY, profiler_start, NULL);
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, profiler_stop, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, profiler_stop, NULL);
@@ -27,6 +27,7 @@
 #include <rmodule.h>
 #include <rules.h>
 #include <stage_cache.h>
+#include <stage_usage.h>
 #include <symbols.h>
 #include <timestamp.h>
 
@@ -48,17 +49,30 @@ int prog_locate(struct prog *prog)
 	return 0;
 }
 
+int prog_locate_load(struct prog *prog, struct cbfs_load_verify *verify)
+{
+	cbfs_prepare_program_locate();
+
+	if (cbfs_boot_locate_for_load(verify, prog_name(prog), NULL))
+		return -1;
+
+	cbfs_file_data(prog_rdev(prog), &verify->fh);
+
+	return 0;
+}
+
 void run_romstage(void)
 {
 	struct prog romstage =
 		PROG_INIT(PROG_ROMSTAGE, CONFIG_CBFS_PREFIX "/romstage");
+	struct cbfs_load_verify verify;
 
-	if (prog_locate(&romstage))
+	if (prog_locate_load(&romstage, &verify))
 		goto fail;
 
 	timestamp_add_now(TS_START_COPYROM);
 
-	if (cbfs_prog_stage_load(&romstage))
+	if (cbfs_prog_stage_load(&romstage, &verify))
 		goto fail;
 
 	timestamp_add_now(TS_END_COPYROM);
@@ -100,17 +114,31 @@ static void run_ramstage_from_resume(struct prog *ramstage)
 	ramstage_cache_invalid();
 }
 
-static int load_relocatable_ramstage(struct prog *ramstage)
+static void run_ramstage_from_warm_cache(struct prog *ramstage)
+{
+	/* Leaves the entry point NULL if nothing valid was cached. */
+	stage_cache_load_stage(STAGE_RAMSTAGE, ramstage);
+
+	if (prog_entry(ramstage) != NULL) {
+		printk(BIOS_DEBUG, "Jumping to cached ramstage.\n");
+		prog_run(ramstage);
+	}
+}
+
+static int load_relocatable_ramstage(struct prog *ramstage,
+				     struct cbfs_load_verify *verify)
 {
 	struct rmod_stage_load rmod_ram = {
 		.cbmem_id = CBMEM_ID_RAMSTAGE,
 		.prog = ramstage,
+		.verify = verify,
 	};
 
 	return rmodule_stage_load(&rmod_ram);
 }
 
-static int load_nonrelocatable_ramstage(struct prog *ramstage)
+static int load_nonrelocatable_ramstage(struct prog *ramstage,
+					struct cbfs_load_verify *verify)
 {
 	if (IS_ENABLED(CONFIG_HAVE_ACPI_RESUME)) {
 		uintptr_t base = 0;
@@ -119,13 +147,14 @@ static int load_nonrelocatable_ramstage(struct prog *ramstage)
 			backup_ramstage_section(base, size);
 	}
 
-	return cbfs_prog_stage_load(ramstage);
+	return cbfs_prog_stage_load(ramstage, verify);
 }
 
 void run_ramstage(void)
 {
 	struct prog ramstage =
 		PROG_INIT(PROG_RAMSTAGE, CONFIG_CBFS_PREFIX "/ramstage");
+	struct cbfs_load_verify verify;
 
 	timestamp_add_now(TS_END_ROMSTAGE);
 
@@ -138,21 +167,28 @@ void run_ramstage(void)
 	    IS_ENABLED(CONFIG_EARLY_CBMEM_INIT))
 		run_ramstage_from_resume(&ramstage);
 
-	if (prog_locate(&ramstage))
+	if (IS_ENABLED(CONFIG_WARM_REBOOT_STAGE_CACHE))
+		run_ramstage_from_warm_cache(&ramstage);
+
+	if (prog_locate_load(&ramstage, &verify))
 		goto fail;
 
 	timestamp_add_now(TS_START_COPYRAM);
 
 	if (IS_ENABLED(CONFIG_RELOCATABLE_RAMSTAGE)) {
-		if (load_relocatable_ramstage(&ramstage))
+		if (load_relocatable_ramstage(&ramstage, &verify))
 			goto fail;
-	} else if (load_nonrelocatable_ramstage(&ramstage))
+	} else if (load_nonrelocatable_ramstage(&ramstage, &verify))
 		goto fail;
 
 	stage_cache_add(STAGE_RAMSTAGE, &ramstage);
 
 	timestamp_add_now(TS_END_COPYRAM);
 
+	/* x86 records it in run_postcar_phase() while CAR is still up. */
+	if (!IS_ENABLED(CONFIG_ARCH_X86))
+		stage_usage_record();
+
 	prog_run(&ramstage);
 
 fail:
@@ -171,16 +207,17 @@ void __attribute__((weak)) mirror_payload(struct prog *payload)
 void payload_load(void)
 {
 	struct prog *payload = &global_payload;
+	struct cbfs_load_verify verify;
 
 	timestamp_add_now(TS_LOAD_PAYLOAD);
 
-	if (prog_locate(payload))
+	if (prog_locate_load(payload, &verify))
 		goto out;
 
 	mirror_payload(payload);
 
 	/* Pass cbtables to payload if architecture desires it. */
-	prog_set_entry(payload, selfload(payload, true),
+	prog_set_entry(payload, selfload(payload, true, &verify),
 			cbmem_find(CBMEM_ID_CBTABLE));
 
 out:
@@ -13,6 +13,8 @@
  * GNU General Public License for more details.
  */
 
+#include <arch/early_variables.h>
+#include <cbmem.h>
 #include <commonlib/helpers.h>
 #include <console/console.h>
 #include <region_file.h>
@@ -149,6 +151,185 @@ static void find_latest_slot(struct metadata_block *mb, struct region_file *f)
 	f->slot += i;
 }
 
+/*
+ * The slot with the latest update can be remembered to skip the search on
+ * later lookups. Hints are matched by the size of the region and of its
+ * metadata only, as the same file may be accessed through region devices
+ * with different offsets. That's fine because a hint is only taken after
+ * checking it against the metadata.
+ */
+#define REGF_HINTS	4
+
+struct regf_hint {
+	uint32_t region_size;
+	uint16_t metadata_blocks;
+	uint16_t slot;
+};
+
+struct regf_hints {
+	struct regf_hint entries[REGF_HINTS];
+};
+
+/* Romstage looks up the MRC cache before CBMEM is available. */
+static struct regf_hints regf_car_hints CAR_GLOBAL;
+
+static struct regf_hints *regf_hints_get(void)
+{
+	if (!IS_ENABLED(CONFIG_REGION_FILE_HINTS))
+		return NULL;
+
+	if (ENV_ROMSTAGE)
+		return car_get_var_ptr(&regf_car_hints);
+
+	if (ENV_RAMSTAGE)
+		return cbmem_find(CBMEM_ID_REGF_HINTS);
+
+	return NULL;
+}
+
+static struct regf_hint *regf_hint_find(struct regf_hints *hints,
+					const struct region_file *f)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(hints->entries); i++) {
+		struct regf_hint *h = &hints->entries[i];
+
+		if (h->region_size == region_device_sz(&f->rdev) &&
+		    h->metadata_blocks ==
+				bytes_to_block(region_device_sz(&f->metadata)))
+			return h;
+	}
+
+	return NULL;
+}
+
+static void regf_hint_store(struct regf_hints *hints, const struct regf_hint *n)
+{
+	struct regf_hint *h = NULL;
+	size_t i;
+
+	for (i = 0; i < ARRAY_SIZE(hints->entries); i++) {
+		h = &hints->entries[i];
+		if (h->region_size == 0 ||
+		    (h->region_size == n->region_size &&
+		     h->metadata_blocks == n->metadata_blocks))
+			break;
+	}
+
+	/* Evict the oldest one. */
+	if (i == ARRAY_SIZE(hints->entries)) {
+		memmove(&hints->entries[0], &hints->entries[1],
+			sizeof(hints->entries) - sizeof(hints->entries[0]));
+		h = &hints->entries[ARRAY_SIZE(hints->entries) - 1];
+	}
+
+	*h = *n;
+}
+
+static void region_file_set_hint(const struct region_file *f)
+{
+	struct regf_hints *hints = regf_hints_get();
+	struct regf_hint h;
+
+	if (hints == NULL || f->slot <= RF_ONLY_METADATA)
+		return;
+
+	h.region_size = region_device_sz(&f->rdev);
+	h.metadata_blocks = bytes_to_block(region_device_sz(&f->metadata));
+	h.slot = f->slot;
+	regf_hint_store(hints, &h);
+}
+
+static void regf_hints_sync(int is_recovery)
+{
+	struct regf_hints *car_hints = car_get_var_ptr(&regf_car_hints);
+	struct regf_hints *hints;
+	size_t i;
+
+	if (!IS_ENABLED(CONFIG_REGION_FILE_HINTS))
+		return;
+
+	hints = cbmem_add(CBMEM_ID_REGF_HINTS, sizeof(*hints));
+	if (hints == NULL)
+		return;
+
+	/* Hints of the previous boot are only good across S3 resume. */
+	if (!is_recovery)
+		memset(hints, 0, sizeof(*hints));
+
+	for (i = 0; i < ARRAY_SIZE(car_hints->entries); i++) {
+		if (car_hints->entries[i].region_size != 0)
+			regf_hint_store(hints, &car_hints->entries[i]);
+	}
+}
+
+ROMSTAGE_CBMEM_INIT_HOOK(regf_hints_sync)
+
+static int region_file_check_data_boundaries(struct region_file *f)
+{
+	/* All used blocks should be incrementing from previous write. */
+	if (region_file_data_begin(f) >= region_file_data_end(f)) {
+		printk(BIOS_ERR, "REGF data boundaries wrong. [%zd,%zd) Need to empty.\n",
+			region_file_data_begin(f), region_file_data_end(f));
+		f->slot = RF_NEED_TO_EMPTY;
+		return 0;
+	}
+
+	/* Ensure data doesn't exceed the region. */
+	if (region_file_data_end(f) >
+		bytes_to_block(region_device_sz(&f->rdev))) {
+		printk(BIOS_ERR, "REGF data exceeds region %zd > %zd\n",
+			region_file_data_end(f),
+			bytes_to_block(region_device_sz(&f->rdev)));
+		f->slot = RF_NEED_TO_EMPTY;
+	}
+
+	return 0;
+}
+
+/*
+ * Check the remembered slot with a single read covering it and its
+ * neighbours: it's the latest one if it is allocated and the following
+ * one isn't. Returns 0 if the hint was taken, < 0 otherwise.
+ */
+static int region_file_use_hint(struct region_file *f)
+{
+	struct regf_hints *hints = regf_hints_get();
+	const struct regf_hint *h;
+	size_t metadata_slots;
+	uint16_t blocks[3];
+	size_t count;
+
+	if (hints == NULL)
+		return -1;
+
+	h = regf_hint_find(hints, f);
+	if (h == NULL || h->slot == RF_ONLY_METADATA)
+		return -1;
+
+	metadata_slots = region_device_sz(&f->metadata) / sizeof(uint16_t);
+	if (h->slot >= metadata_slots)
+		return -1;
+
+	count = MIN(ARRAY_SIZE(blocks), metadata_slots - (h->slot - 1));
+	if (rdev_readat(&f->metadata, blocks, (h->slot - 1) * sizeof(blocks[0]),
+			count * sizeof(blocks[0])) < 0)
+		return -1;
+
+	if (block_offset_unallocated(blocks[1]))
+		return -1;
+
+	if (count == ARRAY_SIZE(blocks) && !block_offset_unallocated(blocks[2]))
+		return -1;
+
+	f->slot = h->slot;
+	f->data_blocks[0] = blocks[0];
+	f->data_blocks[1] = blocks[1];
+
+	return region_file_check_data_boundaries(f);
+}
+
 static int fill_data_boundaries(struct region_file *f)
 {
 	struct region_device slots;
@@ -176,24 +357,7 @@ static int fill_data_boundaries(struct region_file *f)
 		return -1;
 	}
 
-	/* All used blocks should be incrementing from previous write. */
-	if (region_file_data_begin(f) >= region_file_data_end(f)) {
-		printk(BIOS_ERR, "REGF data boundaries wrong. [%zd,%zd) Need to empty.\n",
-			region_file_data_begin(f), region_file_data_end(f));
-		f->slot = RF_NEED_TO_EMPTY;
-		return 0;
-	}
-
-	/* Ensure data doesn't exceed the region. */
-	if (region_file_data_end(f) >
-		bytes_to_block(region_device_sz(&f->rdev))) {
-		printk(BIOS_ERR, "REGF data exceeds region %zd > %zd\n",
-			region_file_data_end(f),
-			bytes_to_block(region_device_sz(&f->rdev)));
-		f->slot = RF_NEED_TO_EMPTY;
-	}
-
-	return 0;
+	return region_file_check_data_boundaries(f);
 }
 
 int region_file_init(struct region_file *f, const struct region_device *p)
@@ -234,6 +398,10 @@ int region_file_init(struct region_file *f, const struct region_device *p)
 		return 0;
 	}
 
+	/* A remembered slot saves searching the metadata blocks. */
+	if (region_file_use_hint(f) == 0)
+		return 0;
+
 	/* Locate latest metadata block with latest update. */
 	if (find_latest_mb(&mb, mb.blocks[0], f)) {
 		printk(BIOS_ERR, "REGF fail locating latest metadata block.\n");
@@ -250,6 +418,8 @@ int region_file_init(struct region_file *f, const struct region_device *p)
 		return -1;
 	}
 
+	region_file_set_hint(f);
+
 	return 0;
 }
 
@@ -431,6 +601,8 @@ static int handle_update(struct region_file *f, size_t blocks, const void *buf,
 		return -1;
 	}
 
+	region_file_set_hint(f);
+
 	return 0;
 }
 
@@ -14,6 +14,7 @@
  */
 
 #include <arch/cache.h>
+#include <boot_device.h>
 #include <console/console.h>
 #include <halt.h>
 #include <reset.h>
@@ -35,6 +36,7 @@ __attribute__((weak)) void soc_reset_prepare(enum reset_type rt) { /* no-op */ }
 void global_reset(void)
 {
 	printk(BIOS_INFO, "%s() called!\n", __func__);
+	boot_device_writeback_flush();
 	soc_reset_prepare(GLOBAL_RESET);
 	dcache_clean_all();
 	do_global_reset();
@@ -44,6 +46,7 @@ void global_reset(void)
 void hard_reset(void)
 {
 	printk(BIOS_INFO, "%s() called!\n", __func__);
+	boot_device_writeback_flush();
 	soc_reset_prepare(HARD_RESET);
 	dcache_clean_all();
 	__hard_reset();
@@ -52,6 +55,7 @@ void hard_reset(void)
 void soft_reset(void)
 {
 	printk(BIOS_INFO, "%s() called!\n", __func__);
+	boot_device_writeback_flush();
 	soc_reset_prepare(SOFT_RESET);
 	dcache_clean_all();
 	do_soft_reset();
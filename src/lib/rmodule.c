@@ -268,6 +268,9 @@ int rmodule_stage_load(struct rmod_stage_load *rsl)
 	if (rdev_readat(fh, &stage, 0, sizeof(stage)) != sizeof(stage))
 		return -1;
 
+	if (cbfs_load_verify_extend(rsl->verify, &stage, sizeof(stage)))
+		return -1;
+
 	rmodule_offset =
 		rmodule_calc_region(DYN_CBMEM_ALIGN_SIZE,
 				    stage.memlen, &region_size, &load_offset);
@@ -283,7 +286,8 @@ int rmodule_stage_load(struct rmod_stage_load *rsl)
 	       prog_name(rsl->prog), rmod_loc, stage.memlen);
 
 	if (!cbfs_load_and_decompress(fh, sizeof(stage), stage.len, rmod_loc,
-				      stage.memlen, stage.compression))
+				      stage.memlen, stage.compression,
+				      rsl->verify))
 		return -1;
 
 	if (rmodule_parse(rmod_loc, &rmod_stage))
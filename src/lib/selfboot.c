@@ -512,7 +512,8 @@ static int load_self_segments(struct segment *head, struct prog *payload,
 	return 1;
 }
 
-void *selfload(struct prog *payload, bool check_regions)
+void *selfload(struct prog *payload, bool check_regions,
+	       struct cbfs_load_verify *verify)
 {
 	uintptr_t entry = 0;
 	struct segment head;
@@ -523,6 +524,10 @@ void *selfload(struct prog *payload, bool check_regions)
 	if (data == NULL)
 		return NULL;
 
+	/* The segments are loaded from this mapping, so check it. */
+	if (cbfs_load_verify_end(verify, data, prog_size(payload)))
+		goto out;
+
 	/* Preprocess the self segments */
 	if (!build_self_segment_list(&head, data, &entry))
 		goto out;
@@ -0,0 +1,221 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <stage_usage.h>
+#include <stdint.h>
+#include <string.h>
+#include <symbols.h>
+#if IS_ENABLED(CONFIG_ARCH_X86)
+#include <arch/symbols.h>
+#endif
+
+/* Same pattern c_start.S fills the ramstage stacks with. */
+#define USAGE_PATTERN		0xdeadbeef
+/* Room left for the frames of the painting code itself. */
+#define USAGE_STACK_MARGIN	512
+#define USAGE_MAX_ENTRIES	16
+
+#define HAS_CBMEM (ENV_ROMSTAGE || ENV_RAMSTAGE)
+
+DECLARE_OPTIONAL_REGION(preram_cbfs_cache);
+DECLARE_OPTIONAL_REGION(postram_cbfs_cache);
+
+static void stack_region(uintptr_t *base, size_t *size)
+{
+	*base = 0;
+	*size = 0;
+
+	if (ENV_RAMSTAGE) {
+		/* Like checkstack(), only the stack of the BSP. */
+		*size = CONFIG_STACK_SIZE ? CONFIG_STACK_SIZE : _stack_size;
+		*base = (uintptr_t)_estack - *size;
+		return;
+	}
+
+#if IS_ENABLED(CONFIG_ARCH_X86)
+	/* Without a C bootblock the CAR stack is set up by romcc code. */
+#if IS_ENABLED(CONFIG_C_ENVIRONMENT_BOOTBLOCK)
+	*base = (uintptr_t)_car_stack_start;
+	*size = _car_stack_size;
+#endif
+#else
+	*base = (uintptr_t)_stack;
+	*size = _stack_size;
+#endif
+}
+
+static void cbfs_cache_region(uintptr_t *base, size_t *size)
+{
+	if (ENV_RAMSTAGE) {
+		*base = (uintptr_t)_postram_cbfs_cache;
+		*size = _postram_cbfs_cache_size;
+	} else {
+		*base = (uintptr_t)_preram_cbfs_cache;
+		*size = _preram_cbfs_cache_size;
+	}
+}
+
+static void paint(uintptr_t start, uintptr_t end)
+{
+	uint32_t *p;
+
+	start = ALIGN_UP(start, sizeof(*p));
+	end = ALIGN_DOWN(end, sizeof(*p));
+
+	for (p = (uint32_t *)start; (uintptr_t)p < end; p++)
+		*p = USAGE_PATTERN;
+}
+
+/* Bytes at the start of a region that still hold the pattern. */
+static size_t untouched_from_start(uintptr_t base, size_t size)
+{
+	const uint32_t *p = (const uint32_t *)ALIGN_UP(base, sizeof(*p));
+	const uint32_t *end = (const uint32_t *)ALIGN_DOWN(base + size,
+							  sizeof(*p));
+
+	while (p < end && *p == USAGE_PATTERN)
+		p++;
+
+	return (uintptr_t)p - base;
+}
+
+/* Bytes at the end of a region that still hold the pattern. */
+static size_t untouched_from_end(uintptr_t base, size_t size)
+{
+	const uint32_t *start = (const uint32_t *)ALIGN_UP(base,
+							   sizeof(*start));
+	const uint32_t *p = (const uint32_t *)ALIGN_DOWN(base + size,
+							 sizeof(*p));
+
+	while (p > start && p[-1] == USAGE_PATTERN)
+		p--;
+
+	return base + size - (uintptr_t)p;
+}
+
+void stage_usage_paint(void)
+{
+	uintptr_t here = (uintptr_t)&here;
+	uintptr_t base;
+	size_t size;
+
+	/*
+	 * The stack grows down, so everything below the current frame is
+	 * free. Leave some room for the frames of this function.
+	 */
+	stack_region(&base, &size);
+	if (size && here > base + USAGE_STACK_MARGIN && here <= base + size)
+		paint(base, here - USAGE_STACK_MARGIN);
+
+	/* The CBFS cache is handed out from the bottom up. */
+	cbfs_cache_region(&base, &size);
+	if (size)
+		paint(base, base + size);
+}
+
+static struct stage_usage_table *usage_table(void)
+{
+	struct stage_usage_table *table;
+
+	table = cbmem_find(CBMEM_ID_STAGE_USAGE);
+	if (table != NULL)
+		return table;
+
+	table = cbmem_add(CBMEM_ID_STAGE_USAGE, sizeof(*table) +
+			  USAGE_MAX_ENTRIES * sizeof(table->entries[0]));
+	if (table == NULL)
+		return NULL;
+
+	table->max_entries = USAGE_MAX_ENTRIES;
+	table->num_entries = 0;
+
+	return table;
+}
+
+void stage_usage_add(enum stage_usage_region region, size_t size,
+		     size_t used)
+{
+	struct stage_usage_table *table;
+	struct stage_usage_entry *e;
+	uint8_t stage = ENV_RAMSTAGE ? STAGE_USAGE_RAMSTAGE :
+				       STAGE_USAGE_ROMSTAGE;
+	uint32_t i;
+
+	if (!HAS_CBMEM || size == 0)
+		return;
+
+	table = usage_table();
+	if (table == NULL)
+		return;
+
+	/* On resume the entries of the boot are kept and only raised. */
+	for (i = 0; i < table->num_entries; i++) {
+		e = &table->entries[i];
+		if (e->stage == stage && e->region == region)
+			break;
+	}
+
+	if (i == table->num_entries) {
+		if (table->num_entries == table->max_entries)
+			return;
+		e = &table->entries[table->num_entries++];
+		e->stage = stage;
+		e->region = region;
+		e->reserved = 0;
+		e->used = 0;
+	}
+
+	e->size = size;
+	e->used = MAX(e->used, MIN(used, size));
+
+	printk(BIOS_DEBUG, "Stage usage: region %d: %zu of %zu bytes\n",
+	       region, MIN(used, size), size);
+}
+
+void stage_usage_record(void)
+{
+	uintptr_t base;
+	size_t size;
+
+	stack_region(&base, &size);
+	if (size)
+		stage_usage_add(STAGE_USAGE_STACK, size,
+				size - untouched_from_start(base, size));
+
+	cbfs_cache_region(&base, &size);
+	if (size)
+		stage_usage_add(STAGE_USAGE_CBFS_CACHE, size,
+				size - untouched_from_end(base, size));
+
+#if IS_ENABLED(CONFIG_ARCH_X86)
+	/* The part of CAR allocated at link time, the stack included. */
+	if (ENV_ROMSTAGE)
+		stage_usage_add(STAGE_USAGE_CAR, _car_region_size,
+				_car_relocatable_data_end - _car_region_start);
+#endif
+}
+
+#if ENV_RAMSTAGE
+static void record_ramstage_usage(void *unused)
+{
+	stage_usage_record();
+}
+
+BOOT_STATE_INIT_ENTRY(BS_OS_RESUME, BS_ON_ENTRY, record_ramstage_usage, NULL);
+BOOT_STATE_INIT_ENTRY(BS_PAYLOAD_BOOT, BS_ON_ENTRY, record_ramstage_usage,
+		      NULL);
+#endif
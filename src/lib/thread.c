@@ -19,6 +19,7 @@
 #include <bootstate.h>
 #include <console/console.h>
 #include <thread.h>
+#include <timestamp.h>
 
 static void idle_thread_init(void);
 
@@ -161,7 +162,9 @@ static void asmlinkage call_wrapper_block_current(void *unused)
 	struct thread *current = current_thread();
 
 	boot_state_current_block();
+	timestamp_span_begin(TS_SPAN_THREAD, 0);
 	current->entry(current->entry_arg);
+	timestamp_span_end(TS_SPAN_THREAD, 0);
 	boot_state_current_unblock();
 	terminate_thread(current);
 }
@@ -178,7 +181,9 @@ static void asmlinkage call_wrapper_block_state(void *arg)
 	struct thread *current = current_thread();
 
 	boot_state_block(bbs->state, bbs->seq);
+	timestamp_span_begin(TS_SPAN_THREAD, 0);
 	current->entry(current->entry_arg);
+	timestamp_span_end(TS_SPAN_THREAD, 0);
 	boot_state_unblock(bbs->state, bbs->seq);
 	terminate_thread(current);
 }
@@ -371,3 +376,15 @@ void thread_prevent_coop(void)
 	if (current != NULL)
 		current->can_yield = 0;
 }
+
+int thread_current_id(void)
+{
+	struct thread *current;
+
+	current = current_thread();
+
+	if (current == NULL)
+		return 0;
+
+	return current->id;
+}
@@ -20,6 +20,7 @@
 #include <compiler.h>
 #include <console/console.h>
 #include <cbmem.h>
+#include <stage_usage.h>
 #include <symbols.h>
 #include <timer.h>
 #include <timestamp.h>
@@ -295,6 +296,15 @@ static void timestamp_sync_cache_to_cbmem(int is_recovery)
 	if (ENV_RAMSTAGE)
 		ts_cbmem_table->tick_freq_mhz = timestamp_tick_freq_mhz();
 
+	/* The cache in the TIMESTAMP() region isn't needed past this point. */
+	if (USE_TIMESTAMP_REGION) {
+		struct timestamp_entry *end =
+			&ts_cache_table->entries[ts_cache_table->num_entries];
+
+		stage_usage_add(STAGE_USAGE_TIMESTAMP, _timestamp_size,
+				(uintptr_t)end - (uintptr_t)ts_cache);
+	}
+
 	/* Cache no longer required. */
 	ts_cache_table->num_entries = 0;
 	ts_cache->cache_state = TIMESTAMP_CACHE_NOT_NEEDED;
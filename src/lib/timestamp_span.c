@@ -0,0 +1,174 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/cpu.h>
+#include <cbmem.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <thread.h>
+#include <timestamp.h>
+
+#define SPAN_ENTRIES CONFIG_TIMESTAMP_SPAN_ENTRIES
+
+#if IS_ENABLED(CONFIG_COOP_MULTITASKING)
+#define SPAN_THREADS (CONFIG_NUM_THREADS + 1)
+#else
+#define SPAN_THREADS 1
+#endif
+
+/*
+ * Every CPU only appends to its own buffer so recording needs neither locks
+ * nor atomics. The cooperative threads share the buffer of the BSP, which is
+ * fine as they can't be switched out in the middle of an append. Once a
+ * buffer is full further events are counted but not kept.
+ */
+struct span_buffer {
+	uint32_t count;
+	uint32_t dropped;
+	uint8_t depth[SPAN_THREADS];
+	struct timestamp_span_entry entries[SPAN_ENTRIES];
+};
+
+static struct span_buffer span_buffers[CONFIG_MAX_CPUS];
+static int spans_merged;
+
+static unsigned int span_cpu(void)
+{
+#if IS_ENABLED(CONFIG_ARCH_X86)
+	return cpu_info()->index;
+#else
+	/* Only x86 brings up other CPUs in ramstage. */
+	return 0;
+#endif
+}
+
+static void span_add(enum timestamp_id id, uint16_t arg, uint8_t type)
+{
+	struct span_buffer *buf;
+	struct timestamp_span_entry *tse;
+	unsigned int cpu;
+	int thread;
+	uint64_t stamp;
+
+	stamp = timestamp_get();
+
+	if (spans_merged)
+		return;
+
+	cpu = span_cpu();
+	thread = thread_current_id();
+
+	if (cpu >= ARRAY_SIZE(span_buffers) || thread >= SPAN_THREADS)
+		return;
+
+	buf = &span_buffers[cpu];
+
+	if (type == TS_SPAN_END && buf->depth[thread] > 0)
+		buf->depth[thread]--;
+
+	if (buf->count < SPAN_ENTRIES) {
+		tse = &buf->entries[buf->count++];
+		tse->stamp = stamp;
+		tse->id = id;
+		tse->arg = arg;
+		tse->type = type;
+		tse->depth = buf->depth[thread];
+		tse->cpu = cpu;
+		tse->thread = thread;
+	} else {
+		buf->dropped++;
+	}
+
+	if (type == TS_SPAN_BEGIN)
+		buf->depth[thread]++;
+}
+
+void timestamp_span_begin(enum timestamp_id id, uint16_t arg)
+{
+	span_add(id, arg, TS_SPAN_BEGIN);
+}
+
+void timestamp_span_end(enum timestamp_id id, uint16_t arg)
+{
+	span_add(id, arg, TS_SPAN_END);
+}
+
+/*
+ * Merge the per-CPU buffers, each of which is already in time order, into a
+ * single table in CBMEM. On resume the table of the previous boot is reused
+ * and whatever doesn't fit into it is counted as dropped.
+ */
+void timestamp_span_merge(void)
+{
+	const struct cbmem_entry *entry;
+	const struct timestamp_table *ts_table;
+	struct timestamp_span_table *tst;
+	uint32_t pos[ARRAY_SIZE(span_buffers)] = { 0 };
+	uint32_t total = 0;
+	uint32_t dropped = 0;
+	uint32_t max_entries;
+	size_t i;
+
+	if (spans_merged)
+		return;
+	spans_merged = 1;
+
+	for (i = 0; i < ARRAY_SIZE(span_buffers); i++) {
+		total += span_buffers[i].count;
+		dropped += span_buffers[i].dropped;
+	}
+
+	entry = cbmem_entry_add(CBMEM_ID_TIMESTAMP_SPANS, sizeof(*tst) +
+				total * sizeof(tst->entries[0]));
+	if (entry == NULL) {
+		printk(BIOS_ERR, "ERROR: No room for timestamp spans\n");
+		return;
+	}
+
+	tst = cbmem_entry_start(entry);
+	max_entries = (cbmem_entry_size(entry) - sizeof(*tst)) /
+		sizeof(tst->entries[0]);
+
+	ts_table = cbmem_find(CBMEM_ID_TIMESTAMP);
+	tst->base_time = ts_table != NULL ? ts_table->base_time : 0;
+	tst->tick_freq_mhz = timestamp_tick_freq_mhz();
+	tst->reserved = 0;
+	tst->num_entries = 0;
+
+	while (tst->num_entries < MIN(total, max_entries)) {
+		const struct timestamp_span_entry *next = NULL;
+		size_t next_cpu = 0;
+
+		for (i = 0; i < ARRAY_SIZE(span_buffers); i++) {
+			const struct span_buffer *buf = &span_buffers[i];
+
+			if (pos[i] >= buf->count)
+				continue;
+			if (next == NULL ||
+			    buf->entries[pos[i]].stamp < next->stamp) {
+				next = &buf->entries[pos[i]];
+				next_cpu = i;
+			}
+		}
+
+		tst->entries[tst->num_entries++] = *next;
+		pos[next_cpu]++;
+	}
+
+	tst->dropped = dropped + total - tst->num_entries;
+
+	printk(BIOS_DEBUG, "Timestamp spans: %u stored, %u dropped.\n",
+	       tst->num_entries, tst->dropped);
+}
@@ -24,7 +24,38 @@ bct_cfg2inc() {
 	echo "}," >>"${out_file}"
 }
 
+# Prints "Name Value" pairs, one per line, from a BCT SDRAM config.
+bct_cfg_pairs() {
+	sed "/^#.*$/d; /^\s*$/d; s/\r$//; s/;$//; s/^SDRAM.0.\.//; s/=/ /" "$1"
+}
+
+# Emits only the parameters of in_file that differ from base_file, as
+# SDRAM_PARAM_DELTA() entries to be applied on top of the base struct.
+bct_cfg2delta() {
+	local base_file="$1"
+	local in_file="$2"
+	local out_file="$3"
+	echo "/* generated from ${in_file} against ${base_file}; do not edit. */" \
+		>"${out_file}"
+	bct_cfg_pairs "${base_file}" >"${out_file}.base"
+	bct_cfg_pairs "${in_file}" | awk '
+		NR == FNR { base[$1] = $2; next }
+		!($1 in base) || base[$1] != $2 {
+			printf("SDRAM_PARAM_DELTA(%s, %s),\n", $1, $2)
+		}' "${out_file}.base" - >>"${out_file}"
+	rm -f "${out_file}.base"
+}
+
+# Usage: cfg2inc.sh base.cfg [other.cfg...]
+# The first config is emitted as a full struct, all others as deltas to it.
+base=""
 for file in $@; do
-	echo "Generating $file => ${file%cfg}inc..."
-	bct_cfg2inc "${file}" "${file%cfg}inc"
+	if [ -z "${base}" ]; then
+		base="${file}"
+		echo "Generating $file => ${file%cfg}inc..."
+		bct_cfg2inc "${file}" "${file%cfg}inc"
+	else
+		echo "Generating $file => ${file%.cfg}-delta.inc..."
+		bct_cfg2delta "${base}" "${file}" "${file%.cfg}-delta.inc"
+	fi
 done
@@ -14,9 +14,14 @@
  */
 
 #include <boot_device.h>
+#include <cbfs.h>
+#include <commonlib/endian.h>
+#include <console/console.h>
 #include <soc/addressmap.h>
+#include <soc/warm_cache.h>
 #include <string.h>
 #include <symbols.h>
+#include <timestamp.h>
 
 #include "cbfs.h"
 
@@ -125,15 +130,143 @@ static bool rom_in_sdram = true;
 static bool rom_in_sdram = false;
 #endif
 
+/*
+ * Compare a part of the image as served by the host against the same bytes
+ * in the SDRAM copy. The copy is a byte-for-byte mirror, so the offsets are
+ * identical.
+ */
+static bool rom_copy_matches(const struct region_device *rdev)
+{
+	uint8_t buf[256];
+	size_t base = region_device_offset(rdev);
+	size_t size = region_device_sz(rdev);
+	size_t offset, chunk;
+
+	if (base + size > CONFIG_ROM_SIZE)
+		return false;
+
+	for (offset = 0; offset < size; offset += chunk) {
+		chunk = min(sizeof(buf), size - offset);
+		if (rdev_readat(rdev, buf, offset, chunk) != (ssize_t)chunk)
+			return false;
+		if (memcmp(buf, _rom_copy + base + offset, chunk))
+			return false;
+	}
+
+	return true;
+}
+
+/* Returns true if the metadata of a file has a hash attribute. */
+static bool cbfs_metadata_has_hash(void *metadata, size_t size)
+{
+	size_t offs = 0;
+
+	while ((offs = cbfs_for_each_attr(metadata, size, offs))) {
+		const struct cbfs_file_attribute *attr = metadata + offs;
+
+		if (read_be32(&attr->tag) == CBFS_FILE_ATTR_TAG_HASH)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Compare one CBFS file. Its metadata has to match byte for byte. That
+ * includes the hash attribute if there is one, and identical hashes mean
+ * identical data. The data of files without a hash has to be compared as
+ * well. Empty files are not used by anything, so their contents don't
+ * matter.
+ */
+static bool rom_copy_file_matches(const struct cbfsf *fh)
+{
+	void *metadata = _rom_copy + region_device_offset(&fh->metadata);
+	size_t size = region_device_sz(&fh->metadata);
+	const struct cbfs_file *file = metadata;
+	uint32_t type;
+
+	/* Once it is known to match, the metadata is parsed from the copy. */
+	if (size < sizeof(*file) || !rom_copy_matches(&fh->metadata))
+		return false;
+
+	type = read_be32(&file->type);
+	if (type == CBFS_TYPE_DELETED || type == CBFS_TYPE_DELETED2)
+		return true;
+
+	if (cbfs_metadata_has_hash(metadata, size))
+		return true;
+
+	return rom_copy_matches(&fh->data);
+}
+
+/*
+ * The SDRAM copy from the previous boot can be reused if it is still intact
+ * and the host serves the same CBFS. Every file in the host's CBFS has to
+ * match the copy, and the copy must not have any files beyond those. With
+ * CBFS_HASH_ATTRIBUTES this only transfers the CBFS metadata. Other areas of
+ * the image are not accessed through the copy.
+ */
+static bool rom_copy_is_current(void)
+{
+	struct cbfs_props props;
+	struct region_device host, copy;
+	struct cbfsf host_file, copy_file;
+	const struct cbfsf *host_prev = NULL;
+	const struct cbfsf *copy_prev = NULL;
+	int host_ret, copy_ret;
+
+	if (!IS_ENABLED(CONFIG_TEGRA210_WARM_REBOOT_CACHE))
+		return false;
+
+	if (!warm_cache_rom_valid(_rom_copy, CONFIG_ROM_SIZE))
+		return false;
+
+	if (cbfs_boot_region_properties(&props))
+		return false;
+
+	if (rdev_chain(&host, &mdev_usb.rdev, props.offset, props.size) ||
+	    rdev_chain(&copy, &mdev_sdram.rdev, props.offset, props.size))
+		return false;
+
+	while (1) {
+		host_ret = cbfs_for_each_file(&host, host_prev, &host_file);
+		copy_ret = cbfs_for_each_file(&copy, copy_prev, &copy_file);
+
+		if (host_ret < 0 || host_ret != copy_ret)
+			return false;
+		if (host_ret > 0)
+			return true;
+
+		if (region_device_offset(&host_file.metadata) !=
+		    region_device_offset(&copy_file.metadata))
+			return false;
+		if (!rom_copy_file_matches(&host_file))
+			return false;
+
+		host_prev = &host_file;
+		copy_prev = &copy_file;
+	}
+}
+
 void cbfs_switch_to_sdram(void)
 {
-	usb_readat(&mdev_usb.rdev, _rom_copy, 0, CONFIG_ROM_SIZE);
+	timestamp_add_now(TS_START_ROM_MIRROR);
+
+	if (rom_copy_is_current()) {
+		printk(BIOS_INFO, "Reusing SDRAM backed CBFS from warm cache\n");
+	} else {
+		usb_readat(&mdev_usb.rdev, _rom_copy, 0, CONFIG_ROM_SIZE);
+		if (IS_ENABLED(CONFIG_TEGRA210_WARM_REBOOT_CACHE))
+			warm_cache_rom_update(_rom_copy, CONFIG_ROM_SIZE);
+	}
 
 	/* Signal host with offset=0 and length=0 that we're done. */
 	memset(_usb_bounce, 0, 8);
 	rom_sendbuf(_usb_bounce, 8);
 
 	rom_in_sdram = true;
+
+	timestamp_add_now(TS_END_ROM_MIRROR);
 }
 
 const struct region_device *boot_device_ro(void)
@@ -20,15 +20,54 @@
 #include <console/console.h>
 #include <soc/addressmap.h>
 #include <soc/sdram_configs.h>
+#include <stddef.h>
+#include <string.h>
 
-static const struct sdram_params sdram_configs[] = {
+/*
+ * The SDRAM configs only differ in a handful of parameters, so only the
+ * ram_code 0 set is stored in full and the others as a list of overrides.
+ */
+struct sdram_param_delta {
+	uint32_t index;		/* in units of uint32_t */
+	uint32_t value;
+};
+
+#define SDRAM_PARAM_DELTA(field, val) \
+	{ offsetof(struct sdram_params, field) / sizeof(uint32_t), (val) }
+
+static const struct sdram_params sdram_base_config[] = {
 #include "bct/sdram-nintendo-switch-0.inc"		/* ram_code = 0000 */
-#include "bct/sdram-nintendo-switch-1.inc"		/* ram_code = 0001 */
-#include "bct/sdram-nintendo-switch-2.inc"		/* ram_code = 0010 */
-#include "bct/sdram-nintendo-switch-3.inc"		/* ram_code = 0011 */
-#include "bct/sdram-nintendo-switch-4.inc"		/* ram_code = 0100 */
 };
 
+static const struct sdram_param_delta sdram_deltas_1[] = {
+#include "bct/sdram-nintendo-switch-1-delta.inc"	/* ram_code = 0001 */
+};
+
+static const struct sdram_param_delta sdram_deltas_2[] = {
+#include "bct/sdram-nintendo-switch-2-delta.inc"	/* ram_code = 0010 */
+};
+
+static const struct sdram_param_delta sdram_deltas_3[] = {
+#include "bct/sdram-nintendo-switch-3-delta.inc"	/* ram_code = 0011 */
+};
+
+static const struct sdram_param_delta sdram_deltas_4[] = {
+#include "bct/sdram-nintendo-switch-4-delta.inc"	/* ram_code = 0100 */
+};
+
+static const struct {
+	const struct sdram_param_delta *deltas;
+	size_t count;
+} sdram_configs[] = {
+	{ NULL, 0 },
+	{ sdram_deltas_1, ARRAY_SIZE(sdram_deltas_1) },
+	{ sdram_deltas_2, ARRAY_SIZE(sdram_deltas_2) },
+	{ sdram_deltas_3, ARRAY_SIZE(sdram_deltas_3) },
+	{ sdram_deltas_4, ARRAY_SIZE(sdram_deltas_4) },
+};
+
+static struct sdram_params sdram_config;
+
 #define FUSE_BASE		((void *)TEGRA_FUSE_BASE)
 #define  FUSE_RESERVED_ODM4	0x1d8
 
@@ -40,13 +79,21 @@ uint32_t ram_code(void)
 const struct sdram_params *get_sdram_config()
 {
 	uint32_t rc = ram_code();
+	size_t i;
 
 	printk(BIOS_INFO, "Fuse SDRAM code: %d\n", rc);
 
-	if (rc >= ARRAY_SIZE(sdram_configs) ||
-		sdram_configs[rc].MemoryType == NvBootMemoryType_Unused) {
+	if (rc >= ARRAY_SIZE(sdram_configs))
 		die("Invalid SDRAM code.");
+
+	memcpy(&sdram_config, sdram_base_config, sizeof(sdram_config));
+	for (i = 0; i < sdram_configs[rc].count; i++) {
+		const struct sdram_param_delta *d = &sdram_configs[rc].deltas[i];
+		((uint32_t *)&sdram_config)[d->index] = d->value;
 	}
 
-	return &sdram_configs[rc];
+	if (sdram_config.MemoryType == NvBootMemoryType_Unused)
+		die("Invalid SDRAM code.");
+
+	return &sdram_config;
 }
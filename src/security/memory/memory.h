@@ -0,0 +1,23 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef SECURITY_MEMORY_H
+#define SECURITY_MEMORY_H
+
+/*
+ * Return 1 if DRAM needs to be cleared on this boot, 0 otherwise. The
+ * default implementation always asks for it.
+ */
+int security_clear_dram_request(void);
+
+#endif /* SECURITY_MEMORY_H */
@@ -0,0 +1,375 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <arch/acpi.h>
+#include <arch/cpu.h>
+#include <bootstate.h>
+#include <cbmem.h>
+#include <commonlib/helpers.h>
+#include <console/console.h>
+#include <cpu/x86/mp.h>
+#include <cpu/x86/pae.h>
+#include <device/resource.h>
+#include <memrange.h>
+#include <string.h>
+#include <symbols.h>
+#include <timer.h>
+#include <timestamp.h>
+
+#include "memory.h"
+
+/*
+ * The memory to clear is split into chunks which all CPUs pull from a
+ * shared counter until none are left. That keeps every CPU busy no matter
+ * how the ranges are laid out or how fast the CPUs are.
+ */
+#define CLEAR_CHUNK_SIZE	(2 * MiB)
+#define CLEAR_MAX_RANGES	32
+/* The legacy area below 1MiB holds the SIPI vector and option ROMs. */
+#define CLEAR_MIN_ADDR		(1 * MiB)
+/* Ramstage runs in 32-bit mode without paging. */
+#define CLEAR_MAX_ADDR		(4ULL * GiB)
+/* Memory above 4GiB is mapped 2MiB at a time with map_2M_page_at(). */
+#define CLEAR_PAGE_SIZE		(2 * MiB)
+
+enum {
+	CLEAR_KEEP = 0,
+	CLEAR_RAM,
+};
+
+struct clear_range {
+	uintptr_t base;
+	size_t size;
+	uint32_t first_chunk;
+};
+
+/* Memory above 4GiB, cleared by the BSP alone once the rest is done. */
+struct clear_high_range {
+	uint64_t base;
+	uint64_t end;
+};
+
+struct clear_work {
+	struct clear_range ranges[CLEAR_MAX_RANGES];
+	size_t num_ranges;
+	struct clear_high_range high_ranges[CLEAR_MAX_RANGES];
+	size_t num_high_ranges;
+	uint32_t num_chunks;
+	uint32_t next_chunk;
+	uint32_t errors;
+	int use_movnti;
+};
+
+static struct clear_work clear_work;
+static struct mp_job clear_jobs[CONFIG_MAX_CPUS];
+
+int __attribute__((weak)) security_clear_dram_request(void)
+{
+	return 1;
+}
+
+/* Clear using non-temporal stores so the caches aren't thrashed. */
+static void clear_chunk_movnti(uintptr_t base, size_t size)
+{
+	uint32_t *p = (uint32_t *)base;
+	size_t n;
+
+	for (n = size / (4 * sizeof(*p)); n > 0; n--, p += 4) {
+		__asm__ __volatile__(
+			"movnti %1, 0(%0)\n\t"
+			"movnti %1, 4(%0)\n\t"
+			"movnti %1, 8(%0)\n\t"
+			"movnti %1, 12(%0)\n\t"
+			: : "r" (p), "r" (0) : "memory");
+	}
+
+	__asm__ __volatile__("sfence" : : : "memory");
+
+	/* The part that doesn't fill a whole group of four stores. */
+	memset(p, 0, size % (4 * sizeof(*p)));
+}
+
+static void clear_chunk(const struct clear_work *w, uintptr_t base,
+			size_t size)
+{
+	if (w->use_movnti)
+		clear_chunk_movnti(base, size);
+	else
+		memset((void *)base, 0, size);
+}
+
+/* Same pattern as primitive_memtest(). Returns the number of errors. */
+static uint32_t test_chunk(uintptr_t base, size_t size)
+{
+	volatile uintptr_t *p = (volatile uintptr_t *)base;
+	const size_t n = size / sizeof(*p);
+	uint32_t errors = 0;
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		p[i] = (uintptr_t)&p[i];
+
+	for (i = 0; i < n; i++) {
+		if (p[i] != (uintptr_t)&p[i])
+			errors++;
+	}
+
+	return errors;
+}
+
+static int clear_worker(void *arg)
+{
+	struct clear_work *w = arg;
+	uint32_t chunks = 0;
+	uint32_t errors = 0;
+	uint32_t chunk;
+
+	timestamp_span_begin(TS_SPAN_MEMORY_CLEAR, cpu_index());
+
+	while ((chunk = __sync_fetch_and_add(&w->next_chunk, 1)) <
+	       w->num_chunks) {
+		const struct clear_range *r = &w->ranges[0];
+		uintptr_t base;
+		size_t size;
+		size_t i;
+
+		for (i = 1; i < w->num_ranges; i++) {
+			if (w->ranges[i].first_chunk > chunk)
+				break;
+			r = &w->ranges[i];
+		}
+
+		base = r->base + (size_t)(chunk - r->first_chunk) *
+			CLEAR_CHUNK_SIZE;
+		size = MIN(CLEAR_CHUNK_SIZE, r->base + r->size - base);
+
+		if (IS_ENABLED(CONFIG_SECURITY_CLEAR_DRAM_MEMTEST))
+			errors += test_chunk(base, size);
+
+		clear_chunk(w, base, size);
+		chunks++;
+	}
+
+	if (errors)
+		__sync_fetch_and_add(&w->errors, errors);
+
+	timestamp_span_end(TS_SPAN_MEMORY_CLEAR, MIN(chunks, 0xffff));
+
+	return 0;
+}
+
+static void clear_work_add_high(struct clear_work *w, uint64_t base,
+				uint64_t end)
+{
+	struct clear_high_range *r;
+
+	if (w->num_high_ranges == ARRAY_SIZE(w->high_ranges)) {
+		printk(BIOS_ERR, "Memory clear: too many ranges, can't clear "
+			"0x%llx-0x%llx\n", base, end - 1);
+		die("Memory clear: not all memory can be cleared.\n");
+	}
+
+	r = &w->high_ranges[w->num_high_ranges++];
+	r->base = base;
+	r->end = end;
+}
+
+static void clear_work_add(struct clear_work *w, uint64_t base, uint64_t end)
+{
+	struct clear_range *r;
+
+	base = MAX(base, CLEAR_MIN_ADDR);
+
+	if (end > CLEAR_MAX_ADDR) {
+		clear_work_add_high(w, MAX(base, CLEAR_MAX_ADDR), end);
+		end = CLEAR_MAX_ADDR;
+	}
+
+	if (base >= end)
+		return;
+
+	if (w->num_ranges == ARRAY_SIZE(w->ranges)) {
+		printk(BIOS_ERR, "Memory clear: too many ranges, can't clear "
+			"0x%llx-0x%llx\n", base, end - 1);
+		die("Memory clear: not all memory can be cleared.\n");
+	}
+
+	r = &w->ranges[w->num_ranges++];
+	r->base = base;
+	r->size = end - base;
+	r->first_chunk = w->num_chunks;
+	w->num_chunks += DIV_ROUND_UP(r->size, CLEAR_CHUNK_SIZE);
+}
+
+static void clear_work_init(struct clear_work *w)
+{
+	const unsigned long cacheable = IORESOURCE_CACHEABLE;
+	const unsigned long reserved = IORESOURCE_RESERVE;
+	const struct range_entry *r;
+	struct memranges ranges;
+	void *baseptr;
+	size_t size;
+
+	memset(w, 0, sizeof(*w));
+
+	/* Same order as bootmem_init() so reserved ranges take precedence. */
+	memranges_init(&ranges, cacheable, cacheable, CLEAR_RAM);
+	memranges_add_resources(&ranges, reserved, reserved, CLEAR_KEEP);
+
+	cbmem_get_region(&baseptr, &size);
+	memranges_insert(&ranges, (uintptr_t)baseptr, size, CLEAR_KEEP);
+	memranges_insert(&ranges, (uintptr_t)_program, _program_size,
+				CLEAR_KEEP);
+
+	memranges_each_entry(r, &ranges) {
+		if (range_entry_tag(r) != CLEAR_RAM)
+			continue;
+		clear_work_add(w, range_entry_base(r), range_entry_end(r));
+	}
+
+	memranges_teardown(&ranges);
+
+	/* movnti came with SSE2. */
+	w->use_movnti = !!(cpuid_edx(1) & (1 << 26));
+}
+
+/*
+ * Pick the address at which memory above 4GiB gets mapped: a 2MiB page
+ * inside a range that was just cleared. Nothing else uses that memory, so
+ * ramstage, its stack, CBMEM and MMIO all stay reachable while it is
+ * remapped.
+ */
+static uintptr_t clear_high_slot(const struct clear_work *w)
+{
+	size_t i;
+
+	for (i = 0; i < w->num_ranges; i++) {
+		const struct clear_range *r = &w->ranges[i];
+		uint64_t slot = ALIGN_UP((uint64_t)r->base, CLEAR_PAGE_SIZE);
+
+		if (slot + CLEAR_PAGE_SIZE <= (uint64_t)r->base + r->size)
+			return slot;
+	}
+
+	return 0;
+}
+
+/* Clear the memory above 4GiB through PAE mappings, 2MiB at a time. */
+static void clear_high_memory(struct clear_work *w)
+{
+	uint32_t errors = 0;
+	uintptr_t slot;
+	size_t i;
+
+	if (w->num_high_ranges == 0)
+		return;
+
+	slot = clear_high_slot(w);
+	if (!slot) {
+		printk(BIOS_ERR, "Memory clear: no free 2MiB page below 4GiB "
+			"to map memory above 4GiB.\n");
+		die("Memory clear: not all memory can be cleared.\n");
+	}
+
+	for (i = 0; i < w->num_high_ranges; i++) {
+		const struct clear_high_range *r = &w->high_ranges[i];
+		uint64_t addr;
+		uint64_t next;
+
+		for (addr = r->base; addr < r->end; addr = next) {
+			uint8_t *p;
+			size_t size;
+
+			next = MIN(ALIGN_DOWN(addr, CLEAR_PAGE_SIZE) +
+					CLEAR_PAGE_SIZE, r->end);
+			size = next - addr;
+
+			p = map_2M_page_at(slot,
+					ALIGN_DOWN(addr, CLEAR_PAGE_SIZE));
+			if (p == MAPPING_ERROR) {
+				unmap_2M_pages();
+				printk(BIOS_ERR, "Memory clear: can't map "
+					"0x%llx\n", addr);
+				die("Memory clear: not all memory can be "
+					"cleared.\n");
+			}
+			p += addr % CLEAR_PAGE_SIZE;
+
+			if (IS_ENABLED(CONFIG_SECURITY_CLEAR_DRAM_MEMTEST))
+				errors += test_chunk((uintptr_t)p, size);
+
+			clear_chunk(w, (uintptr_t)p, size);
+		}
+	}
+
+	unmap_2M_pages();
+
+	w->errors += errors;
+
+	printk(BIOS_INFO, "Memory clear: %zu ranges above 4GiB done.\n",
+		w->num_high_ranges);
+}
+
+static void clear_dram(void *unused)
+{
+	struct clear_work *w = &clear_work;
+	struct stopwatch sw;
+	int aps_running = 0;
+
+	if (acpi_is_wakeup_s3() || !security_clear_dram_request())
+		return;
+
+	clear_work_init(w);
+
+	printk(BIOS_INFO, "Memory clear: %u chunks of %d KiB in %zu ranges.\n",
+		w->num_chunks, CLEAR_CHUNK_SIZE / KiB, w->num_ranges);
+
+	stopwatch_init(&sw);
+
+	/* Let the APs pull chunks as well while the BSP works on them. */
+	if (IS_ENABLED(CONFIG_PARALLEL_MP_AP_WORK) && mp_get_num_aps() > 0) {
+		int i;
+
+		for (i = 1; i <= mp_get_num_aps(); i++) {
+			if (mp_queue_job(&clear_jobs[i], i, clear_worker,
+					w) == 0)
+				aps_running++;
+		}
+	}
+
+	clear_worker(w);
+
+	if (aps_running) {
+		int i;
+
+		/* An AP that hangs may have left its chunk half done. */
+		for (i = 1; i <= mp_get_num_aps(); i++) {
+			if (clear_jobs[i].state != MP_JOB_IDLE &&
+			    mp_wait_job(&clear_jobs[i], 10 * USECS_PER_SEC) < 0)
+				die("Memory clear: not all memory was "
+					"cleared.\n");
+		}
+	}
+
+	clear_high_memory(w);
+
+	stopwatch_tick(&sw);
+	printk(BIOS_INFO, "Memory clear: done on %d CPUs in %ld ms.\n",
+		aps_running + 1, stopwatch_duration_msecs(&sw));
+
+	if (IS_ENABLED(CONFIG_SECURITY_CLEAR_DRAM_MEMTEST))
+		printk(w->errors ? BIOS_ERR : BIOS_INFO,
+			"Memory clear: %u memory test errors.\n", w->errors);
+}
+
+BOOT_STATE_INIT_ENTRY(BS_DEV_INIT, BS_ON_EXIT, clear_dram, NULL);
@@ -37,4 +37,18 @@ void vb2_store_selected_region(void);
 
 void vb2_save_recovery_reason_vbnv(void);
 
+/*
+ * Read a block of the firmware body for hashing. The weak implementations
+ * simply rdev_readat() in vboot_hash_read_finish(). A platform selecting
+ * VBOOT_HASH_BODY_PREFETCH starts the transfer in _start() and waits for it
+ * in _finish(); in between, the previous block is being hashed. At most one
+ * read is started at a time, and every _start() is followed by a _finish()
+ * for the same block, even if _start() failed or hashing was aborted. Both
+ * return 0 on success, < 0 on failure.
+ */
+int vboot_hash_read_start(const struct region_device *rdev, void *buf,
+			  size_t offset, size_t size);
+int vboot_hash_read_finish(const struct region_device *rdev, void *buf,
+			   size_t offset, size_t size);
+
 #endif /* __VBOOT_MISC_H__ */
@@ -92,7 +92,7 @@ static void vboot_prepare(void)
 		car_set_var(vboot_executed, 1);
 		vb2_save_recovery_reason_vbnv();
 	} else if (verstage_should_load()) {
-		struct cbfsf file;
+		struct cbfs_load_verify verify;
 		struct prog verstage =
 			PROG_INIT(PROG_VERSTAGE,
 				CONFIG_CBFS_PREFIX "/verstage");
@@ -100,12 +100,13 @@ static void vboot_prepare(void)
 		printk(BIOS_DEBUG, "VBOOT: Loading verstage.\n");
 
 		/* load verstage from RO */
-		if (cbfs_boot_locate(&file, prog_name(&verstage), NULL))
+		if (cbfs_boot_locate_for_load(&verify, prog_name(&verstage),
+					      NULL))
 			die("failed to load verstage");
 
-		cbfs_file_data(prog_rdev(&verstage), &file);
+		cbfs_file_data(prog_rdev(&verstage), &verify.fh);
 
-		if (cbfs_prog_stage_load(&verstage))
+		if (cbfs_prog_stage_load(&verstage, &verify))
 			die("failed to load verstage");
 
 		/* verify and select a slot */
@@ -155,4 +156,11 @@ const struct cbfs_locator vboot_locator = {
 	.name = "VBOOT",
 	.prepare = vboot_prepare,
 	.locate = vboot_locate,
+#if IS_ENABLED(CONFIG_VBOOT_CBFS_FILE_HASHES)
+	/* The slot signature only covers the CBFS metadata, so each file's
+	 * data is checked against its hash attribute. */
+	.verify_start = cbfsf_hash_start,
+	.verify_extend = cbfsf_hash_extend,
+	.verify_finish = cbfsf_hash_finish,
+#endif
 };
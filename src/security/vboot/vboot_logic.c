@@ -17,6 +17,9 @@
 #include <arch/exception.h>
 #include <assert.h>
 #include <bootmode.h>
+#include <cbfs.h>
+#include <commonlib/endian.h>
+#include <commonlib/helpers.h>
 #include <console/console.h>
 #include <console/vtxprintf.h>
 #include <delay.h>
@@ -179,16 +182,146 @@ static int handle_digest_result(void *slot_hash, size_t slot_hash_sz)
 	return 0;
 }
 
+__attribute__((weak))
+int vboot_hash_read_start(const struct region_device *rdev, void *buf,
+			  size_t offset, size_t size)
+{
+	return 0;
+}
+
+__attribute__((weak))
+int vboot_hash_read_finish(const struct region_device *rdev, void *buf,
+			   size_t offset, size_t size)
+{
+	if (rdev_readat(rdev, buf, offset, size) < 0)
+		return -1;
+	return 0;
+}
+
+/*
+ * VBOOT_CBFS_FILE_HASHES: the signed body is the CBFS metadata stream that
+ * cbfstool's read-metadata emits, i.e. for every file its big endian offset
+ * within the slot followed by its header, name and attributes. File data is
+ * checked against the hash attributes when it gets loaded.
+ */
+static int hash_cbfs_metadata(struct vb2_context *ctx,
+			      struct region_device *fw_main)
+{
+	uint8_t block[TODO_BLOCK_SIZE];
+	uint8_t hash_digest[VBOOT_MAX_HASH_SIZE];
+	const size_t hash_digest_sz = sizeof(hash_digest);
+	uint32_t expected_size;
+	struct cbfsf file;
+	struct cbfsf *prev = NULL;
+	size_t end = 0;
+	int rv;
+
+	memset(hash_digest, 0, hash_digest_sz);
+
+	timestamp_add_now(TS_START_HASH_BODY);
+
+	rv = vb2api_init_hash(ctx, VB2_HASH_TAG_FW_BODY, &expected_size);
+	if (rv)
+		return rv;
+
+	while (expected_size) {
+		uint32_t be_offset;
+		size_t offset, metadata_sz;
+
+		/* Running out of files early is as bad as a read error. */
+		if (cbfs_for_each_file(fw_main, prev, &file))
+			return VB2_ERROR_UNKNOWN;
+		prev = &file;
+
+		metadata_sz = region_device_sz(&file.metadata);
+		if (sizeof(be_offset) + metadata_sz > expected_size)
+			return VB2_ERROR_UNKNOWN;
+
+		write_be32(&be_offset,
+			   rdev_relative_offset(fw_main, &file.metadata));
+		rv = vb2api_extend_hash(ctx, &be_offset, sizeof(be_offset));
+		if (rv)
+			return rv;
+
+		for (offset = 0; offset < metadata_sz; offset += sizeof(block)) {
+			size_t size = MIN(sizeof(block), metadata_sz - offset);
+
+			if (rdev_readat(&file.metadata, block, offset, size) < 0)
+				return VB2_ERROR_UNKNOWN;
+			rv = vb2api_extend_hash(ctx, block, size);
+			if (rv)
+				return rv;
+		}
+
+		expected_size -= sizeof(be_offset) + metadata_sz;
+		end = rdev_relative_offset(fw_main, &file.data) +
+			region_device_sz(&file.data);
+	}
+
+	/* Files past the signed metadata must not be found later on. */
+	if (rdev_chain(fw_main, fw_main, 0, end)) {
+		printk(BIOS_ERR, "Unable to restrict CBFS size.\n");
+		return VB2_ERROR_UNKNOWN;
+	}
+
+	timestamp_add_now(TS_DONE_HASHING);
+
+	rv = vb2api_check_hash_get_digest(ctx, hash_digest, hash_digest_sz);
+	if (rv)
+		return rv;
+
+	timestamp_add_now(TS_END_HASH_BODY);
+
+	if (handle_digest_result(hash_digest, hash_digest_sz))
+		return VB2_ERROR_UNKNOWN;
+
+	return VB2_SUCCESS;
+}
+
+/* Two buffers only pay off if reads actually run in the background. */
+#define HASH_BUFFERS (IS_ENABLED(CONFIG_VBOOT_HASH_BODY_PREFETCH) ? 2 : 1)
+
+/* A read that has been started, but not finished yet if buf is set. */
+struct hash_read {
+	uint8_t *buf;
+	size_t offset;
+	size_t size;
+};
+
+static int hash_read_start(const struct region_device *rdev,
+			   struct hash_read *r, uint8_t *buf, size_t offset,
+			   size_t size)
+{
+	r->buf = buf;
+	r->offset = offset;
+	r->size = size;
+	return vboot_hash_read_start(rdev, buf, offset, size);
+}
+
+static int hash_read_finish(const struct region_device *rdev,
+			    struct hash_read *r)
+{
+	uint8_t *buf = r->buf;
+
+	r->buf = NULL;
+	return vboot_hash_read_finish(rdev, buf, r->offset, r->size);
+}
+
 static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 {
 	uint64_t load_ts;
 	uint32_t expected_size;
-	uint8_t block[TODO_BLOCK_SIZE];
+	uint8_t block[HASH_BUFFERS][TODO_BLOCK_SIZE];
 	uint8_t hash_digest[VBOOT_MAX_HASH_SIZE];
 	const size_t hash_digest_sz = sizeof(hash_digest);
-	size_t block_size = sizeof(block);
-	size_t offset;
-	int rv;
+	size_t block_size = sizeof(block[0]);
+	size_t offset, next_size;
+	struct hash_read pending = { NULL };
+	int cur = 0;
+	int rv = VB2_SUCCESS;
+
+	if (IS_ENABLED(CONFIG_VBOOT_CBFS_FILE_HASHES))
+		return hash_cbfs_metadata(ctx, fw_main);
 
 	/* Clear the full digest so that any hash digests less than the
 	 * max have trailing zeros. */
@@ -198,6 +331,8 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 	 * Since loading the firmware and calculating its hash is intertwined,
 	 * we use this little trick to measure them separately and pretend it
 	 * was first loaded and then hashed in one piece with the timestamps.
+	 * With VBOOT_HASH_BODY_PREFETCH only the time spent waiting for a
+	 * read counts as loading.
 	 * (This split won't make sense with memory-mapped media like on x86.)
 	 */
 	load_ts = timestamp_get();
@@ -222,23 +357,41 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 		return VB2_ERROR_UNKNOWN;
 	}
 
+	if (block_size > expected_size)
+		block_size = expected_size;
+	if (block_size && hash_read_start(fw_main, &pending, block[cur], offset,
+					  block_size) < 0)
+		goto cancel;
+
 	/* Extend over the body */
 	while (expected_size) {
 		uint64_t temp_ts;
-		if (block_size > expected_size)
-			block_size = expected_size;
 
 		temp_ts = timestamp_get();
-		if (rdev_readat(fw_main, block, offset, block_size) < 0)
+		if (hash_read_finish(fw_main, &pending) < 0)
 			return VB2_ERROR_UNKNOWN;
+
+		/* Kick off the next read before hashing this block. */
+		next_size = MIN(sizeof(block[0]), expected_size - block_size);
+		if (HASH_BUFFERS > 1 && next_size &&
+		    hash_read_start(fw_main, &pending, block[!cur],
+				    offset + block_size, next_size) < 0)
+			goto cancel;
 		load_ts += timestamp_get() - temp_ts;
 
-		rv = vb2api_extend_hash(ctx, block, block_size);
+		rv = vb2api_extend_hash(ctx, block[cur], block_size);
 		if (rv)
-			return rv;
+			goto cancel;
 
 		expected_size -= block_size;
 		offset += block_size;
+		block_size = next_size;
+		if (HASH_BUFFERS > 1)
+			cur = !cur;
+		else if (next_size &&
+			 hash_read_start(fw_main, &pending, block[cur], offset,
+					 next_size) < 0)
+			goto cancel;
 	}
 
 	timestamp_add(TS_DONE_LOADING, load_ts);
@@ -255,6 +408,15 @@ static int hash_body(struct vb2_context *ctx, struct region_device *fw_main)
 		return VB2_ERROR_UNKNOWN;
 
 	return VB2_SUCCESS;
+
+cancel:
+	/*
+	 * A read started into block[] may still be running. Wait for it so
+	 * that it can't write into this stack frame once it is gone.
+	 */
+	if (pending.buf != NULL)
+		hash_read_finish(fw_main, &pending);
+	return rv ? rv : VB2_ERROR_UNKNOWN;
 }
 
 static int locate_firmware(struct vb2_context *ctx,
@@ -539,6 +539,7 @@ void generate_cpu_entries(device_t device)
 	int totalcores = dev_count_cpu();
 	int cores_per_package = get_cores_per_package();
 	int numcpus = totalcores/cores_per_package;
+	struct acpigen_blob cst = { 0 };
 
 	printk(BIOS_DEBUG, "Found %d CPU(s) with %d core(s) each.\n",
 	       numcpus, cores_per_package);
@@ -559,8 +560,12 @@ void generate_cpu_entries(device_t device)
 			generate_P_state_entries(
 				coreID - 1, cores_per_package);
 
-			/* Generate C-state tables */
-			generate_C_state_entries();
+			/* Generate C-state tables, the same for every core */
+			if (acpigen_blob_emit(&cst) < 0) {
+				acpigen_blob_begin(&cst);
+				generate_C_state_entries();
+				acpigen_blob_end(&cst);
+			}
 
 			/* Generate T-state tables */
 			generate_T_state_entries(
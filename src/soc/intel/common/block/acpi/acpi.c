@@ -413,6 +413,7 @@ void generate_cpu_entries(device_t device)
 	int totalcores = dev_count_cpu();
 	int cores_per_package = get_cores_per_package();
 	int numcpus = totalcores / cores_per_package;
+	struct acpigen_blob cst = { 0 };
 
 	printk(BIOS_DEBUG, "Found %d CPU(s) with %d core(s) each.\n",
 	       numcpus, cores_per_package);
@@ -428,8 +429,12 @@ void generate_cpu_entries(device_t device)
 			acpigen_write_processor((cpu_id) * cores_per_package +
 						core_id, pcontrol_blk, plen);
 
-			/* Generate C-state tables */
-			generate_c_state_entries();
+			/* Generate C-state tables, the same for every core */
+			if (acpigen_blob_emit(&cst) < 0) {
+				acpigen_blob_begin(&cst);
+				generate_c_state_entries();
+				acpigen_blob_end(&cst);
+			}
 
 			/* Soc specific power states generation */
 			soc_power_states_generation(core_id, cores_per_package);
@@ -17,6 +17,7 @@
 
 #include <arch/io.h>
 #include <assert.h>
+#include <boot_device.h>
 #include <console/console.h>
 #include <spi_flash.h>
 #include <spi-generic.h>
@@ -27,6 +28,9 @@
 #include <timer.h>
 #include <soc/flash_controller.h>
 #include <soc/mmu_operations.h>
+#if IS_ENABLED(CONFIG_VBOOT_HASH_BODY_PREFETCH)
+#include <security/vboot/misc.h>
+#endif
 
 #define get_nth_byte(d, n)	((d >> (8 * n)) & 0xff)
 
@@ -108,15 +112,19 @@ static int sector_erase(int offset)
 	return 0;
 }
 
-static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
-		    size_t dma_buf_len)
+static void dma_buffer(uintptr_t *dma_buf, size_t *dma_buf_len)
 {
-	struct stopwatch sw;
-
-	assert(IS_ALIGNED((uintptr_t)buf, SFLASH_DMA_ALIGN) &&
-	       IS_ALIGNED(len, SFLASH_DMA_ALIGN) &&
-	       len <= dma_buf_len);
+	if (ENV_BOOTBLOCK || ENV_VERSTAGE) {
+		*dma_buf = (uintptr_t)_dma_coherent;
+		*dma_buf_len = _dma_coherent_size;
+	} else {
+		*dma_buf = (uintptr_t)_dram_dma;
+		*dma_buf_len = _dram_dma_size;
+	}
+}
 
+static void dma_read_start(u32 addr, u32 len, uintptr_t dma_buf)
+{
 	/* do dma reset */
 	write32(&mt8173_nor->fdma_ctl, SFLASH_DMA_SW_RESET);
 	write32(&mt8173_nor->fdma_ctl, SFLASH_DMA_WDLE_EN);
@@ -126,6 +134,11 @@ static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
 	write32(&mt8173_nor->fdma_end_dadr, (dma_buf + len));
 	/* start dma */
 	write32(&mt8173_nor->fdma_ctl, SFLASH_DMA_TRIGGER | SFLASH_DMA_WDLE_EN);
+}
+
+static int dma_read_wait(void)
+{
+	struct stopwatch sw;
 
 	stopwatch_init_usecs_expire(&sw, SFLASH_POLLINGREG_US);
 	while ((read32(&mt8173_nor->fdma_ctl) & SFLASH_DMA_TRIGGER) != 0) {
@@ -135,6 +148,20 @@ static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
 		}
 	}
 
+	return 0;
+}
+
+static int dma_read(u32 addr, u8 *buf, u32 len, uintptr_t dma_buf,
+		    size_t dma_buf_len)
+{
+	assert(IS_ALIGNED((uintptr_t)buf, SFLASH_DMA_ALIGN) &&
+	       IS_ALIGNED(len, SFLASH_DMA_ALIGN) &&
+	       len <= dma_buf_len);
+
+	dma_read_start(addr, len, dma_buf);
+	if (dma_read_wait())
+		return -1;
+
 	memcpy(buf, (const void *)dma_buf, len);
 	return 0;
 }
@@ -169,13 +196,7 @@ static int nor_read(const struct spi_flash *flash, u32 addr, size_t len,
 		done += next;
 	}
 
-	if (ENV_BOOTBLOCK || ENV_VERSTAGE) {
-		dma_buf = (uintptr_t)_dma_coherent;
-		dma_buf_len = _dma_coherent_size;
-	} else {
-		dma_buf = (uintptr_t)_dram_dma;
-		dma_buf_len = _dram_dma_size;
-	}
+	dma_buffer(&dma_buf, &dma_buf_len);
 
 	while (len - done >= SFLASH_DMA_ALIGN) {
 		next = MIN(dma_buf_len, ALIGN_DOWN(len - done,
@@ -228,6 +249,55 @@ static int nor_erase(const struct spi_flash *flash, u32 offset, size_t len)
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_VBOOT_HASH_BODY_PREFETCH)
+/*
+ * Let vboot hash one block of the firmware body while the DMA engine reads
+ * the next one into the bounce buffer. vboot has at most one read in flight,
+ * which is all the single bounce buffer allows. Reads that can't go through
+ * DMA are done synchronously in vboot_hash_read_finish().
+ */
+static int hash_dma_busy;
+
+int vboot_hash_read_start(const struct region_device *rdev, void *buf,
+			  size_t offset, size_t size)
+{
+	uintptr_t dma_buf;
+	size_t dma_buf_len;
+
+	dma_buffer(&dma_buf, &dma_buf_len);
+
+	if (rdev->root != boot_device_ro() ||
+	    !IS_ALIGNED(size, SFLASH_DMA_ALIGN) || size > dma_buf_len)
+		return 0;
+
+	dma_read_start(region_device_offset(rdev) + offset, size, dma_buf);
+	hash_dma_busy = 1;
+
+	return 0;
+}
+
+int vboot_hash_read_finish(const struct region_device *rdev, void *buf,
+			   size_t offset, size_t size)
+{
+	uintptr_t dma_buf;
+	size_t dma_buf_len;
+
+	if (!hash_dma_busy) {
+		if (rdev_readat(rdev, buf, offset, size) < 0)
+			return -1;
+		return 0;
+	}
+
+	hash_dma_busy = 0;
+	if (dma_read_wait())
+		return -1;
+
+	dma_buffer(&dma_buf, &dma_buf_len);
+	memcpy(buf, (const void *)dma_buf, size);
+	return 0;
+}
+#endif
+
 const struct spi_flash_ops spi_flash_ops = {
 	.read = nor_read,
 	.write = nor_write,
@@ -55,6 +55,9 @@ enum {
 
 	EMC_TIMING_CONTROL_TIMING_UPDATE = 1,
 
+	EMC_STATUS_TIMING_UPDATE_STALLED = 1 << 23,
+	EMC_AUTO_CAL_STATUS_ACTIVE = 1 << 31,
+
 	EMC_PIN_GPIOEN_SHIFT = 16,
 	EMC_PIN_GPIO_SHIFT = 12,
 	EMC_PMACRO_BRICK_CTRL_RFU1_RESET_VAL = 0x1FFF1FFF,
@@ -0,0 +1,32 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __SOC_NVIDIA_TEGRA210_WARM_CACHE_H__
+#define __SOC_NVIDIA_TEGRA210_WARM_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Returns 1 if the ROM mirror at base still hashes to the value recorded by
+ * warm_cache_rom_update() on an earlier boot, 0 otherwise.
+ */
+int warm_cache_rom_valid(const void *base, size_t size);
+
+/*
+ * Record the hash of a freshly transferred ROM mirror. Stages cached from a
+ * previous mirror are invalidated.
+ */
+void warm_cache_rom_update(const void *base, size_t size);
+
+#endif /* __SOC_NVIDIA_TEGRA210_WARM_CACHE_H__ */
@@ -49,7 +49,9 @@ void romstage(void)
 	printk(BIOS_INFO, "T210 romstage: SDRAM init done by BootROM, RAMCODE = %d\n",
 		sdram_get_ram_code());
 #else
+	timestamp_add_now(TS_BEFORE_INITRAM);
 	sdram_init(get_sdram_config());
+	timestamp_add_now(TS_AFTER_INITRAM);
 	printk(BIOS_INFO, "T210 romstage: sdram_init done\n");
 #endif
 
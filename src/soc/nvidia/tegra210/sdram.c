@@ -25,6 +25,8 @@
 #include <soc/sdram.h>
 #include <stdlib.h>
 #include <soc/nvidia/tegra/apbmisc.h>
+#include <timer.h>
+#include <timestamp.h>
 
 static void sdram_patch(uintptr_t addr, uint32_t value)
 {
@@ -42,6 +44,44 @@ static void sdram_trigger_emc_timing_update(struct tegra_emc_regs *regs)
 	write32(&regs->timing_control, EMC_TIMING_CONTROL_TIMING_UPDATE);
 }
 
+/*
+ * Poll until (*addr & mask) == value. Returns 0 on success, -1 if that
+ * didn't happen within timeout_us.
+ */
+static int sdram_wait_for_bits(uint32_t *addr, uint32_t mask, uint32_t value,
+			       uint32_t timeout_us)
+{
+	struct stopwatch sw;
+
+	stopwatch_init_usecs_expire(&sw, timeout_us);
+	while ((read32(addr) & mask) != value) {
+		if (stopwatch_expired(&sw))
+			return -1;
+	}
+	return 0;
+}
+
+/*
+ * Wait for an EMC operation that was just triggered and reports itself
+ * through a busy bit. The busy bit may not be set yet right after the
+ * trigger, so it has to be seen set before it is polled for clear. If it is
+ * never seen set, the operation may have finished between two reads, so
+ * this falls back to the full BCT wait that used to be a fixed delay.
+ * Otherwise the BCT wait is the upper bound for the operation to finish.
+ */
+static void sdram_wait_for_emc(const char *what, uint32_t *addr,
+			       uint32_t busy, uint32_t wait_us)
+{
+	if (sdram_wait_for_bits(addr, busy, busy, wait_us) < 0)
+		return;
+
+	if (sdram_wait_for_bits(addr, busy, 0, wait_us) < 0) {
+		printk(BIOS_ERR, "SDRAM: %s still busy after %uus\n", what,
+		       wait_us);
+		die("SDRAM: EMC operation timed out.\n");
+	}
+}
+
 /* PMC must be configured before clock-enable and de-reset of MC/EMC. */
 static void sdram_configure_pmc(const struct sdram_params *param,
 				struct tegra_pmc_regs *regs)
@@ -642,7 +682,8 @@ static void sdram_init_emc(const struct sdram_params *param,
 
 	write32(&regs->auto_cal_interval, param->EmcAutoCalInterval);
 	write32(&regs->auto_cal_config, param->EmcAutoCalConfig);
-	udelay(param->EmcAutoCalWait);
+	sdram_wait_for_emc("auto calibration", &regs->auto_cal_status,
+			   EMC_AUTO_CAL_STATUS_ACTIVE, param->EmcAutoCalWait);
 }
 
 static void sdram_set_emc_timing(const struct sdram_params *param,
@@ -953,7 +994,9 @@ static void sdram_set_zq_calibration(const struct sdram_params *param,
 	}
 
 	sdram_trigger_emc_timing_update(regs);
-	udelay(param->EmcTimingControlWait);
+	sdram_wait_for_emc("timing update", &regs->status,
+			   EMC_STATUS_TIMING_UPDATE_STALLED,
+			   param->EmcTimingControlWait);
 }
 
 static void sdram_set_refresh(const struct sdram_params *param,
@@ -1040,25 +1083,37 @@ void sdram_init(const struct sdram_params *param)
 
 	sdram_configure_pmc(param, pmc);
 	sdram_patch(param->EmcBctSpare0, param->EmcBctSpare1);
+	timestamp_add_now(TS_SDRAM_CONFIGURE_PMC);
 
 	sdram_set_dpd(param, pmc);
+	timestamp_add_now(TS_SDRAM_SET_DPD);
 	sdram_start_clocks(param, emc);
+	timestamp_add_now(TS_SDRAM_START_CLOCKS);
 	sdram_set_pad_macros(param, emc);
 	sdram_patch(param->EmcBctSpare4, param->EmcBctSpare5);
+	timestamp_add_now(TS_SDRAM_SET_PAD_MACROS);
 
 	sdram_trigger_emc_timing_update(emc);
 	sdram_init_mc(param, mc);
+	timestamp_add_now(TS_SDRAM_INIT_MC);
 	sdram_init_emc(param, emc);
 	sdram_patch(param->EmcBctSpare8, param->EmcBctSpare9);
+	timestamp_add_now(TS_SDRAM_INIT_EMC);
 
 	sdram_set_emc_timing(param, emc);
 	sdram_patch_bootrom(param, mc);
+	timestamp_add_now(TS_SDRAM_SET_EMC_TIMING);
 	sdram_rel_dpd(param, pmc);
+	timestamp_add_now(TS_SDRAM_REL_DPD);
 	sdram_set_zq_calibration(param, emc);
+	timestamp_add_now(TS_SDRAM_SET_ZQ_CALIBRATION);
 	sdram_set_ddr_control(param, pmc);
+	timestamp_add_now(TS_SDRAM_SET_DDR_CONTROL);
 	sdram_set_clock_enable_signal(param, emc);
+	timestamp_add_now(TS_SDRAM_CLOCK_ENABLE);
 
 	sdram_init_zq_calibration(param, emc);
+	timestamp_add_now(TS_SDRAM_INIT_ZQ_CALIBRATION);
 
 	/* Set package and DPD pad control */
 	write32(&pmc->ddr_cfg, param->PmcDdrCfg);
@@ -1074,6 +1129,8 @@ void sdram_init(const struct sdram_params *param)
 
 	sdram_trigger_emc_timing_update(emc);
 	sdram_set_refresh(param, emc);
+	timestamp_add_now(TS_SDRAM_SET_REFRESH);
 	sdram_enable_arbiter(param);
 	sdram_lock_carveouts(param, mc);
+	timestamp_add_now(TS_SDRAM_LOCK_CARVEOUTS);
 }
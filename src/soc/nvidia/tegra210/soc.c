@@ -29,12 +29,32 @@
 #include <soc/mc.h>
 #include <soc/nvidia/tegra/apbmisc.h>
 #include <string.h>
+#include <symbols.h>
 #include <timer.h>
 #include <soc/sdram.h>
 #include <soc/sdram_configs.h>
 
 #include "chip.h"
 
+/* The ROM mirror only exists on mainboards that load CBFS into SDRAM. */
+extern u8 _warm_cache[];
+extern u8 _ewarm_cache[];
+extern u8 _rom_copy[];
+extern u8 _erom_copy[];
+DECLARE_OPTIONAL_REGION(warm_cache);
+DECLARE_OPTIONAL_REGION(rom_copy);
+
+static void reserve_region(device_t dev, unsigned long *index,
+			   const u8 *start, const u8 *end)
+{
+	uintptr_t base = (uintptr_t)start / KiB;
+
+	if (start == end)
+		return;
+	reserved_ram_resource(dev, (*index)++, base,
+			      DIV_ROUND_UP((uintptr_t)end, KiB) - base);
+}
+
 static void soc_read_resources(device_t dev)
 {
 	unsigned long index = 0;
@@ -48,6 +68,15 @@ static void soc_read_resources(device_t dev)
 		reserved_ram_resource(dev, index++, begin * KiB, size * KiB);
 	}
 
+	/*
+	 * The warm reboot cache and the ROM mirror it vouches for have to
+	 * survive the payload and the OS until the next reset.
+	 */
+	if (IS_ENABLED(CONFIG_TEGRA210_WARM_REBOOT_CACHE)) {
+		reserve_region(dev, &index, _warm_cache, _ewarm_cache);
+		reserve_region(dev, &index, _rom_copy, _erom_copy);
+	}
+
 	memory_in_range_below_4gb(&begin, &end);
 	size = end - begin;
 	ram_resource(dev, index++, begin * KiB, size * KiB);
@@ -0,0 +1,165 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <console/console.h>
+#include <program_loading.h>
+#include <soc/warm_cache.h>
+#include <stage_cache.h>
+#include <string.h>
+
+/*
+ * Stage cache that lives in a DRAM carve-out which is not touched on reset.
+ * Nothing in it can be trusted after a reset (DRAM may have decayed, or the
+ * OS may have reused the memory), so every item carries a hash and is only
+ * used if it still matches.
+ *
+ * Layout: struct warm_cache_header at _warm_cache, followed by the copy of
+ * ramstage. Only STAGE_RAMSTAGE is cached, it's the only stage romstage
+ * loads on this SoC.
+ */
+
+extern u8 _warm_cache[];
+extern u8 _ewarm_cache[];
+#define _warm_cache_size (_ewarm_cache - _warm_cache)
+
+#define WARM_CACHE_MAGIC	0x4d524157	/* "WARM" */
+#define WARM_CACHE_DATA_OFFSET	4096
+
+struct warm_cache_stage {
+	uint32_t size;
+	uint32_t hash;
+	/* ROM mirror hash at the time the stage was cached. */
+	uint32_t rom_hash;
+	struct stage_cache meta;
+};
+
+struct warm_cache_header {
+	uint32_t magic;
+	uint32_t rom_size;
+	uint32_t rom_hash;
+	struct warm_cache_stage ramstage;
+	/* Hash of all fields above. */
+	uint32_t hash;
+};
+
+_Static_assert(sizeof(struct warm_cache_header) <= WARM_CACHE_DATA_OFFSET,
+	       "warm cache header too large");
+
+static struct warm_cache_header *warm_cache_header(void)
+{
+	return (struct warm_cache_header *)_warm_cache;
+}
+
+/* 32-bit FNV-1a. Only meant to catch decayed or reused memory. */
+static uint32_t warm_cache_hash(const void *buf, size_t size)
+{
+	const uint32_t *words = buf;
+	const uint8_t *bytes;
+	uint32_t hash = 2166136261;
+	size_t i;
+
+	for (i = 0; i < size / sizeof(*words); i++)
+		hash = (hash ^ words[i]) * 16777619;
+
+	bytes = (const uint8_t *)&words[i];
+	for (i = 0; i < size % sizeof(*words); i++)
+		hash = (hash ^ bytes[i]) * 16777619;
+
+	return hash;
+}
+
+static uint32_t header_hash(const struct warm_cache_header *hdr)
+{
+	return warm_cache_hash(hdr, offsetof(struct warm_cache_header, hash));
+}
+
+static int header_valid(const struct warm_cache_header *hdr)
+{
+	return hdr->magic == WARM_CACHE_MAGIC && hdr->hash == header_hash(hdr);
+}
+
+int warm_cache_rom_valid(const void *base, size_t size)
+{
+	const struct warm_cache_header *hdr = warm_cache_header();
+
+	if (!header_valid(hdr) || hdr->rom_size != size)
+		return 0;
+
+	return hdr->rom_hash == warm_cache_hash(base, size);
+}
+
+void warm_cache_rom_update(const void *base, size_t size)
+{
+	struct warm_cache_header *hdr = warm_cache_header();
+
+	memset(hdr, 0, sizeof(*hdr));
+	hdr->magic = WARM_CACHE_MAGIC;
+	hdr->rom_size = size;
+	hdr->rom_hash = warm_cache_hash(base, size);
+	hdr->hash = header_hash(hdr);
+}
+
+void stage_cache_add(int stage_id, const struct prog *stage)
+{
+	struct warm_cache_header *hdr = warm_cache_header();
+	struct warm_cache_stage *e = &hdr->ramstage;
+	void *c = _warm_cache + WARM_CACHE_DATA_OFFSET;
+
+	if (stage_id != STAGE_RAMSTAGE || !header_valid(hdr))
+		return;
+
+	if (prog_size(stage) > _warm_cache_size - WARM_CACHE_DATA_OFFSET) {
+		printk(BIOS_DEBUG, "Warm cache too small for %s\n",
+		       prog_name(stage));
+		return;
+	}
+
+	memcpy(c, prog_start(stage), prog_size(stage));
+
+	e->size = prog_size(stage);
+	e->hash = warm_cache_hash(c, e->size);
+	e->rom_hash = hdr->rom_hash;
+	e->meta.load_addr = (uintptr_t)prog_start(stage);
+	e->meta.entry_addr = (uintptr_t)prog_entry(stage);
+	e->meta.arg = (uintptr_t)prog_entry_arg(stage);
+	hdr->hash = header_hash(hdr);
+}
+
+void stage_cache_load_stage(int stage_id, struct prog *stage)
+{
+	const struct warm_cache_header *hdr = warm_cache_header();
+	const struct warm_cache_stage *e = &hdr->ramstage;
+	const void *c = _warm_cache + WARM_CACHE_DATA_OFFSET;
+	void *load_addr;
+
+	prog_set_entry(stage, NULL, NULL);
+
+	if (stage_id != STAGE_RAMSTAGE || !header_valid(hdr))
+		return;
+
+	if (e->size == 0 || e->rom_hash != hdr->rom_hash ||
+	    e->size > _warm_cache_size - WARM_CACHE_DATA_OFFSET ||
+	    e->hash != warm_cache_hash(c, e->size)) {
+		printk(BIOS_DEBUG, "No valid %s in warm cache\n",
+		       prog_name(stage));
+		return;
+	}
+
+	load_addr = (void *)(uintptr_t)e->meta.load_addr;
+	memcpy(load_addr, c, e->size);
+	prog_segment_loaded((uintptr_t)load_addr, e->size, SEG_FINAL);
+
+	prog_set_area(stage, load_addr, e->size);
+	prog_set_entry(stage, (void *)(uintptr_t)e->meta.entry_addr,
+		       (void *)(uintptr_t)e->meta.arg);
+}
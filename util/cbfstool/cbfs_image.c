@@ -523,6 +523,48 @@ static size_t cbfs_file_entry_metadata_size(const struct cbfs_file *f)
 	return ntohl(f->offset);
 }
 
+int cbfs_read_metadata(struct buffer *region, struct buffer *metadata)
+{
+	if (buffer_get(region) == NULL)
+		return 1;
+
+	struct cbfs_image image;
+	memset(&image, 0, sizeof(image));
+	if (cbfs_image_from_buffer(&image, region, 0)) {
+		ERROR("reading CBFS failed!\n");
+		return 1;
+	}
+
+	/* First pass: size of the stream. */
+	size_t size = 0;
+	struct cbfs_file *entry;
+	for (entry = buffer_get(region);
+	     cbfs_is_valid_entry(&image, entry);
+	     entry = cbfs_find_next_entry(&image, entry))
+		size += sizeof(uint32_t) +
+			cbfs_file_entry_metadata_size(entry);
+
+	if (buffer_create(metadata, size, "metadata"))
+		return 1;
+
+	/* Second pass: big endian offset within the region, then the
+	 * header, name and attributes of every file. */
+	uint8_t *out = (uint8_t *)buffer_get(metadata);
+	for (entry = buffer_get(region);
+	     cbfs_is_valid_entry(&image, entry);
+	     entry = cbfs_find_next_entry(&image, entry)) {
+		uint32_t offset = htonl((uint8_t *)entry -
+					(uint8_t *)buffer_get(region));
+		size_t len = cbfs_file_entry_metadata_size(entry);
+
+		memcpy(out, &offset, sizeof(offset));
+		memcpy(out + sizeof(offset), entry, len);
+		out += sizeof(offset) + len;
+	}
+
+	return 0;
+}
+
 static size_t cbfs_file_entry_data_size(const struct cbfs_file *f)
 {
 	return ntohl(f->len);
@@ -89,6 +89,12 @@ int cbfs_expand_to_region(struct buffer *region);
    size in the size argument. */
 int cbfs_truncate_space(struct buffer *region, uint32_t *size);
 
+/* Collect the metadata (header, name and attributes) of every file in a CBFS,
+   each preceded by its big endian offset within the region, into a newly
+   allocated buffer. This is what VBOOT_CBFS_FILE_HASHES signs instead of the
+   whole region. Returns 0 on success, otherwise non-zero. */
+int cbfs_read_metadata(struct buffer *region, struct buffer *metadata);
+
 /* Releases the CBFS image. Returns 0 on success, otherwise non-zero. */
 int cbfs_image_delete(struct cbfs_image *image);
 
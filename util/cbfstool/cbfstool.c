@@ -1070,6 +1070,27 @@ static int cbfs_read(void)
 	return buffer_write_file(param.image_region, param.filename);
 }
 
+static int cbfs_read_metadata_cmd(void)
+{
+	struct buffer metadata;
+
+	if (!param.filename) {
+		ERROR("You need to specify a valid output -f/--file.\n");
+		return 1;
+	}
+	if (!partitioned_file_is_partitioned(param.image_file)) {
+		ERROR("This operation isn't valid on legacy images having CBFS master headers\n");
+		return 1;
+	}
+
+	if (cbfs_read_metadata(param.image_region, &metadata))
+		return 1;
+
+	int ret = buffer_write_file(&metadata, param.filename);
+	buffer_delete(&metadata);
+	return ret;
+}
+
 static int cbfs_update_fit(void)
 {
 	if (!param.name) {
@@ -1182,6 +1203,7 @@ static const struct command commands[] = {
 	{"layout", "wvh?", cbfs_layout, false, false},
 	{"print", "H:r:vkh?", cbfs_print, true, false},
 	{"read", "r:f:vh?", cbfs_read, true, false},
+	{"read-metadata", "r:f:vh?", cbfs_read_metadata_cmd, true, false},
 	{"remove", "H:r:n:vh?", cbfs_remove, true, true},
 	{"update-fit", "H:r:n:x:vh?", cbfs_update_fit, true, true},
 	{"write", "r:f:i:Fudvh?", cbfs_write, true, true},
@@ -1337,6 +1359,8 @@ static void usage(char *name)
 			"Write file into same-size [or larger] raw region\n"
 	     " read [-r fmap-region] -f file                               "
 			"Extract raw region contents into binary file\n"
+	     " read-metadata [-r fmap-region] -f file                      "
+			"Extract all CBFS file headers with their offsets\n"
 	     " truncate [-r fmap-region]                                   "
 			"Truncate CBFS and print new size on stdout\n"
 	     " expand [-r fmap-region]                                     "
@@ -34,6 +34,8 @@
 #include <regex.h>
 #include <commonlib/cbmem_id.h>
 #include <commonlib/timestamp_serialized.h>
+#include <commonlib/profile_serialized.h>
+#include <commonlib/stage_usage_serialized.h>
 #include <commonlib/coreboot_tables.h>
 
 #ifdef __OpenBSD__
@@ -65,10 +67,15 @@ struct mapping {
 static int verbose = 0;
 #define debug(x...) if(verbose) printf(x)
 
-/* File handle used to access /dev/mem */
+/* File handle used to access /dev/mem, or a memory dump in offline mode */
 static int mem_fd;
 static struct mapping lbtable_mapping;
 
+/* Offline mode: physical address and size of the memory dump in mem_fd. */
+static int offline;
+static unsigned long long dump_base;
+static unsigned long long dump_size;
+
 static void die(const char *msg)
 {
 	if (msg)
@@ -126,6 +133,17 @@ static const void *map_memory(struct mapping *mapping, unsigned long long phys,
 			phys);
 	}
 
+	if (offline) {
+		/* Accesses past the end of a file mapping raise SIGBUS. */
+		if (phys < dump_base ||
+		    phys - dump_base + sz > dump_size) {
+			debug("0x%llx+0x%zx is outside of the memory dump.\n",
+				phys, sz);
+			return NULL;
+		}
+		phys -= dump_base;
+	}
+
 	v = mmap(NULL, mapping->virt_size, PROT_READ, MAP_SHARED, mem_fd,
 			phys - mapping->offset);
 
@@ -651,6 +669,481 @@ static void dump_timestamps(int mach_readable)
 	unmap_memory(&timestamp_mapping);
 }
 
+/* Convert a tick count to (fractional) microseconds for the trace viewer. */
+static double trace_ticks_to_us(uint64_t ticks, unsigned long freq_mhz)
+{
+	return (double)ticks / freq_mhz;
+}
+
+static void trace_print_event(int *first, const char *name, const char *ph,
+			      double ts, unsigned int pid, unsigned int tid)
+{
+	const char *c;
+
+	printf("%s\n  {\"name\": \"", *first ? "" : ",");
+	for (c = name; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			putchar('\\');
+		putchar(*c);
+	}
+	printf("\", \"ph\": \"%s\", \"ts\": %.3f, \"pid\": %u, \"tid\": %u",
+	       ph, ts, pid, tid);
+	*first = 0;
+}
+
+/*
+ * Dump the timestamps as instant events and the span table as begin/end
+ * events in the Chrome trace event format (chrome://tracing, Perfetto).
+ * Every CPU shows up as a process and every cooperative thread as a thread.
+ */
+static void dump_trace_json(void)
+{
+	const struct timestamp_table *tst_p;
+	const struct timestamp_span_table *spans;
+	struct mapping timestamp_mapping;
+	struct mapping span_mapping;
+	uint64_t span_addr;
+	size_t size;
+	unsigned long span_freq;
+	unsigned int max_cpu = 0;
+	int first = 1;
+	int i;
+
+	if (timestamps.tag != LB_TAG_TIMESTAMPS) {
+		fprintf(stderr, "No timestamps found in coreboot table.\n");
+		return;
+	}
+
+	size = sizeof(*tst_p);
+	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
+	if (!tst_p)
+		die("Unable to map timestamp header\n");
+
+	timestamp_set_tick_freq(tst_p->tick_freq_mhz);
+	size += tst_p->num_entries * sizeof(tst_p->entries[0]);
+
+	unmap_memory(&timestamp_mapping);
+
+	tst_p = map_memory(&timestamp_mapping, timestamps.cbmem_addr, size);
+	if (!tst_p)
+		die("Unable to map full timestamp table\n");
+
+	printf("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+
+	for (i = 0; i < tst_p->num_entries; i++) {
+		const struct timestamp_entry *tse = &tst_p->entries[i];
+
+		trace_print_event(&first, timestamp_name(tse->entry_id), "i",
+				  trace_ticks_to_us(tse->entry_stamp,
+						    tick_freq_mhz), 0, 0);
+		printf(", \"s\": \"g\", \"args\": {\"id\": %u}}",
+		       tse->entry_id);
+	}
+
+	unmap_memory(&timestamp_mapping);
+
+	if (find_cbmem_entry(CBMEM_ID_TIMESTAMP_SPANS, &span_addr, &size)) {
+		debug("No timestamp spans found.\n");
+		size = 0;
+	}
+
+	spans = NULL;
+	if (size >= sizeof(*spans)) {
+		spans = map_memory(&span_mapping, span_addr, size);
+		if (!spans)
+			die("Unable to map timestamp spans\n");
+		if (sizeof(*spans) + (uint64_t)spans->num_entries *
+		    sizeof(spans->entries[0]) > size)
+			die("Timestamp span table is corrupted\n");
+	}
+
+	span_freq = tick_freq_mhz;
+	if (spans && spans->tick_freq_mhz)
+		span_freq = spans->tick_freq_mhz;
+
+	for (i = 0; spans && i < spans->num_entries; i++) {
+		const struct timestamp_span_entry *tse = &spans->entries[i];
+
+		trace_print_event(&first, timestamp_name(tse->id),
+				  tse->type == TS_SPAN_BEGIN ? "B" : "E",
+				  trace_ticks_to_us(tse->stamp -
+						    spans->base_time, span_freq),
+				  tse->cpu, tse->thread);
+		printf(", \"args\": {\"arg\": %u, \"depth\": %u}}",
+		       tse->arg, tse->depth);
+		if (tse->cpu > max_cpu)
+			max_cpu = tse->cpu;
+	}
+
+	for (i = 0; i <= max_cpu; i++) {
+		trace_print_event(&first, "process_name", "M", 0, i, 0);
+		printf(", \"args\": {\"name\": \"CPU %d\"}}", i);
+	}
+
+	printf("\n]}\n");
+
+	if (spans) {
+		if (spans->dropped)
+			fprintf(stderr, "%u span events were dropped.\n",
+				spans->dropped);
+		unmap_memory(&span_mapping);
+	}
+}
+
+/*
+ * Timestamp analysis across many boots. Inputs are either the output of
+ * 'cbmem -T' (several dumps may be concatenated, each one starts with the
+ * ID 0 base time line) or archives written by --ts-archive.
+ *
+ * The archive format is "CBTS" followed by a little endian u32 version and
+ * then, per boot, the number of entries and for each entry its ID and the
+ * time in microseconds since the previous entry, all as LEB128 varints.
+ */
+#define TS_ARCHIVE_MAGIC "CBTS"
+#define TS_ARCHIVE_VERSION 1
+
+/* A median step time this much slower than the baseline is a regression. */
+#define TS_REGRESSION_PERCENT 10
+#define TS_REGRESSION_MIN_US 100
+
+struct ts_boot {
+	size_t num_entries;
+	uint32_t *ids;
+	uint64_t *steps;		/* microseconds since previous entry */
+};
+
+struct ts_boots {
+	size_t num_boots;
+	struct ts_boot *boots;
+};
+
+static void *xrealloc(void *ptr, size_t size)
+{
+	ptr = realloc(ptr, size);
+	if (!ptr)
+		die("Out of memory.\n");
+	return ptr;
+}
+
+static struct ts_boot *ts_new_boot(struct ts_boots *set)
+{
+	struct ts_boot *boot;
+
+	set->boots = xrealloc(set->boots,
+			      (set->num_boots + 1) * sizeof(*set->boots));
+	boot = &set->boots[set->num_boots++];
+	memset(boot, 0, sizeof(*boot));
+	return boot;
+}
+
+static void ts_add_entry(struct ts_boot *boot, uint32_t id, uint64_t step)
+{
+	boot->ids = xrealloc(boot->ids,
+			     (boot->num_entries + 1) * sizeof(*boot->ids));
+	boot->steps = xrealloc(boot->steps,
+			       (boot->num_entries + 1) * sizeof(*boot->steps));
+	boot->ids[boot->num_entries] = id;
+	boot->steps[boot->num_entries] = step;
+	boot->num_entries++;
+}
+
+static int ts_read_varint(FILE *f, uint64_t *val)
+{
+	int shift = 0;
+	int c;
+
+	*val = 0;
+	do {
+		c = fgetc(f);
+		if (c == EOF || shift > 63)
+			return -1;
+		*val |= (uint64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	return 0;
+}
+
+static void ts_write_varint(FILE *f, uint64_t val)
+{
+	do {
+		uint8_t c = val & 0x7f;
+
+		val >>= 7;
+		if (val)
+			c |= 0x80;
+		fputc(c, f);
+	} while (val);
+}
+
+static void ts_read_archive(FILE *f, const char *name, struct ts_boots *set)
+{
+	uint8_t version[4];
+	uint64_t count, id, step;
+
+	if (fread(version, sizeof(version), 1, f) != 1 ||
+	    (version[0] | version[1] << 8 | version[2] << 16 |
+	     (uint32_t)version[3] << 24) != TS_ARCHIVE_VERSION) {
+		fprintf(stderr, "%s: unsupported archive version\n", name);
+		exit(1);
+	}
+
+	while (!ts_read_varint(f, &count)) {
+		struct ts_boot *boot = ts_new_boot(set);
+
+		while (count--) {
+			if (ts_read_varint(f, &id) || ts_read_varint(f, &step)) {
+				fprintf(stderr, "%s: truncated archive\n",
+					name);
+				exit(1);
+			}
+			ts_add_entry(boot, id, step);
+		}
+	}
+}
+
+static void ts_read_text(FILE *f, const char *name, struct ts_boots *set)
+{
+	struct ts_boot *boot = NULL;
+	char line[256];
+	int lineno = 0;
+
+	while (fgets(line, sizeof(line), f)) {
+		unsigned long long abs_time, step;
+		unsigned int id;
+
+		lineno++;
+		if (sscanf(line, "%u\t%llu\t%llu", &id, &abs_time, &step) != 3) {
+			fprintf(stderr, "%s:%d: not a parseable timestamp\n",
+				name, lineno);
+			exit(1);
+		}
+
+		/* Every dump starts with the base time. */
+		if (id == 0 || boot == NULL)
+			boot = ts_new_boot(set);
+		ts_add_entry(boot, id, id == 0 ? abs_time : step);
+	}
+}
+
+static void ts_read_file(const char *name, struct ts_boots *set)
+{
+	char magic[4];
+	FILE *f;
+
+	f = fopen(name, "rb");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	if (fread(magic, sizeof(magic), 1, f) == 1 &&
+	    !memcmp(magic, TS_ARCHIVE_MAGIC, sizeof(magic))) {
+		ts_read_archive(f, name, set);
+	} else {
+		rewind(f);
+		ts_read_text(f, name, set);
+	}
+
+	fclose(f);
+}
+
+static void ts_write_archive(const char *name, const struct ts_boots *set)
+{
+	const uint8_t version[4] = { TS_ARCHIVE_VERSION, 0, 0, 0 };
+	size_t i, j;
+	FILE *f;
+
+	f = fopen(name, "wb");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	fwrite(TS_ARCHIVE_MAGIC, 4, 1, f);
+	fwrite(version, sizeof(version), 1, f);
+	for (i = 0; i < set->num_boots; i++) {
+		const struct ts_boot *boot = &set->boots[i];
+
+		ts_write_varint(f, boot->num_entries);
+		for (j = 0; j < boot->num_entries; j++) {
+			ts_write_varint(f, boot->ids[j]);
+			ts_write_varint(f, boot->steps[j]);
+		}
+	}
+
+	if (fclose(f))
+		die("Failed to write timestamp archive.\n");
+}
+
+/* Per-ID samples. ID 0 holds the total boot time instead of the base. */
+struct ts_stat {
+	uint32_t id;
+	size_t count;
+	uint64_t *samples;
+};
+
+struct ts_stats {
+	size_t num_ids;
+	struct ts_stat *ids;
+};
+
+static int ts_cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int ts_cmp_stat(const void *a, const void *b)
+{
+	const struct ts_stat *x = a, *y = b;
+
+	return x->id < y->id ? -1 : x->id > y->id;
+}
+
+static struct ts_stat *ts_find_stat(const struct ts_stats *stats, uint32_t id)
+{
+	struct ts_stat key = { .id = id };
+
+	return bsearch(&key, stats->ids, stats->num_ids, sizeof(key),
+		       ts_cmp_stat);
+}
+
+static void ts_add_sample(struct ts_stats *stats, uint32_t id, uint64_t val)
+{
+	struct ts_stat *stat;
+	size_t i;
+
+	for (i = 0; i < stats->num_ids; i++)
+		if (stats->ids[i].id == id)
+			break;
+
+	if (i == stats->num_ids) {
+		stats->ids = xrealloc(stats->ids,
+				      (i + 1) * sizeof(*stats->ids));
+		memset(&stats->ids[i], 0, sizeof(stats->ids[i]));
+		stats->ids[i].id = id;
+		stats->num_ids++;
+	}
+
+	stat = &stats->ids[i];
+	stat->samples = xrealloc(stat->samples,
+				 (stat->count + 1) * sizeof(*stat->samples));
+	stat->samples[stat->count++] = val;
+}
+
+static void ts_collect(const struct ts_boots *set, struct ts_stats *stats)
+{
+	size_t i, j;
+
+	memset(stats, 0, sizeof(*stats));
+	for (i = 0; i < set->num_boots; i++) {
+		const struct ts_boot *boot = &set->boots[i];
+		uint64_t total = 0;
+
+		for (j = 0; j < boot->num_entries; j++) {
+			if (boot->ids[j] == 0)
+				continue;
+			total += boot->steps[j];
+			ts_add_sample(stats, boot->ids[j], boot->steps[j]);
+		}
+		ts_add_sample(stats, 0, total);
+	}
+
+	for (i = 0; i < stats->num_ids; i++)
+		qsort(stats->ids[i].samples, stats->ids[i].count,
+		      sizeof(uint64_t), ts_cmp_u64);
+	qsort(stats->ids, stats->num_ids, sizeof(*stats->ids), ts_cmp_stat);
+}
+
+/* Nearest-rank percentile of sorted samples. */
+static uint64_t ts_percentile(const struct ts_stat *stat, unsigned int pct)
+{
+	size_t rank = (stat->count * pct + 99) / 100;
+
+	if (rank == 0)
+		rank = 1;
+	return stat->samples[rank - 1];
+}
+
+static const char *ts_stat_name(uint32_t id)
+{
+	return id == 0 ? "total time" : timestamp_name(id);
+}
+
+/* Returns the number of regressions against baseline (if given). */
+static int ts_analyze(const struct ts_boots *set,
+		      const struct ts_boots *baseline)
+{
+	struct ts_stats stats, base_stats;
+	int regressions = 0;
+	size_t i;
+
+	ts_collect(set, &stats);
+	if (baseline)
+		ts_collect(baseline, &base_stats);
+
+	printf("%zu boots, step times in microseconds\n\n", set->num_boots);
+	printf("%4s %-42s %6s %10s %10s %10s %10s%s\n", "ID", "name", "count",
+	       "p50", "p90", "p99", "max", baseline ? "   base p50" : "");
+
+	for (i = 0; i < stats.num_ids; i++) {
+		const struct ts_stat *stat = &stats.ids[i];
+		const struct ts_stat *base = NULL;
+		uint64_t p50 = ts_percentile(stat, 50);
+
+		printf("%4u %-42.42s %6zu %10llu %10llu %10llu %10llu",
+		       stat->id, ts_stat_name(stat->id), stat->count,
+		       (unsigned long long)p50,
+		       (unsigned long long)ts_percentile(stat, 90),
+		       (unsigned long long)ts_percentile(stat, 99),
+		       (unsigned long long)stat->samples[stat->count - 1]);
+
+		if (baseline)
+			base = ts_find_stat(&base_stats, stat->id);
+		if (base) {
+			uint64_t base_p50 = ts_percentile(base, 50);
+
+			printf(" %10llu", (unsigned long long)base_p50);
+			if (p50 > base_p50 + TS_REGRESSION_MIN_US &&
+			    p50 * 100 > base_p50 * (100 + TS_REGRESSION_PERCENT)) {
+				printf("  REGRESSION +%llu",
+				       (unsigned long long)(p50 - base_p50));
+				regressions++;
+			}
+		}
+		printf("\n");
+	}
+
+	return regressions;
+}
+
+static int ts_stats_main(int nfiles, char **files, const char *baseline_file,
+			 const char *archive_file)
+{
+	struct ts_boots set = { 0 }, baseline = { 0 };
+	int i;
+
+	if (nfiles == 0)
+		die("No timestamp dumps given.\n");
+
+	for (i = 0; i < nfiles; i++)
+		ts_read_file(files[i], &set);
+	if (baseline_file)
+		ts_read_file(baseline_file, &baseline);
+
+	if (archive_file) {
+		ts_write_archive(archive_file, &set);
+		return 0;
+	}
+
+	if (!set.num_boots)
+		die("No boots found in input.\n");
+
+	return ts_analyze(&set, baseline_file ? &baseline : NULL) ? 2 : 0;
+}
+
 struct cbmem_console {
 	u32 size;
 	u32 cursor;
@@ -750,6 +1243,68 @@ static void dump_console(int one_boot_only)
 	unmap_memory(&console_mapping);
 }
 
+/*
+ * Keep the console mapped and print whatever gets appended to it, without
+ * parsing the coreboot table again. Anything written between two polls in
+ * excess of the console size is lost.
+ */
+static void follow_console(unsigned int interval_ms)
+{
+	const struct cbmem_console *console_p;
+	struct mapping console_mapping;
+	size_t size, cursor, last;
+	char *buf;
+
+	if (console.tag != LB_TAG_CBMEM_CONSOLE)
+		return;
+
+	console_p = map_memory(&console_mapping, console.cbmem_addr,
+			       sizeof(*console_p));
+	if (!console_p)
+		die("Unable to map console object.\n");
+	size = console_p->size;
+	unmap_memory(&console_mapping);
+
+	console_p = map_memory(&console_mapping, console.cbmem_addr,
+			       size + sizeof(*console_p));
+	if (!console_p)
+		die("Unable to map full console object.\n");
+
+	buf = malloc(size);
+	if (!buf)
+		die("Not enough memory for console.\n");
+
+	last = console_p->cursor & CBMC_CURSOR_MASK;
+	while (1) {
+		size_t len, i;
+
+		usleep(interval_ms * 1000);
+
+		cursor = console_p->cursor & CBMC_CURSOR_MASK;
+		if (cursor == last || cursor > size)
+			continue;
+
+		if (cursor > last) {
+			len = cursor - last;
+			aligned_memcpy(buf, console_p->body + last, len);
+		} else {
+			/* Wrapped around the end of the ring buffer. */
+			len = size - last + cursor;
+			aligned_memcpy(buf, console_p->body + last,
+				       size - last);
+			aligned_memcpy(buf + size - last, console_p->body,
+				       cursor);
+		}
+		last = cursor;
+
+		for (i = 0; i < len; i++)
+			if (!isprint(buf[i]) && !isspace(buf[i]))
+				buf[i] = '?';
+		fwrite(buf, 1, len, stdout);
+		fflush(stdout);
+	}
+}
+
 static void hexdump(unsigned long memory, int length)
 {
 	int i;
@@ -1012,6 +1567,168 @@ static void dump_coverage(void)
 	unmap_memory(&coverage_mapping);
 }
 
+static int profile_cmp_pc(const void *a, const void *b)
+{
+	const uint64_t *pa = a, *pb = b;
+
+	return *pa < *pb ? -1 : *pa > *pb;
+}
+
+struct profile_hit {
+	uint64_t offset;
+	uint32_t count;
+};
+
+static int profile_cmp_count(const void *a, const void *b)
+{
+	const struct profile_hit *ha = a, *hb = b;
+
+	if (ha->count != hb->count)
+		return ha->count < hb->count ? 1 : -1;
+	return ha->offset < hb->offset ? -1 : ha->offset > hb->offset;
+}
+
+/*
+ * Print the sampling profiler histogram: one line per sampled address, as
+ * an offset from the start of the stage, most frequent first. Feed it to
+ * util/genprof/symbolize together with the stage ELF.
+ */
+static void dump_profile(void)
+{
+	const struct profile_samples *ps;
+	struct mapping profile_mapping;
+	struct profile_hit *hits;
+	uint64_t *pcs;
+	uint64_t start;
+	size_t size, num_hits, i;
+
+	if (find_cbmem_entry(CBMEM_ID_PROFILE, &start, &size)) {
+		fprintf(stderr, "No profile samples found\n");
+		return;
+	}
+
+	ps = map_memory(&profile_mapping, start, size);
+	if (!ps)
+		die("Unable to map profile samples.\n");
+	if (size < sizeof(*ps) || sizeof(*ps) + (uint64_t)ps->num_samples *
+	    sizeof(ps->samples[0]) > size)
+		die("Profile samples are corrupted.\n");
+
+	printf("# samples %u dropped %u interval_us %u program_base 0x%"
+	       PRIx64 "\n", ps->num_samples, ps->dropped, ps->interval_us,
+	       ps->program_base);
+
+	pcs = malloc(ps->num_samples * sizeof(*pcs) + 1);
+	hits = malloc(ps->num_samples * sizeof(*hits) + 1);
+	if (!pcs || !hits)
+		die("Out of memory.\n");
+
+	aligned_memcpy(pcs, ps->samples, ps->num_samples * sizeof(*pcs));
+	qsort(pcs, ps->num_samples, sizeof(*pcs), profile_cmp_pc);
+
+	num_hits = 0;
+	for (i = 0; i < ps->num_samples; i++) {
+		if (num_hits && hits[num_hits - 1].offset ==
+		    pcs[i] - ps->program_base) {
+			hits[num_hits - 1].count++;
+			continue;
+		}
+		hits[num_hits].offset = pcs[i] - ps->program_base;
+		hits[num_hits].count = 1;
+		num_hits++;
+	}
+	qsort(hits, num_hits, sizeof(*hits), profile_cmp_count);
+
+	for (i = 0; i < num_hits; i++)
+		printf("%u\t0x%" PRIx64 "\n", hits[i].count, hits[i].offset);
+
+	free(hits);
+	free(pcs);
+	unmap_memory(&profile_mapping);
+}
+
+/* Headroom on top of the measured usage when suggesting a size. */
+#define STAGE_USAGE_HEADROOM_PERCENT	25
+#define STAGE_USAGE_GRANULE		1024
+
+static const char *stage_usage_stage_name(uint8_t stage)
+{
+	switch (stage) {
+	case STAGE_USAGE_ROMSTAGE:
+		return "romstage";
+	case STAGE_USAGE_RAMSTAGE:
+		return "ramstage";
+	default:
+		return "unknown";
+	}
+}
+
+static const char *stage_usage_region_name(uint8_t region)
+{
+	switch (region) {
+	case STAGE_USAGE_STACK:
+		return "stack";
+	case STAGE_USAGE_HEAP:
+		return "heap";
+	case STAGE_USAGE_CBFS_CACHE:
+		return "cbfs cache";
+	case STAGE_USAGE_TIMESTAMP:
+		return "timestamps";
+	case STAGE_USAGE_CONSOLE:
+		return "console";
+	case STAGE_USAGE_CAR:
+		return "car";
+	default:
+		return "unknown";
+	}
+}
+
+/*
+ * Print the high-water mark of each region the stages recorded, together
+ * with a size that leaves some headroom. A region that is completely used
+ * may have overflowed, so the suggestion for it is only a lower bound.
+ */
+static void dump_stage_usage(void)
+{
+	const struct stage_usage_table *table;
+	struct mapping usage_mapping;
+	uint64_t start;
+	size_t size;
+	uint32_t i;
+
+	if (find_cbmem_entry(CBMEM_ID_STAGE_USAGE, &start, &size)) {
+		fprintf(stderr, "No stage usage found\n");
+		return;
+	}
+
+	table = map_memory(&usage_mapping, start, size);
+	if (!table)
+		die("Unable to map stage usage.\n");
+	if (size < sizeof(*table) || sizeof(*table) +
+	    (uint64_t)table->num_entries * sizeof(table->entries[0]) > size)
+		die("Stage usage is corrupted.\n");
+
+	printf("%-10s %-12s %10s %10s %10s\n", "stage", "region", "size",
+	       "used", "suggested");
+
+	for (i = 0; i < table->num_entries; i++) {
+		const struct stage_usage_entry *e = &table->entries[i];
+		uint64_t suggested;
+
+		suggested = e->used + (uint64_t)e->used *
+			STAGE_USAGE_HEADROOM_PERCENT / 100;
+		suggested = (suggested + STAGE_USAGE_GRANULE - 1) /
+			STAGE_USAGE_GRANULE * STAGE_USAGE_GRANULE;
+
+		printf("%-10s %-12s %10u %10u %10" PRIu64 "%s\n",
+		       stage_usage_stage_name(e->stage),
+		       stage_usage_region_name(e->region), e->size, e->used,
+		       suggested, e->used >= e->size ? " (full)" : "");
+	}
+
+	unmap_memory(&usage_mapping);
+}
+
 static void print_version(void)
 {
 	printf("cbmem v%s -- ", CBMEM_VERSION);
@@ -1028,16 +1745,25 @@ static void print_version(void)
 
 static void print_usage(const char *name, int exit_code)
 {
-	printf("usage: %s [-cCltTxVvh?]\n", name);
+	printf("usage: %s [-c1FCPultTjxVvh?] [-f FILE [-b ADDR]]\n", name);
 	printf("\n"
 	     "   -c | --console:                   print cbmem console\n"
 	     "   -1 | --oneboot:                   print cbmem console for last boot only\n"
+	     "   -F | --follow:                    keep printing new console output\n"
 	     "   -C | --coverage:                  dump coverage information\n"
+	     "   -P | --profile:                   print sampling profiler histogram\n"
+	     "   -u | --stage-usage:               print stack, heap and buffer usage of each stage\n"
 	     "   -l | --list:                      print cbmem table of contents\n"
 	     "   -x | --hexdump:                   print hexdump of cbmem area\n"
 	     "   -r | --rawdump ID:                print rawdump of specific ID (in hex) of cbtable\n"
 	     "   -t | --timestamps:                print timestamp information\n"
 	     "   -T | --parseable-timestamps:      print parseable timestamps\n"
+	     "   -j | --trace-json:                print timestamps and spans as Chrome trace JSON\n"
+	     "   -f | --file FILE:                 read a memory dump instead of /dev/mem\n"
+	     "   -b | --base ADDR:                 physical address of the dump (default 0)\n"
+	     "   -a | --ts-analyze FILE...:        timestamp statistics over many -T dumps\n"
+	     "   -B | --ts-baseline FILE:          ... and compare them against a baseline\n"
+	     "   -A | --ts-archive OUT FILE...:    pack -T dumps into a compact archive\n"
 	     "   -V | --verbose:                   verbose (debugging) output\n"
 	     "   -v | --version:                   print the version\n"
 	     "   -h | --help:                      print this help\n"
@@ -1160,27 +1886,111 @@ static char *dt_find_compat(const char *parent, const char *compat,
 }
 #endif /* __arm__ */
 
+/* Find and parse the coreboot table of the running system. */
+static void parse_live_cbtable(void)
+{
+#ifdef __arm__
+	int addr_cells, size_cells;
+	char *coreboot_node = dt_find_compat("/proc/device-tree", "coreboot",
+					     &addr_cells, &size_cells);
+
+	if (!coreboot_node) {
+		fprintf(stderr, "Could not find 'coreboot' compatible node!\n");
+		exit(1);
+	}
+
+	if (addr_cells < 0) {
+		fprintf(stderr, "Warning: no #address-cells node in tree!\n");
+		addr_cells = 1;
+	}
+
+	int nlen = strlen(coreboot_node);
+	char *reg = alloca(nlen + sizeof("/reg"));
+
+	strcpy(reg, coreboot_node);
+	strcpy(reg + nlen, "/reg");
+	free(coreboot_node);
+
+	int fd = open(reg, O_RDONLY);
+	if (fd < 0) {
+		perror(reg);
+		exit(1);
+	}
+
+	int i;
+	size_t size_to_read = addr_cells * 4 + size_cells * 4;
+	u8 *dtbuffer = alloca(size_to_read);
+	if (read(fd, dtbuffer, size_to_read) < 0) {
+		perror(reg);
+		exit(1);
+	}
+	close(fd);
+
+	/* No variable-length byte swap function anywhere in C... how sad. */
+	u64 baseaddr = 0;
+	for (i = 0; i < addr_cells * 4; i++) {
+		baseaddr <<= 8;
+		baseaddr |= *dtbuffer;
+		dtbuffer++;
+	}
+	u64 cb_table_size = 0;
+	for (i = 0; i < size_cells * 4; i++) {
+		cb_table_size <<= 8;
+		cb_table_size |= *dtbuffer;
+		dtbuffer++;
+	}
+
+	parse_cbtable(baseaddr, cb_table_size);
+#else
+	int j;
+	unsigned long long possible_base_addresses[] = { 0, 0xf0000 };
+
+	/* Find and parse coreboot table */
+	for (j = 0; j < ARRAY_SIZE(possible_base_addresses); j++) {
+		if (!parse_cbtable(possible_base_addresses[j], 0))
+			break;
+	}
+#endif
+}
+
 int main(int argc, char** argv)
 {
 	int print_defaults = 1;
 	int print_console = 0;
 	int print_coverage = 0;
+	int print_profile = 0;
+	int print_stage_usage = 0;
 	int print_list = 0;
 	int print_hexdump = 0;
 	int print_rawdump = 0;
 	int print_timestamps = 0;
 	int machine_readable_timestamps = 0;
+	int print_trace_json = 0;
 	int one_boot_only = 0;
+	int follow = 0;
 	unsigned int rawdump_id = 0;
+	const char *dump_file = NULL;
+	int ts_stats = 0;
+	const char *ts_baseline = NULL;
+	const char *ts_archive = NULL;
 
 	int opt, option_index = 0;
 	static struct option long_options[] = {
 		{"console", 0, 0, 'c'},
 		{"oneboot", 0, 0, '1'},
+		{"follow", 0, 0, 'F'},
+		{"file", required_argument, 0, 'f'},
+		{"base", required_argument, 0, 'b'},
+		{"ts-analyze", 0, 0, 'a'},
+		{"ts-baseline", required_argument, 0, 'B'},
+		{"ts-archive", required_argument, 0, 'A'},
 		{"coverage", 0, 0, 'C'},
+		{"profile", 0, 0, 'P'},
+		{"stage-usage", 0, 0, 'u'},
 		{"list", 0, 0, 'l'},
 		{"timestamps", 0, 0, 't'},
 		{"parseable-timestamps", 0, 0, 'T'},
+		{"trace-json", 0, 0, 'j'},
 		{"hexdump", 0, 0, 'x'},
 		{"rawdump", required_argument, 0, 'r'},
 		{"verbose", 0, 0, 'V'},
@@ -1188,7 +1998,7 @@ int main(int argc, char** argv)
 		{"help", 0, 0, 'h'},
 		{0, 0, 0, 0}
 	};
-	while ((opt = getopt_long(argc, argv, "c1CltTxVvh?r:",
+	while ((opt = getopt_long(argc, argv, "c1FCPultTjxVvh?r:f:b:aB:A:",
 				  long_options, &option_index)) != EOF) {
 		switch (opt) {
 		case 'c':
@@ -1200,10 +2010,40 @@ int main(int argc, char** argv)
 			one_boot_only = 1;
 			print_defaults = 0;
 			break;
+		case 'F':
+			print_console = 1;
+			follow = 1;
+			print_defaults = 0;
+			break;
+		case 'f':
+			dump_file = optarg;
+			break;
+		case 'b':
+			dump_base = strtoull(optarg, NULL, 0);
+			break;
+		case 'a':
+			ts_stats = 1;
+			break;
+		case 'B':
+			ts_stats = 1;
+			ts_baseline = optarg;
+			break;
+		case 'A':
+			ts_stats = 1;
+			ts_archive = optarg;
+			break;
 		case 'C':
 			print_coverage = 1;
 			print_defaults = 0;
 			break;
+		case 'P':
+			print_profile = 1;
+			print_defaults = 0;
+			break;
+		case 'u':
+			print_stage_usage = 1;
+			print_defaults = 0;
+			break;
 		case 'l':
 			print_list = 1;
 			print_defaults = 0;
@@ -1226,6 +2066,10 @@ int main(int argc, char** argv)
 			machine_readable_timestamps = 1;
 			print_defaults = 0;
 			break;
+		case 'j':
+			print_trace_json = 1;
+			print_defaults = 0;
+			break;
 		case 'V':
 			verbose = 1;
 			break;
@@ -1243,75 +2087,47 @@ int main(int argc, char** argv)
 		}
 	}
 
-	mem_fd = open("/dev/mem", O_RDONLY, 0);
-	if (mem_fd < 0) {
-		fprintf(stderr, "Failed to gain memory access: %s\n",
-			strerror(errno));
-		return 1;
-	}
-
-#ifdef __arm__
-	int addr_cells, size_cells;
-	char *coreboot_node = dt_find_compat("/proc/device-tree", "coreboot",
-					     &addr_cells, &size_cells);
-
-	if (!coreboot_node) {
-		fprintf(stderr, "Could not find 'coreboot' compatible node!\n");
-		return 1;
-	}
-
-	if (addr_cells < 0) {
-		fprintf(stderr, "Warning: no #address-cells node in tree!\n");
-		addr_cells = 1;
-	}
-
-	int nlen = strlen(coreboot_node);
-	char *reg = alloca(nlen + sizeof("/reg"));
-
-	strcpy(reg, coreboot_node);
-	strcpy(reg + nlen, "/reg");
-	free(coreboot_node);
+	if (ts_stats)
+		return ts_stats_main(argc - optind, argv + optind, ts_baseline,
+				     ts_archive);
 
-	int fd = open(reg, O_RDONLY);
-	if (fd < 0) {
-		perror(reg);
-		return 1;
-	}
-
-	int i;
-	size_t size_to_read = addr_cells * 4 + size_cells * 4;
-	u8 *dtbuffer = alloca(size_to_read);
-	if (read(fd, dtbuffer, size_to_read) < 0) {
-		perror(reg);
-		return 1;
-	}
-	close(fd);
+	if (dump_file) {
+		struct stat st;
 
-	/* No variable-length byte swap function anywhere in C... how sad. */
-	u64 baseaddr = 0;
-	for (i = 0; i < addr_cells * 4; i++) {
-		baseaddr <<= 8;
-		baseaddr |= *dtbuffer;
-		dtbuffer++;
-	}
-	u64 cb_table_size = 0;
-	for (i = 0; i < size_cells * 4; i++) {
-		cb_table_size <<= 8;
-		cb_table_size |= *dtbuffer;
-		dtbuffer++;
+		mem_fd = open(dump_file, O_RDONLY, 0);
+		if (mem_fd < 0 || fstat(mem_fd, &st)) {
+			fprintf(stderr, "Failed to open %s: %s\n", dump_file,
+				strerror(errno));
+			return 1;
+		}
+		if (dump_base % system_page_size())
+			die("Dump base address must be page aligned.\n");
+		offline = 1;
+		dump_size = st.st_size;
+	} else {
+		mem_fd = open("/dev/mem", O_RDONLY, 0);
+		if (mem_fd < 0) {
+			fprintf(stderr, "Failed to gain memory access: %s\n",
+				strerror(errno));
+			return 1;
+		}
 	}
 
-	parse_cbtable(baseaddr, cb_table_size);
-#else
-	int j;
-	unsigned long long possible_base_addresses[] = { 0, 0xf0000 };
+	if (offline) {
+		int j;
+		unsigned long long possible_base_addresses[] = { 0, 0xf0000 };
 
-	/* Find and parse coreboot table */
-	for (j = 0; j < ARRAY_SIZE(possible_base_addresses); j++) {
-		if (!parse_cbtable(possible_base_addresses[j], 0))
-			break;
+		/* Try the usual x86 locations, then search the whole dump. */
+		for (j = 0; j < ARRAY_SIZE(possible_base_addresses); j++) {
+			if (!parse_cbtable(dump_base +
+					   possible_base_addresses[j], 0))
+				break;
+		}
+		if (mapping_virt(&lbtable_mapping) == NULL)
+			parse_cbtable(dump_base, dump_size);
+	} else {
+		parse_live_cbtable();
 	}
-#endif
 
 	if (mapping_virt(&lbtable_mapping) == NULL)
 		die("Table not found.\n");
@@ -1319,9 +2135,18 @@ int main(int argc, char** argv)
 	if (print_console)
 		dump_console(one_boot_only);
 
+	if (follow)
+		follow_console(200);
+
 	if (print_coverage)
 		dump_coverage();
 
+	if (print_profile)
+		dump_profile();
+
+	if (print_stage_usage)
+		dump_stage_usage();
+
 	if (print_list)
 		dump_cbmem_toc();
 
@@ -1334,6 +2159,9 @@ int main(int argc, char** argv)
 	if (print_defaults || print_timestamps)
 		dump_timestamps(machine_readable_timestamps);
 
+	if (print_trace_json)
+		dump_trace_json();
+
 	unmap_memory(&lbtable_mapping);
 
 	close(mem_fd);
@@ -0,0 +1,935 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * The instructions follow the pseudocode of the ARMv8-A Architecture
+ * Reference Manual. Registers live in host variables, memory accesses go
+ * straight to host memory, which has to be little endian like the target.
+ * adrp yields the full address of a symbol, so the :lo12: add is a no-op.
+ */
+
+#include <commonlib/helpers.h>
+#include <string.h>
+#include <swab.h>
+
+#include "a64.h"
+#include "hosttest.h"
+
+enum {
+	OP_ADD_X,
+	OP_ADD_V,
+	OP_ADRP,
+	OP_MOV_V,
+	OP_LD1,
+	OP_LD1R,
+	OP_LDR_S,
+	OP_ST1,
+	OP_STR_S,
+	OP_REV32,
+	OP_CBZ,
+	OP_SUBS,
+	OP_B_NE,
+	OP_RET,
+	/* Crypto Extension */
+	OP_SHA1C,
+	OP_SHA1P,
+	OP_SHA1M,
+	OP_SHA1H,
+	OP_SHA1SU0,
+	OP_SHA1SU1,
+	OP_SHA256H,
+	OP_SHA256H2,
+	OP_SHA256SU0,
+	OP_SHA256SU1,
+};
+
+/*
+ * Operand kinds, as used in the operand strings below:
+ * x Xn, q Qn, s Sn, v Vn.4S, b Vn.16B, i #imm, m [Xn{, #imm}],
+ * l {Vn.4S-Vm.4S} or {Vn.16B-Vm.16B}, y symbol or label, o :lo12:symbol
+ */
+static const struct {
+	const char *name;
+	const char *operands;
+	uint8_t op;
+} a64_ops[] = {
+	{ "add",	"xxo",	OP_ADD_X },
+	{ "add",	"xxi",	OP_ADD_X },
+	{ "add",	"vvv",	OP_ADD_V },
+	{ "adrp",	"xy",	OP_ADRP },
+	{ "mov",	"bb",	OP_MOV_V },
+	{ "ld1",	"lm",	OP_LD1 },
+	{ "ld1",	"lmi",	OP_LD1 },
+	{ "ld1r",	"lm",	OP_LD1R },
+	{ "ld1r",	"lmi",	OP_LD1R },
+	{ "ldr",	"sm",	OP_LDR_S },
+	{ "st1",	"lm",	OP_ST1 },
+	{ "st1",	"lmi",	OP_ST1 },
+	{ "str",	"sm",	OP_STR_S },
+	{ "rev32",	"bb",	OP_REV32 },
+	{ "cbz",	"xy",	OP_CBZ },
+	{ "subs",	"xxi",	OP_SUBS },
+	{ "b.ne",	"y",	OP_B_NE },
+	{ "ret",	"",	OP_RET },
+	{ "sha1c",	"qsv",	OP_SHA1C },
+	{ "sha1p",	"qsv",	OP_SHA1P },
+	{ "sha1m",	"qsv",	OP_SHA1M },
+	{ "sha1h",	"ss",	OP_SHA1H },
+	{ "sha1su0",	"vvv",	OP_SHA1SU0 },
+	{ "sha1su1",	"vv",	OP_SHA1SU1 },
+	{ "sha256h",	"qqv",	OP_SHA256H },
+	{ "sha256h2",	"qqv",	OP_SHA256H2 },
+	{ "sha256su0",	"vv",	OP_SHA256SU0 },
+	{ "sha256su1",	"vvv",	OP_SHA256SU1 },
+};
+
+struct operand {
+	char kind;
+	int reg;
+	int count;		/* l: number of registers */
+	int bytes;		/* l: 'v' or 'b' arrangement */
+	int64_t imm;		/* i, m: immediate or offset */
+	char sym[A64_NAME_LEN];
+};
+
+#define MAX_OPERANDS	4
+#define MAX_LINE	256
+#define MAX_DEPTH	4
+
+static int error(struct a64_prog *prog, const char *msg, const char *what)
+{
+	host_printf("a64: line %d: %s%s%s\n", prog->line, msg,
+		    what ? ": " : "", what ? what : "");
+	return -1;
+}
+
+static int is_ident(char c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+		isdigit(c) || c == '_' || c == '.';
+}
+
+static const char *skip_space(const char *s)
+{
+	while (*s == ' ' || *s == '\t')
+		s++;
+	return s;
+}
+
+/* Copies an identifier to name, returns the first character after it. */
+static const char *get_ident(const char *s, char *name)
+{
+	int i = 0;
+
+	while (is_ident(*s) && i < A64_NAME_LEN - 1)
+		name[i++] = *s++;
+	name[i] = '\0';
+
+	return s;
+}
+
+/* Decimal or hex number. Returns the first character after it or NULL. */
+static const char *get_number(const char *s, int64_t *val)
+{
+	int neg = 0, base = 10;
+	uint64_t v = 0;
+	const char *start;
+
+	if (*s == '-') {
+		neg = 1;
+		s++;
+	}
+	if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+		base = 16;
+		s += 2;
+	}
+	for (start = s; ; s++) {
+		int c = tolower(*s);
+
+		if (isdigit(c))
+			v = v * base + c - '0';
+		else if (base == 16 && c >= 'a' && c <= 'f')
+			v = v * base + c - 'a' + 10;
+		else
+			break;
+	}
+	if (s == start)
+		return NULL;
+
+	*val = neg ? -(int64_t)v : (int64_t)v;
+	return s;
+}
+
+/* A register named prefix followed by its number, e.g. x8 or v16. */
+static const char *get_reg(const char *s, char prefix, int *reg)
+{
+	int64_t n;
+
+	if (*s != prefix || !isdigit(s[1]))
+		return NULL;
+	s = get_number(s + 1, &n);
+	if (s == NULL || n > 31)
+		return NULL;
+	*reg = n;
+
+	return s;
+}
+
+/* Vn.4S or Vn.16B. Returns the operand kind, 'v' or 'b', or 0. */
+static int get_vreg(const char **s, int *reg)
+{
+	const char *p = get_reg(*s, 'v', reg);
+
+	if (p == NULL || *p != '.')
+		return 0;
+	if (!strncmp(p, ".4s", 3)) {
+		*s = p + 3;
+		return 'v';
+	}
+	if (!strncmp(p, ".16b", 4)) {
+		*s = p + 4;
+		return 'b';
+	}
+	return 0;
+}
+
+static int parse_operand(struct a64_prog *prog, const char *s,
+			 struct operand *op)
+{
+	const char *p;
+
+	memset(op, 0, sizeof(*op));
+
+	if (*s == '{') {
+		int reg;
+
+		op->kind = 'l';
+		s = skip_space(s + 1);
+		for (;;) {
+			int kind = get_vreg(&s, &reg);
+
+			if (!kind || (op->count && (kind != op->bytes ||
+					reg != (op->reg + op->count) % 32)))
+				return error(prog, "bad register list", NULL);
+			if (!op->count++) {
+				op->reg = reg;
+				op->bytes = kind;
+			}
+			s = skip_space(s);
+			if (*s == '}')
+				break;
+			if (*s != ',')
+				return error(prog, "bad register list", NULL);
+			s = skip_space(s + 1);
+		}
+		s++;
+	} else if (*s == '[') {
+		op->kind = 'm';
+		s = get_reg(skip_space(s + 1), 'x', &op->reg);
+		if (s == NULL)
+			return error(prog, "bad address", NULL);
+		s = skip_space(s);
+		if (*s == ',') {
+			s = skip_space(s + 1);
+			if (*s != '#' || !(s = get_number(s + 1, &op->imm)))
+				return error(prog, "bad offset", NULL);
+			s = skip_space(s);
+		}
+		if (*s++ != ']')
+			return error(prog, "bad address", NULL);
+	} else if (*s == '#') {
+		op->kind = 'i';
+		s = get_number(s + 1, &op->imm);
+		if (s == NULL)
+			return error(prog, "bad immediate", NULL);
+	} else if (!strncmp(s, ":lo12:", 6)) {
+		op->kind = 'o';
+		s = get_ident(s + 6, op->sym);
+	} else if ((p = get_reg(s, 'x', &op->reg)) && !is_ident(*p)) {
+		op->kind = 'x';
+		s = p;
+	} else if ((p = get_reg(s, 'q', &op->reg)) && !is_ident(*p)) {
+		op->kind = 'q';
+		s = p;
+	} else if ((p = get_reg(s, 's', &op->reg)) && !is_ident(*p)) {
+		op->kind = 's';
+		s = p;
+	} else if ((op->kind = get_vreg(&s, &op->reg))) {
+		/* done */
+	} else {
+		op->kind = 'y';
+		s = get_ident(s, op->sym);
+	}
+
+	if (*skip_space(s) != '\0')
+		return error(prog, "bad operand", s);
+
+	return 0;
+}
+
+/* Splits at the commas that are not inside {} or []. */
+static int split_operands(char *s, char **ops, int max)
+{
+	int n = 0, depth = 0;
+
+	s = (char *)skip_space(s);
+	if (*s == '\0')
+		return 0;
+
+	ops[n++] = s;
+	for (; *s; s++) {
+		if (*s == '{' || *s == '[')
+			depth++;
+		else if (*s == '}' || *s == ']')
+			depth--;
+		else if (*s == ',' && !depth) {
+			if (n == max)
+				return -1;
+			*s = '\0';
+			ops[n++] = (char *)skip_space(s + 1);
+		}
+	}
+
+	return n;
+}
+
+static int encode(struct a64_prog *prog, const char *name, char *args)
+{
+	struct operand op[MAX_OPERANDS];
+	char *text[MAX_OPERANDS];
+	struct a64_insn *insn;
+	int regs[3] = { 0 };
+	int i, n, nregs = 0;
+	size_t k;
+
+	n = split_operands(args, text, MAX_OPERANDS);
+	if (n < 0)
+		return error(prog, "too many operands", name);
+	for (i = 0; i < n; i++)
+		if (parse_operand(prog, text[i], &op[i]))
+			return -1;
+
+	for (k = 0; k < ARRAY_SIZE(a64_ops); k++) {
+		const char *kinds = a64_ops[k].operands;
+
+		if (strcmp(a64_ops[k].name, name) || strlen(kinds) != n)
+			continue;
+		for (i = 0; i < n; i++)
+			if (op[i].kind != kinds[i])
+				break;
+		if (i == n)
+			break;
+	}
+	if (k == ARRAY_SIZE(a64_ops))
+		return error(prog, "unknown instruction or operands", name);
+
+	if (prog->num_insns == A64_MAX_INSNS)
+		return error(prog, "too many instructions", NULL);
+	insn = &prog->insn[prog->num_insns++];
+	memset(insn, 0, sizeof(*insn));
+	insn->op = a64_ops[k].op;
+	insn->line = prog->line;
+
+	for (i = 0; i < n; i++) {
+		switch (op[i].kind) {
+		case 'l':
+			insn->count = op[i].count;
+			if (insn->op == OP_LD1R &&
+			    (op[i].count != 1 || op[i].bytes != 'v'))
+				return error(prog, "ld1r takes one .4s", NULL);
+			/* fall through */
+		case 'x':
+		case 'q':
+		case 's':
+		case 'v':
+		case 'b':
+			regs[nregs++] = op[i].reg;
+			break;
+		case 'm':
+			if (insn->count && op[i].imm)
+				return error(prog, "no offset for lists",
+					     NULL);
+			regs[nregs++] = op[i].reg;
+			insn->imm = op[i].imm;
+			break;
+		case 'i':
+			insn->post = insn->count != 0;
+			insn->imm = op[i].imm;
+			break;
+		case 'y':
+		case 'o':
+			strcpy(insn->sym, op[i].sym);
+			break;
+		}
+	}
+	insn->d = regs[0];
+	insn->n = regs[1];
+	insn->m = regs[2];
+
+	return 0;
+}
+
+static int define_label(struct a64_prog *prog, const char *name)
+{
+	struct a64_label *label;
+
+	if (prog->num_labels == A64_MAX_LABELS)
+		return error(prog, "too many labels", NULL);
+	label = &prog->label[prog->num_labels++];
+	strcpy(label->name, name);
+	label->insn = prog->num_insns;
+	label->word = prog->num_words;
+
+	return 0;
+}
+
+static int add_words(struct a64_prog *prog, const char *s)
+{
+	int64_t val;
+
+	for (;;) {
+		s = get_number(skip_space(s), &val);
+		if (s == NULL)
+			return error(prog, "bad .word", NULL);
+		if (prog->num_words == A64_MAX_WORDS)
+			return error(prog, "too many words", NULL);
+		prog->word[prog->num_words++] = val;
+		s = skip_space(s);
+		if (*s == '\0')
+			return 0;
+		if (*s != ',')
+			return error(prog, "bad .word", NULL);
+		s++;
+	}
+}
+
+static int assemble(struct a64_prog *prog, const char *text, int len,
+		    const struct a64_macro *macro,
+		    char args[][A64_NAME_LEN], int depth);
+
+static int expand(struct a64_prog *prog, const struct a64_macro *macro,
+		  char *s, int depth)
+{
+	char args[A64_MAX_PARAMS][A64_NAME_LEN];
+	char *text[A64_MAX_PARAMS];
+	int i, n;
+
+	if (depth == MAX_DEPTH)
+		return error(prog, "macros nested too deep", macro->name);
+
+	n = split_operands(s, text, A64_MAX_PARAMS);
+	if (n != macro->num_params)
+		return error(prog, "wrong number of arguments", macro->name);
+	for (i = 0; i < n; i++) {
+		char *end = text[i] + strlen(text[i]);
+
+		while (end > text[i] && (end[-1] == ' ' || end[-1] == '\t'))
+			*--end = '\0';
+		strncpy(args[i], text[i], A64_NAME_LEN - 1);
+		args[i][A64_NAME_LEN - 1] = '\0';
+	}
+
+	return assemble(prog, macro->body, macro->body_len, macro, args,
+			depth + 1);
+}
+
+static int line(struct a64_prog *prog, char *buf, int depth)
+{
+	char name[A64_NAME_LEN];
+	const char *s = skip_space(buf);
+	const char *p;
+	int i;
+
+	if (*s == '\0' || *s == '#')
+		return 0;
+
+	/* Labels, including the numeric local ones. */
+	while ((p = get_ident(s, name)) != s && *p == ':') {
+		if (define_label(prog, name))
+			return -1;
+		s = skip_space(p + 1);
+	}
+	if (*s == '\0')
+		return 0;
+
+	if (!strncmp(s, "ENTRY(", 6) || !strncmp(s, "ENDPROC(", 8)) {
+		p = get_ident(strchr(s, '(') + 1, name);
+		if (*p != ')')
+			return error(prog, "bad ENTRY/ENDPROC", NULL);
+		return s[2] == 'T' ? define_label(prog, name) : 0;
+	}
+
+	p = get_ident(s, name);
+	if (name[0] == '.' && strcmp(name, ".word"))
+		return 0;	/* .arch, .section, .align, ... */
+	if (!strcmp(name, ".word"))
+		return add_words(prog, p);
+
+	for (i = 0; i < prog->num_macros; i++)
+		if (!strcmp(prog->macro[i].name, name))
+			return expand(prog, &prog->macro[i], (char *)p, depth);
+
+	return encode(prog, name, (char *)p);
+}
+
+/* Removes comments, *in_comment carries a block comment across lines. */
+static void strip_comments(char *s, int *in_comment)
+{
+	char *out = s;
+
+	while (*s) {
+		if (*in_comment) {
+			if (s[0] == '*' && s[1] == '/') {
+				*in_comment = 0;
+				s++;
+			}
+			s++;
+		} else if (s[0] == '/' && s[1] == '*') {
+			*in_comment = 1;
+			s += 2;
+		} else if (s[0] == '/' && s[1] == '/') {
+			break;
+		} else {
+			*out++ = *s++;
+		}
+	}
+	*out = '\0';
+}
+
+/* Copies a line, replacing \param and \() in macro bodies. */
+static int copy_line(struct a64_prog *prog, char *buf, const char *s, int len,
+		     const struct a64_macro *macro, char args[][A64_NAME_LEN])
+{
+	char name[A64_NAME_LEN];
+	int i, n = 0;
+
+	while (len > 0) {
+		const char *copy = s;
+		int copy_len = 1;
+
+		if (macro && *s == '\\') {
+			if (len >= 3 && s[1] == '(' && s[2] == ')') {
+				s += 3;
+				len -= 3;
+				continue;
+			}
+			for (s++, i = 0; i < A64_NAME_LEN - 1 &&
+			     is_ident(*s) && *s != '.'; i++)
+				name[i] = *s++;
+			name[i] = '\0';
+			len -= s - copy;
+			for (i = 0; i < macro->num_params; i++)
+				if (!strcmp(macro->param[i], name))
+					break;
+			if (i == macro->num_params)
+				return error(prog, "unknown macro parameter",
+					     name);
+			copy = args[i];
+			copy_len = strlen(args[i]);
+		} else {
+			s++;
+			len--;
+		}
+		if (n + copy_len >= MAX_LINE)
+			return error(prog, "line too long", NULL);
+		memcpy(buf + n, copy, copy_len);
+		n += copy_len;
+	}
+	buf[n] = '\0';
+
+	return 0;
+}
+
+static int define_macro(struct a64_prog *prog, const char *s)
+{
+	struct a64_macro *macro;
+
+	if (prog->num_macros == A64_MAX_MACROS)
+		return error(prog, "too many macros", NULL);
+	macro = &prog->macro[prog->num_macros++];
+	memset(macro, 0, sizeof(*macro));
+
+	s = get_ident(skip_space(s), macro->name);
+	for (;;) {
+		s = skip_space(s);
+		if (*s == ',')
+			s = skip_space(s + 1);
+		if (*s == '\0' || *s == '\n')
+			return 0;
+		if (macro->num_params == A64_MAX_PARAMS)
+			return error(prog, "too many parameters", NULL);
+		s = get_ident(s, macro->param[macro->num_params++]);
+	}
+}
+
+static int assemble(struct a64_prog *prog, const char *text, int len,
+		    const struct a64_macro *macro,
+		    char args[][A64_NAME_LEN], int depth)
+{
+	const char *end = text + len;
+	struct a64_macro *body = NULL;
+	char buf[MAX_LINE];
+	int in_comment = 0;
+
+	while (text < end) {
+		const char *eol = memchr(text, '\n', end - text);
+		const char *next;
+
+		if (eol == NULL)
+			eol = end;
+		next = eol + (eol < end);
+		if (depth == 0)
+			prog->line++;
+
+		if (copy_line(prog, buf, text, eol - text, macro, args))
+			return -1;
+		strip_comments(buf, &in_comment);
+
+		/* Macro bodies are kept as source and expanded when used. */
+		if (body) {
+			if (!strncmp(skip_space(buf), ".endm", 5)) {
+				body->body_len = text - body->body;
+				body = NULL;
+			}
+		} else if (!strncmp(skip_space(buf), ".macro", 6)) {
+			if (define_macro(prog, skip_space(buf) + 6))
+				return -1;
+			body = &prog->macro[prog->num_macros - 1];
+			body->body = next;
+		} else if (line(prog, buf, depth)) {
+			return -1;
+		}
+
+		text = next;
+	}
+
+	if (body)
+		return error(prog, "missing .endm", body->name);
+
+	return 0;
+}
+
+static const struct a64_label *find_label(const struct a64_prog *prog,
+					  const char *name, int from)
+{
+	const struct a64_label *found = NULL;
+	char local[A64_NAME_LEN];
+	size_t len = strlen(name);
+	int i;
+
+	/* Numeric labels: 1b is the closest 1 before, 1f the one after. */
+	if (len > 1 && isdigit(name[0]) &&
+	    (name[len - 1] == 'b' || name[len - 1] == 'f')) {
+		strcpy(local, name);
+		local[len - 1] = '\0';
+		for (i = 0; i < prog->num_labels; i++) {
+			const struct a64_label *l = &prog->label[i];
+
+			if (strcmp(l->name, local))
+				continue;
+			if (name[len - 1] == 'b' && l->insn <= from)
+				found = l;
+			if (name[len - 1] == 'f' && l->insn > from)
+				return l;
+		}
+		return found;
+	}
+
+	for (i = 0; i < prog->num_labels; i++)
+		if (!strcmp(prog->label[i].name, name))
+			return &prog->label[i];
+
+	return NULL;
+}
+
+int a64_load(struct a64_prog *prog, const char *source)
+{
+	int i;
+
+	memset(prog, 0, sizeof(*prog));
+	if (assemble(prog, source, strlen(source), NULL, NULL, 0))
+		return -1;
+
+	for (i = 0; i < prog->num_insns; i++) {
+		struct a64_insn *insn = &prog->insn[i];
+		const struct a64_label *label;
+
+		if (insn->op != OP_CBZ && insn->op != OP_B_NE &&
+		    insn->op != OP_ADRP)
+			continue;
+		prog->line = insn->line;
+		label = find_label(prog, insn->sym, i);
+		if (label == NULL)
+			return error(prog, "undefined label", insn->sym);
+		if (insn->op == OP_ADRP) {
+			if (label->word == prog->num_words)
+				return error(prog, "no data at", insn->sym);
+			insn->target = label->word;
+		} else {
+			insn->target = label->insn;
+		}
+	}
+
+	return 0;
+}
+
+struct vreg {
+	uint32_t w[4];
+};
+
+static uint32_t rol32(uint32_t x, int n)
+{
+	return x << n | x >> (32 - n);
+}
+
+static uint32_t ror32(uint32_t x, int n)
+{
+	return x >> n | x << (32 - n);
+}
+
+static uint32_t sha_choose(uint32_t x, uint32_t y, uint32_t z)
+{
+	return ((y ^ z) & x) ^ z;
+}
+
+static uint32_t sha_parity(uint32_t x, uint32_t y, uint32_t z)
+{
+	return x ^ y ^ z;
+}
+
+static uint32_t sha_majority(uint32_t x, uint32_t y, uint32_t z)
+{
+	return (x & y) | ((x | y) & z);
+}
+
+/* SHA1C, SHA1P and SHA1M: four rounds on abcd in x and e in y. */
+static void sha1_hash(struct vreg *x, uint32_t y, const struct vreg *w,
+		      uint32_t (*f)(uint32_t, uint32_t, uint32_t))
+{
+	int e;
+
+	for (e = 0; e < 4; e++) {
+		uint32_t top;
+
+		y += rol32(x->w[0], 5) + f(x->w[1], x->w[2], x->w[3]) +
+			w->w[e];
+		x->w[1] = rol32(x->w[1], 30);
+		/* <Y, X> = ROL(Y : X, 32) */
+		top = x->w[3];
+		x->w[3] = x->w[2];
+		x->w[2] = x->w[1];
+		x->w[1] = x->w[0];
+		x->w[0] = y;
+		y = top;
+	}
+}
+
+/* SHA256H and SHA256H2: four rounds on abcd in x and efgh in y. */
+static void sha256_hash(struct vreg *x, struct vreg *y, const struct vreg *w)
+{
+	int e;
+
+	for (e = 0; e < 4; e++) {
+		uint32_t chs = sha_choose(y->w[0], y->w[1], y->w[2]);
+		uint32_t maj = sha_majority(x->w[0], x->w[1], x->w[2]);
+		uint32_t t1, top_x, top_y;
+
+		t1 = y->w[3] + (ror32(y->w[0], 6) ^ ror32(y->w[0], 11) ^
+				ror32(y->w[0], 25)) + chs + w->w[e];
+		x->w[3] += t1;
+		y->w[3] = t1 + (ror32(x->w[0], 2) ^ ror32(x->w[0], 13) ^
+				ror32(x->w[0], 22)) + maj;
+		/* <Y, X> = ROL(Y : X, 32) */
+		top_x = x->w[3];
+		top_y = y->w[3];
+		x->w[3] = x->w[2];
+		x->w[2] = x->w[1];
+		x->w[1] = x->w[0];
+		x->w[0] = top_y;
+		y->w[3] = y->w[2];
+		y->w[2] = y->w[1];
+		y->w[1] = y->w[0];
+		y->w[0] = top_x;
+	}
+}
+
+static uint32_t sigma0(uint32_t x)
+{
+	return ror32(x, 7) ^ ror32(x, 18) ^ x >> 3;
+}
+
+static uint32_t sigma1(uint32_t x)
+{
+	return ror32(x, 17) ^ ror32(x, 19) ^ x >> 10;
+}
+
+#define MAX_STEPS	(1ULL << 32)
+
+int a64_call(struct a64_prog *prog, const char *name, uint64_t x0,
+	     uint64_t x1, uint64_t x2)
+{
+	const struct a64_label *label = find_label(prog, name, 0);
+	uint64_t x[32] = { x0, x1, x2 };
+	struct vreg v[32], t, u;
+	unsigned long long steps;
+	int pc, z = 0, i;
+
+	if (label == NULL)
+		return error(prog, "undefined function", name);
+
+	memset(v, 0, sizeof(v));
+	pc = label->insn;
+
+	for (steps = 0; steps < MAX_STEPS; steps++) {
+		const struct a64_insn *in;
+		uint8_t *mem;
+
+		if (pc < 0 || pc >= prog->num_insns)
+			return error(prog, "ran off the code in", name);
+		in = &prog->insn[pc++];
+		mem = (uint8_t *)(uintptr_t)(x[in->n] +
+					     (in->post ? 0 : in->imm));
+		prog->insns++;
+		if (in->op >= OP_SHA1C)
+			prog->ce_insns++;
+
+		switch (in->op) {
+		case OP_ADD_X:
+			x[in->d] = x[in->n] + in->imm;
+			break;
+		case OP_ADD_V:
+			for (i = 0; i < 4; i++)
+				t.w[i] = v[in->n].w[i] + v[in->m].w[i];
+			v[in->d] = t;
+			break;
+		case OP_ADRP:
+			x[in->d] = (uintptr_t)&prog->word[in->target];
+			break;
+		case OP_MOV_V:
+			v[in->d] = v[in->n];
+			break;
+		case OP_LD1:
+			for (i = 0; i < in->count; i++)
+				memcpy(&v[(in->d + i) % 32], mem + 16 * i, 16);
+			break;
+		case OP_LD1R:
+			memcpy(&t.w[0], mem, 4);
+			for (i = 0; i < 4; i++)
+				v[in->d].w[i] = t.w[0];
+			break;
+		case OP_LDR_S:
+			memset(&v[in->d], 0, sizeof(v[in->d]));
+			memcpy(&v[in->d].w[0], mem, 4);
+			break;
+		case OP_ST1:
+			for (i = 0; i < in->count; i++)
+				memcpy(mem + 16 * i, &v[(in->d + i) % 32], 16);
+			break;
+		case OP_STR_S:
+			memcpy(mem, &v[in->d].w[0], 4);
+			break;
+		case OP_REV32:
+			for (i = 0; i < 4; i++)
+				v[in->d].w[i] = swab32(v[in->n].w[i]);
+			break;
+		case OP_CBZ:
+			if (!x[in->d])
+				pc = in->target;
+			break;
+		case OP_SUBS:
+			x[in->d] = x[in->n] - in->imm;
+			z = x[in->d] == 0;
+			break;
+		case OP_B_NE:
+			if (!z)
+				pc = in->target;
+			break;
+		case OP_RET:
+			return 0;
+		case OP_SHA1C:
+			sha1_hash(&v[in->d], v[in->n].w[0], &v[in->m],
+				  sha_choose);
+			break;
+		case OP_SHA1P:
+			sha1_hash(&v[in->d], v[in->n].w[0], &v[in->m],
+				  sha_parity);
+			break;
+		case OP_SHA1M:
+			sha1_hash(&v[in->d], v[in->n].w[0], &v[in->m],
+				  sha_majority);
+			break;
+		case OP_SHA1H:
+			t.w[0] = rol32(v[in->n].w[0], 30);
+			memset(&v[in->d], 0, sizeof(v[in->d]));
+			v[in->d].w[0] = t.w[0];
+			break;
+		case OP_SHA1SU0:
+			/* op2 = op2<63:0> : op1<127:64> */
+			t.w[0] = v[in->d].w[2];
+			t.w[1] = v[in->d].w[3];
+			t.w[2] = v[in->n].w[0];
+			t.w[3] = v[in->n].w[1];
+			for (i = 0; i < 4; i++)
+				v[in->d].w[i] ^= t.w[i] ^ v[in->m].w[i];
+			break;
+		case OP_SHA1SU1:
+			/* T = X ^ LSR(Y, 32) */
+			for (i = 0; i < 4; i++)
+				t.w[i] = v[in->d].w[i] ^
+					(i < 3 ? v[in->n].w[i + 1] : 0);
+			for (i = 0; i < 4; i++)
+				v[in->d].w[i] = rol32(t.w[i], 1);
+			v[in->d].w[3] ^= rol32(t.w[0], 2);
+			break;
+		case OP_SHA256H:
+			t = v[in->d];
+			u = v[in->n];
+			sha256_hash(&t, &u, &v[in->m]);
+			v[in->d] = t;
+			break;
+		case OP_SHA256H2:
+			t = v[in->n];
+			u = v[in->d];
+			sha256_hash(&t, &u, &v[in->m]);
+			v[in->d] = u;
+			break;
+		case OP_SHA256SU0:
+			/* T = op2<31:0> : op1<127:32> */
+			t.w[0] = v[in->d].w[1];
+			t.w[1] = v[in->d].w[2];
+			t.w[2] = v[in->d].w[3];
+			t.w[3] = v[in->n].w[0];
+			for (i = 0; i < 4; i++)
+				v[in->d].w[i] += sigma0(t.w[i]);
+			break;
+		case OP_SHA256SU1:
+			/* T0 = op3<31:0> : op2<127:32>, T1 = op3<127:64> */
+			t.w[0] = v[in->n].w[1];
+			t.w[1] = v[in->n].w[2];
+			t.w[2] = v[in->n].w[3];
+			t.w[3] = v[in->m].w[0];
+			u = v[in->d];
+			u.w[0] += sigma1(v[in->m].w[2]) + t.w[0];
+			u.w[1] += sigma1(v[in->m].w[3]) + t.w[1];
+			u.w[2] += sigma1(u.w[0]) + t.w[2];
+			u.w[3] += sigma1(u.w[1]) + t.w[3];
+			v[in->d] = u;
+			break;
+		}
+
+		if (in->post)
+			x[in->n] += in->imm;
+	}
+
+	return error(prog, "no return from", name);
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * An interpreter for the few AArch64 instructions the Crypto Extension
+ * routines use. It assembles their source text as it is, macros included,
+ * and runs it on host memory, so that the instruction sequence of the .S
+ * files can be checked on hosts without an arm64 CPU or emulator.
+ */
+
+#ifndef A64_H
+#define A64_H
+
+#include <stdint.h>
+
+#define A64_MAX_INSNS	512
+#define A64_MAX_LABELS	32
+#define A64_MAX_WORDS	128
+#define A64_MAX_MACROS	8
+#define A64_MAX_PARAMS	8
+#define A64_NAME_LEN	32
+
+struct a64_insn {
+	uint8_t op;
+	uint8_t d, n, m;	/* register numbers */
+	uint8_t count;		/* registers in an ld1/st1 list */
+	uint8_t post;		/* post-index by imm */
+	int64_t imm;
+	int target;		/* instruction or word index */
+	char sym[A64_NAME_LEN];
+	int line;
+};
+
+struct a64_label {
+	char name[A64_NAME_LEN];
+	int insn;		/* next instruction after the label */
+	int word;		/* next .word after the label */
+};
+
+struct a64_macro {
+	char name[A64_NAME_LEN];
+	char param[A64_MAX_PARAMS][A64_NAME_LEN];
+	int num_params;
+	const char *body;
+	int body_len;
+};
+
+struct a64_prog {
+	struct a64_insn insn[A64_MAX_INSNS];
+	int num_insns;
+	struct a64_label label[A64_MAX_LABELS];
+	int num_labels;
+	uint32_t word[A64_MAX_WORDS] __attribute__((aligned(16)));
+	int num_words;
+	struct a64_macro macro[A64_MAX_MACROS];
+	int num_macros;
+	int line;		/* of the source, while assembling */
+
+	/* Instructions run, all of them and the Crypto Extension ones. */
+	unsigned long long insns;
+	unsigned long long ce_insns;
+};
+
+/* Assemble a .S file. Returns 0 on success, errors are printed. */
+int a64_load(struct a64_prog *prog, const char *source);
+
+/*
+ * Run the function at label name until it returns, with x0-x2 as its
+ * arguments. Returns 0 on success.
+ */
+int a64_call(struct a64_prog *prog, const char *name, uint64_t x0,
+	     uint64_t x1, uint64_t x2);
+
+#endif /* A64_H */
@@ -0,0 +1,255 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Runs the two passes of the resource allocator on generated device trees
+ * and checks that every memory resource ends up aligned, inside the window
+ * of its bridge and clear of its siblings. The space the root bridge needs
+ * is printed so that different versions of the allocator can be compared.
+ */
+
+/* The Makefile can point this at another version of the allocator. */
+#ifndef DEVICE_SOURCE
+#define DEVICE_SOURCE "../../src/device/device.c"
+#endif
+#include DEVICE_SOURCE
+
+#include "hosttest.h"
+
+/* What device.c needs from the rest of ramstage. */
+struct device dev_root;
+struct device *last_dev;
+
+int do_printk(int msg_level, const char *fmt, ...)
+{
+	return 0;
+}
+
+void die(const char *msg)
+{
+	host_printf("%s", msg);
+	for (;;)
+		;
+}
+
+void post_code(uint8_t value)
+{
+}
+
+void setup_default_ebda(void)
+{
+}
+
+#define MAX_DEVICES	400
+#define MAX_BUSES	100
+#define MAX_RESOURCES	1200
+#define MAX_DEPTH	3
+
+struct tree {
+	struct device devs[MAX_DEVICES];
+	struct bus buses[MAX_BUSES];
+	struct resource res[MAX_RESOURCES];
+	int num_devs;
+	int num_buses;
+	int num_res;
+};
+
+static struct tree tree;
+static int errors;
+
+static struct resource *add_resource(struct device *dev, int align,
+				     resource_t size, unsigned long flags,
+				     unsigned long index)
+{
+	struct resource *res = &tree.res[tree.num_res++];
+
+	res->align = align;
+	res->gran = align;
+	res->size = size;
+	res->flags = flags;
+	res->index = index;
+	res->limit = 0xffffffff;
+	res->next = dev->resource_list;
+	dev->resource_list = res;
+
+	return res;
+}
+
+/*
+ * Up to six devices per bus. A quarter of them are bridges to another bus,
+ * the others have up to four BARs. A third of the BARs are not PCI and have
+ * sizes that aren't a power of two.
+ */
+static struct bus *generate_bus(int depth)
+{
+	struct bus *bus = &tree.buses[tree.num_buses++];
+	struct device *last = NULL;
+	int num_devs = 1 + host_random() % 6;
+	int i, k;
+
+	for (i = 0; i < num_devs; i++) {
+		struct device *dev;
+		int num_res;
+
+		if (tree.num_devs == MAX_DEVICES ||
+		    tree.num_res + 4 > MAX_RESOURCES)
+			break;
+
+		dev = &tree.devs[tree.num_devs++];
+		dev->enabled = 1;
+		dev->bus = bus;
+		if (last)
+			last->sibling = dev;
+		else
+			bus->children = dev;
+		last = dev;
+
+		if (depth < MAX_DEPTH && tree.num_buses < MAX_BUSES &&
+		    host_random() % 4 == 0) {
+			struct bus *link;
+
+			add_resource(dev, 20, 0,
+				     IORESOURCE_MEM | IORESOURCE_BRIDGE,
+				     IOINDEX(0x20, 0));
+			link = generate_bus(depth + 1);
+			link->dev = dev;
+			dev->link_list = link;
+			continue;
+		}
+
+		num_res = 1 + host_random() % 4;
+		for (k = 0; k < num_res; k++) {
+			int align = 12 + host_random() % 13;
+			resource_t size = 1ULL << align;
+
+			if (host_random() % 3 == 0) {
+				align = 8 + host_random() % 6;
+				size = (resource_t)(1 + host_random() % 16) <<
+					(8 + host_random() % 6);
+			}
+
+			add_resource(dev, align, size, IORESOURCE_MEM,
+				     PCI_BASE_ADDRESS_0 + 4 * k);
+		}
+	}
+
+	return bus;
+}
+
+static int overlaps(const struct resource *a, const struct resource *b)
+{
+	return a->base < b->base + b->size && b->base < a->base + a->size;
+}
+
+static void check_bus(struct bus *bus, const struct resource *bridge)
+{
+	struct device *dev, *other;
+	struct resource *res, *res2;
+
+	for (dev = bus->children; dev; dev = dev->sibling) {
+		for (res = dev->resource_list; res; res = res->next) {
+			if (!res->size)
+				continue;
+
+			if (!(res->flags & IORESOURCE_ASSIGNED)) {
+				host_printf("resource not assigned\n");
+				errors++;
+			}
+			if (res->base & ((1ULL << res->align) - 1)) {
+				host_printf("0x%llx not aligned to 2^%d\n",
+					    res->base, res->align);
+				errors++;
+			}
+			if (res->base < bridge->base ||
+			    res->base + res->size > bridge->base + bridge->size) {
+				host_printf("0x%llx+0x%llx outside of bridge "
+					    "0x%llx+0x%llx\n", res->base,
+					    res->size, bridge->base,
+					    bridge->size);
+				errors++;
+			}
+
+			for (other = bus->children; other;
+			     other = other->sibling) {
+				for (res2 = other->resource_list; res2;
+				     res2 = res2->next) {
+					if (res2 == res || !res2->size)
+						continue;
+					if (overlaps(res, res2)) {
+						host_printf("0x%llx+0x%llx "
+							    "overlaps 0x%llx\n",
+							    res->base,
+							    res->size,
+							    res2->base);
+						errors++;
+					}
+				}
+			}
+
+			if (res->flags & IORESOURCE_BRIDGE)
+				check_bus(dev->link_list, res);
+		}
+	}
+}
+
+/* Returns the size of the root bridge window. */
+static resource_t run_tree(void)
+{
+	struct resource root = {
+		.limit = 0xffffffffffffffffULL,
+		.flags = IORESOURCE_MEM,
+	};
+	const unsigned long type_mask =
+		IORESOURCE_TYPE_MASK | IORESOURCE_PREFETCH;
+	struct bus *bus;
+
+	memset(&tree, 0, sizeof(tree));
+	bus = generate_bus(0);
+
+	compute_resources(bus, &root, type_mask, IORESOURCE_MEM);
+	root.base = 0x80000000;
+	root.limit = 0xffffffff;
+	allocate_resources(bus, &root, type_mask, IORESOURCE_MEM);
+
+	check_bus(bus, &root);
+
+	return root.size;
+}
+
+const int test_count = 3000;
+
+int test_main(const struct host_args *args)
+{
+	unsigned long long total = 0;
+	int i;
+
+	host_srandom(args->seed);
+	for (i = 0; i < args->count; i++) {
+		resource_t size = run_tree();
+
+		if (args->verbose)
+			host_printf("tree %d: %d devices, 0x%llx bytes\n", i,
+				    tree.num_devs, size);
+		total += size;
+	}
+
+	host_printf("%d trees, 0x%llx bytes in total\n", args->count,
+		    total);
+
+	if (errors) {
+		host_printf("%d misplaced resources\n", errors);
+		return 1;
+	}
+
+	return 0;
+}
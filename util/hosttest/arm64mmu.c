@@ -0,0 +1,320 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Maps random ranges with mmu_config_range() and checks the resulting
+ * translation tables against a memranges list of the same ranges. Every
+ * block and page has to map its address to itself with the attributes of
+ * the range covering it, unmapped space has to stay invalid, no table may
+ * be left that could be merged into a block, and every table in use has to
+ * be reachable from the root.
+ */
+
+#include <arch/barrier.h>
+#include <arch/cache.h>
+#include <arch/lib_helpers.h>
+#include <console/console.h>
+#include <memrange.h>
+
+#include "hosttest.h"
+
+/* The barriers are arm64 instructions; the host only needs the ordering. */
+#undef dsb
+#undef isb
+#define dsb()	__asm__ __volatile__("" : : : "memory")
+#define isb()	__asm__ __volatile__("" : : : "memory")
+
+#include "../../src/arch/arm64/armv8/mmu.c"
+
+/* The Makefile places _ettb right behind the table space. */
+#define TTB_SIZE	(4 * MiB)
+
+u8 _ttb[TTB_SIZE] __attribute__((aligned(GRANULE_SIZE)));
+
+static int mmu_on;
+static int tlb_flushes;
+static int errors;
+
+int do_printk(int msg_level, const char *fmt, ...)
+{
+	/* Failed assertions are printed at BIOS_EMERG. */
+	if (msg_level == BIOS_EMERG) {
+		host_printf("%s", fmt);
+		errors++;
+	}
+	return 0;
+}
+
+void die(const char *msg)
+{
+	host_printf("%s\n", msg);
+	for (;;)
+		;
+}
+
+uint32_t raw_read_sctlr_el3(void)
+{
+	return mmu_on ? SCTLR_M : 0;
+}
+
+void raw_write_sctlr_el3(uint32_t sctlr)
+{
+}
+
+void raw_write_ttbr0_el3(uint64_t ttbr0)
+{
+}
+
+void raw_write_mair_el3(uint64_t mair)
+{
+}
+
+void raw_write_tcr_el3(uint32_t tcr)
+{
+}
+
+void tlbiall_current(void)
+{
+	tlb_flushes++;
+}
+
+void dcache_clean_invalidate_all(void)
+{
+}
+
+/* memrange.c can fill itself from the device tree, which isn't used here. */
+void search_global_resources(unsigned long type_mask, unsigned long type,
+			     resource_search_t search, void *gp)
+{
+}
+
+#define VA_SIZE		(1ULL << BITS_PER_VA)
+
+static const uint64_t tags[] = {
+	MA_MEM,
+	MA_MEM | MA_MEM_NC,
+	MA_DEV,
+	MA_MEM | MA_NS,
+	MA_MEM | MA_RO,
+};
+
+static struct memranges expected;
+static size_t tables_seen;
+
+/* A block or page at va must match the memranges entry that covers it. */
+static void check_leaf(uint64_t desc, uint64_t va, uint64_t size, int page)
+{
+	struct range_entry *r;
+
+	memranges_each_entry(r, &expected) {
+		if (range_entry_end(r) <= va || range_entry_base(r) >= va + size)
+			continue;
+
+		if (!(desc & BLOCK_DESC)) {
+			host_printf("0x%llx+0x%llx unmapped, expected tag %lx\n",
+				    va, size, range_entry_tag(r));
+			errors++;
+			return;
+		}
+		if (range_entry_base(r) > va || range_entry_end(r) < va + size) {
+			host_printf("0x%llx+0x%llx spans several ranges\n",
+				    va, size);
+			errors++;
+			return;
+		}
+		if ((desc & DESC_MASK) != (page ? PAGE_DESC : BLOCK_DESC) ||
+		    (desc & XLAT_ADDR_MASK) != va ||
+		    (desc & DESC_ATTR_MASK) !=
+		    get_block_attr(range_entry_tag(r))) {
+			host_printf("0x%llx+0x%llx has descriptor 0x%llx, "
+				    "expected tag %lx\n", va, size, desc,
+				    range_entry_tag(r));
+			errors++;
+		}
+		return;
+	}
+
+	if (desc & BLOCK_DESC) {
+		host_printf("0x%llx+0x%llx mapped, but no range covers it\n",
+			    va, size);
+		errors++;
+	}
+}
+
+/* A table that maps one contiguous range or nothing should be a block. */
+static int table_mergeable(const uint64_t *table, uint64_t xlat_size)
+{
+	int i;
+
+	if (table[0] == INVALID_DESC) {
+		for (i = 1; i < GRANULE_SIZE / sizeof(*table); i++)
+			if (table[i] != INVALID_DESC)
+				return 0;
+		return 1;
+	}
+
+	if (xlat_size > L3_XLAT_SIZE && (table[0] & DESC_MASK) == TABLE_DESC)
+		return 0;
+	if (!IS_ALIGNED(table[0] & XLAT_ADDR_MASK,
+			xlat_size << BITS_RESOLVED_PER_LVL))
+		return 0;
+	for (i = 1; i < GRANULE_SIZE / sizeof(*table); i++)
+		if (table[i] != table[0] + i * xlat_size)
+			return 0;
+	return 1;
+}
+
+/* Walk a table whose entries each map xlat_size bytes starting at va. */
+static void check_table(const uint64_t *table, uint64_t va,
+			uint64_t xlat_size, int root)
+{
+	int i;
+
+	tables_seen++;
+
+	if (!root && table_mergeable(table, xlat_size)) {
+		host_printf("table for 0x%llx could be merged\n", va);
+		errors++;
+	}
+
+	for (i = 0; i < GRANULE_SIZE / sizeof(*table); i++) {
+		uint64_t entry_va = va + i * xlat_size;
+
+		if (entry_va >= VA_SIZE)
+			break;
+
+		if (xlat_size > L3_XLAT_SIZE &&
+		    (table[i] & DESC_MASK) == TABLE_DESC)
+			check_table((uint64_t *)(table[i] & XLAT_ADDR_MASK),
+				    entry_va, xlat_size >> BITS_RESOLVED_PER_LVL,
+				    0);
+		else
+			check_leaf(table[i], entry_va, xlat_size,
+				   xlat_size == L3_XLAT_SIZE);
+	}
+}
+
+static void check_tables(const char *name)
+{
+	int before = errors;
+
+	tables_seen = 0;
+	check_table((uint64_t *)_ttb, 0, BITS_PER_VA > L1_ADDR_SHIFT ?
+		    L1_XLAT_SIZE : L2_XLAT_SIZE, 1);
+
+	if (tables_seen != tables_used()) {
+		host_printf("%zu tables in use, %zu reachable\n",
+			    tables_used(), tables_seen);
+		errors++;
+	}
+
+	if (errors != before)
+		host_printf("%s: wrong translation tables\n", name);
+}
+
+static void start(void)
+{
+	/* mmu_init() expects the state of a freshly loaded stage. */
+	next_free_table = (void *)_ttb;
+	mmu_on = 0;
+	mmu_init();
+	memranges_teardown(&expected);
+	memranges_init_empty(&expected, NULL, 0);
+}
+
+static void map(uint64_t base, uint64_t size, uint64_t tag)
+{
+	mmu_config_range((void *)(uintptr_t)base, size, tag);
+	memranges_insert(&expected, base, size, tag);
+}
+
+/* Splitting a block and restoring it must not cost a table. */
+static void test_split_and_restore(void)
+{
+	size_t tables;
+
+	start();
+	map(0, VA_SIZE, MA_MEM);
+	tables = tables_used();
+
+	mmu_on = 1;
+	map(3ULL * GiB + 4 * KiB, 4 * KiB, MA_DEV);
+	check_tables("split");
+	if (tables_used() != tables + 2) {
+		host_printf("split: %zu tables, expected %zu\n",
+			    tables_used(), tables + 2);
+		errors++;
+	}
+
+	map(3ULL * GiB + 4 * KiB, 4 * KiB, MA_MEM);
+	check_tables("restore");
+	if (tables_used() != tables) {
+		host_printf("restore: %zu tables, expected %zu\n",
+			    tables_used(), tables);
+		errors++;
+	}
+}
+
+/* Ranges of pages, 2MiB or 1GiB blocks, with random attributes. */
+static void test_random(int round, int verbose)
+{
+	const uint64_t granules[] = { L3_XLAT_SIZE, L2_XLAT_SIZE,
+				      L1_XLAT_SIZE };
+	int i;
+
+	start();
+	/* Half the rounds remap with the MMU on, which needs
+	 * break-before-make. */
+	for (i = 0; i < 50; i++) {
+		uint64_t granule = granules[host_random() %
+					    ARRAY_SIZE(granules)];
+		uint64_t base = (host_random() % (VA_SIZE / granule)) *
+			granule;
+		uint64_t size = (1 + host_random() % 16) * granule;
+
+		if (i == 25)
+			mmu_on = round & 1;
+
+		size = MIN(size, VA_SIZE - base);
+		map(base, size, tags[host_random() % ARRAY_SIZE(tags)]);
+	}
+
+	check_tables("random");
+
+	if (verbose)
+		host_printf("round %d: %zu tables, %d TLB flushes\n", round,
+			    tables_used(), tlb_flushes);
+}
+
+const int test_count = 40;
+
+int test_main(const struct host_args *args)
+{
+	int i;
+
+	memranges_init_empty(&expected, NULL, 0);
+
+	test_split_and_restore();
+
+	host_srandom(args->seed);
+	for (i = 0; i < args->count; i++)
+		test_random(i, args->verbose);
+
+	if (errors) {
+		host_printf("%d errors\n", errors);
+		return 1;
+	}
+
+	host_printf("%d rounds of random ranges, tables ok\n", args->count);
+	return 0;
+}
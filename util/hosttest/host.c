@@ -0,0 +1,115 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* The host side of every test, built against the host C library. */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "hosttest.h"
+
+int host_printf(const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, fmt);
+	ret = vprintf(fmt, args);
+	va_end(args);
+
+	return ret;
+}
+
+unsigned long host_random(void)
+{
+	return random();
+}
+
+void host_srandom(unsigned int seed)
+{
+	srandom(seed);
+}
+
+long long host_time_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static unsigned char *read_file(const char *name, long *size)
+{
+	unsigned char *buf;
+	FILE *f;
+
+	f = fopen(name, "rb");
+	if (f == NULL) {
+		perror(name);
+		exit(1);
+	}
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	buf = malloc(*size);
+	if (buf == NULL || fread(buf, 1, *size, f) != *size) {
+		fprintf(stderr, "%s: read failed\n", name);
+		exit(1);
+	}
+	fclose(f);
+
+	return buf;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "usage: %s [-v] [-s seed] [-n count] [-r file]\n",
+		name);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct host_args args = {
+		.seed = 1,
+		.count = test_count,
+	};
+	int opt;
+
+	while ((opt = getopt(argc, argv, "vs:n:r:")) != -1) {
+		switch (opt) {
+		case 'v':
+			args.verbose = 1;
+			break;
+		case 's':
+			args.seed = atoi(optarg);
+			break;
+		case 'n':
+			args.count = atoi(optarg);
+			break;
+		case 'r':
+			args.file = read_file(optarg, &args.file_size);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	return test_main(&args);
+}
@@ -0,0 +1,42 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * The coreboot code under test is built against the coreboot headers, which
+ * can't be mixed with the ones of the host C library. Everything a test needs
+ * from the host goes through the functions below, which host.c implements.
+ * Only plain C types may be used here, this file is included on both sides.
+ */
+
+#ifndef HOSTTEST_H
+#define HOSTTEST_H
+
+struct host_args {
+	int seed;	/* -s, seeds host_random() */
+	int count;	/* -n, rounds or runs, test_count if not given */
+	int verbose;	/* -v */
+	const unsigned char *file;	/* contents of the -r file, or NULL */
+	long file_size;
+};
+
+int host_printf(const char *fmt, ...);
+unsigned long host_random(void);
+void host_srandom(unsigned int seed);
+/* Microseconds from a monotonic clock. */
+long long host_time_us(void);
+
+/* Provided by every test. Returns 0 on success. */
+extern const int test_count;
+int test_main(const struct host_args *args);
+
+#endif /* HOSTTEST_H */
@@ -0,0 +1,260 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Runs the variable MTRR solver of ramstage on a set of memory maps taken
+ * from real boards plus generated ones, and checks that the effective type
+ * of every range matches the address space the MTRRs were calculated for.
+ */
+
+/* The Makefile can point this at another version of the solver. */
+#ifndef MTRR_SOURCE
+#define MTRR_SOURCE "../../src/cpu/x86/mtrr/mtrr.c"
+#endif
+#include MTRR_SOURCE
+
+#include "hosttest.h"
+
+/* What mtrr.c needs from the rest of ramstage. */
+int do_printk(int msg_level, const char *fmt, ...)
+{
+	return 0;
+}
+
+void *cbmem_find(u32 id)
+{
+	return NULL;
+}
+
+void *cbmem_add(u32 id, u64 size)
+{
+	return NULL;
+}
+
+int cpu_phys_address_size(void)
+{
+	return 39;
+}
+
+void post_code(uint8_t value)
+{
+}
+
+void search_global_resources(unsigned long type_mask, unsigned long type,
+			     resource_search_t search, void *gp)
+{
+}
+
+#define MEM_MiB(x) ((uint64_t)(x) * MiB)
+#define MEM_GiB(x) ((uint64_t)(x) * GiB)
+
+struct test_range {
+	uint64_t base;
+	uint64_t end;
+	int type;
+};
+
+struct test_map {
+	const char *name;
+	int address_bits;
+	int num_ranges;
+	struct test_range ranges[4];
+};
+
+static const struct test_map test_maps[] = {
+	{ "2GiB, IGD stolen and WC", 39, 3, {
+		{ 0, 0x7f800000, MTRR_TYPE_WRBACK },
+		{ 0xe0000000, 0xf0000000, MTRR_TYPE_WRCOMB },
+		{ MEM_GiB(4), 0x47f800000ULL, MTRR_TYPE_WRBACK } } },
+	{ "3.5GiB - 64MiB, 8.5GiB", 36, 2, {
+		{ 0, MEM_MiB(3584) - MEM_MiB(64), MTRR_TYPE_WRBACK },
+		{ MEM_GiB(4), MEM_GiB(8) + MEM_MiB(512), MTRR_TYPE_WRBACK } } },
+	{ "3GiB - 1MiB, WC, 16GiB", 39, 3, {
+		{ 0, MEM_GiB(3) - MEM_MiB(1), MTRR_TYPE_WRBACK },
+		{ 0xd0000000, 0xe0000000, MTRR_TYPE_WRCOMB },
+		{ MEM_GiB(4), MEM_GiB(16), MTRR_TYPE_WRBACK } } },
+	{ "odd TOLUD, 34GiB", 46, 2, {
+		{ 0, 0x7b000000, MTRR_TYPE_WRBACK },
+		{ MEM_GiB(4), 0x880000000ULL, MTRR_TYPE_WRBACK } } },
+	{ "split low memory", 39, 3, {
+		{ 0, 0x3fe00000, MTRR_TYPE_WRBACK },
+		{ 0x40000000, 0x8f800000, MTRR_TYPE_WRBACK },
+		{ MEM_GiB(4), 0x270000000ULL, MTRR_TYPE_WRBACK } } },
+	{ "UC hole in low memory", 39, 3, {
+		{ 0, MEM_GiB(2), MTRR_TYPE_WRBACK },
+		{ MEM_GiB(2) + MEM_MiB(256), MEM_GiB(3), MTRR_TYPE_WRBACK },
+		{ MEM_GiB(4), MEM_GiB(6), MTRR_TYPE_WRBACK } } },
+};
+
+/* Effective type of an address as the CPU resolves overlapping MTRRs. */
+static int effective_type(const struct var_mtrr_solution *sol, uint64_t addr,
+			  int address_bits)
+{
+	const uint64_t phys_mask = (1ULL << address_bits) - 1;
+	int uc = 0, wb = 0, other = -1;
+	int i;
+
+	for (i = 0; i < sol->num_used; i++) {
+		const struct var_mtrr_regs *regs = &sol->regs[i];
+		uint64_t base, mask;
+		int type;
+
+		base = ((uint64_t)regs->base.hi << 32) | regs->base.lo;
+		mask = ((uint64_t)regs->mask.hi << 32) | regs->mask.lo;
+		type = base & 0xff;
+		base &= phys_mask & ~0xfffULL;
+		mask &= phys_mask & ~0xfffULL;
+
+		if ((addr & mask) != (base & mask))
+			continue;
+
+		if (type == MTRR_TYPE_UNCACHEABLE)
+			uc = 1;
+		else if (type == MTRR_TYPE_WRBACK)
+			wb = 1;
+		else
+			other = type;
+	}
+
+	if (uc)
+		return MTRR_TYPE_UNCACHEABLE;
+	if (other >= 0)
+		return other;
+	if (wb)
+		return MTRR_TYPE_WRBACK;
+	return sol->mtrr_default_type;
+}
+
+/* Returns the number of MTRRs used, or -1 if the solution is wrong. */
+static int run_map(const struct test_map *map, int verbose)
+{
+	static struct var_mtrr_solution sol;
+	struct memranges addr_space;
+	struct range_entry *r;
+	int errors = 0;
+	int i;
+
+	memranges_init_empty(&addr_space, NULL, 0);
+	for (i = 0; i < map->num_ranges; i++)
+		memranges_insert(&addr_space, map->ranges[i].base,
+				 map->ranges[i].end - map->ranges[i].base,
+				 map->ranges[i].type);
+	memranges_fill_holes_up_to(&addr_space, MEM_GiB(4),
+				   MTRR_TYPE_UNCACHEABLE);
+
+	total_mtrrs = NUM_MTRR_STATIC_STORAGE;
+	bios_mtrrs = NUM_MTRR_STATIC_STORAGE;
+	memset(&sol, 0, sizeof(sol));
+	sol.mtrr_default_type = calc_var_mtrrs(&addr_space, 1,
+					       map->address_bits);
+	prepare_var_mtrrs(&addr_space, sol.mtrr_default_type, 1,
+			  map->address_bits, &sol);
+
+	/* The first and last page and the middle of every range. The fixed
+	 * MTRRs cover the first 1MiB. */
+	memranges_each_entry(r, &addr_space) {
+		const uint64_t addrs[] = {
+			range_entry_base(r),
+			range_entry_end(r) - 4096,
+			range_entry_base(r) + (range_entry_size(r) / 2 & ~0xfffULL),
+		};
+		const int want = range_entry_mtrr_type(r);
+
+		for (i = 0; i < ARRAY_SIZE(addrs); i++) {
+			int got;
+
+			if (addrs[i] < RANGE_TO_PHYS_ADDR(RANGE_1MB))
+				continue;
+
+			got = effective_type(&sol, addrs[i], map->address_bits);
+			if (got != want) {
+				host_printf("%s: 0x%llx is type %d, not %d\n",
+					    map->name, addrs[i], got, want);
+				errors++;
+			}
+		}
+	}
+
+	memranges_teardown(&addr_space);
+
+	if (verbose || errors)
+		host_printf("%-28s default %s, %2d MTRRs%s\n", map->name,
+			    sol.mtrr_default_type == MTRR_TYPE_WRBACK ?
+			    "WB" : "UC", sol.num_used,
+			    errors ? ", WRONG" : "");
+
+	return errors ? -1 : sol.num_used;
+}
+
+const int test_count = 2000;
+
+int test_main(const struct host_args *args)
+{
+	int used[NUM_MTRR_STATIC_STORAGE + 1] = { 0 };
+	int failed = 0;
+	int worst = 0;
+	int i, n;
+
+	for (i = 0; i < ARRAY_SIZE(test_maps); i++) {
+		n = run_map(&test_maps[i], 1);
+		if (n < 0)
+			failed++;
+	}
+
+	/* TOLUD, the amount of memory above 4GiB and the position of a WC
+	 * framebuffer below 4GiB are varied. */
+	host_srandom(args->seed);
+	for (i = 0; i < args->count; i++) {
+		struct test_map map = {
+			.name = "generated",
+			.address_bits = 39,
+			.num_ranges = 2,
+		};
+		uint64_t tolud = MEM_MiB(host_random() % 4096 + 1);
+		uint64_t high = MEM_GiB(4) + MEM_MiB(host_random() % 8192 + 1);
+		uint64_t fb = MEM_GiB(3) + MEM_MiB(host_random() % 4 * 256);
+
+		tolud = MIN(tolud, MEM_GiB(3) + MEM_MiB(768));
+
+		map.ranges[0] = (struct test_range){ 0, tolud,
+						     MTRR_TYPE_WRBACK };
+		map.ranges[1] = (struct test_range){ MEM_GiB(4), high,
+						     MTRR_TYPE_WRBACK };
+		if (fb >= tolud)
+			map.ranges[map.num_ranges++] = (struct test_range){
+				fb, fb + MEM_MiB(256), MTRR_TYPE_WRCOMB };
+
+		n = run_map(&map, args->verbose);
+		if (n < 0) {
+			failed++;
+			continue;
+		}
+		used[MIN(n, NUM_MTRR_STATIC_STORAGE)]++;
+		worst = MAX(worst, n);
+	}
+
+	if (args->count) {
+		host_printf("%d generated maps, MTRRs used:", args->count);
+		for (i = 0; i <= worst; i++)
+			if (used[i])
+				host_printf(" %d:%d", i, used[i]);
+		host_printf("\n");
+	}
+
+	if (failed) {
+		host_printf("%d maps have wrong effective types\n", failed);
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,320 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Runs the SHA-1 and SHA-256 hwcrypto code of vboot on arm64 on known
+ * answers, with the input passed whole, byte by byte and in chunks of random
+ * size. The block functions of sha_ce_core.S run in the a64.c interpreter.
+ * SHA-1 is run a second time with the block function of libpayload.
+ */
+
+#include "../../src/arch/arm64/armv8/sha_ce.c"
+
+#include "a64.h"
+#include "hosttest.h"
+#include "sha_ce_asm.h"
+
+/* FIPS 180-2 appendix A and B, and a pattern around the block boundaries. */
+static const struct vector {
+	const char *msg;	/* NULL for len bytes of pattern[] */
+	size_t len;
+	int repeat;
+	uint8_t sha1[VB2_SHA1_DIGEST_SIZE];
+	uint8_t sha256[VB2_SHA256_DIGEST_SIZE];
+} vectors[] = {
+	{ "abc", 3, 1,
+	  { 0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e,
+	    0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c, 0x9c, 0xd0, 0xd8, 0x9d },
+	  { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	    0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	    0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad } },
+	{ "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 56, 1,
+	  { 0x84, 0x98, 0x3e, 0x44, 0x1c, 0x3b, 0xd2, 0x6e, 0xba, 0xae,
+	    0x4a, 0xa1, 0xf9, 0x51, 0x29, 0xe5, 0xe5, 0x46, 0x70, 0xf1 },
+	  { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+	    0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+	    0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+	    0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 } },
+	{ "aaaaaaaaaa", 10, 100000,
+	  { 0x34, 0xaa, 0x97, 0x3c, 0xd4, 0xc4, 0xda, 0xa4, 0xf6, 0x1e,
+	    0xeb, 0x2b, 0xdb, 0xad, 0x27, 0x31, 0x65, 0x34, 0x01, 0x6f },
+	  { 0xcd, 0xc7, 0x6e, 0x5c, 0x99, 0x14, 0xfb, 0x92,
+	    0x81, 0xa1, 0xc7, 0xe2, 0x84, 0xd7, 0x3e, 0x67,
+	    0xf1, 0x80, 0x9a, 0x48, 0xa4, 0x97, 0x20, 0x0e,
+	    0x04, 0x6d, 0x39, 0xcc, 0xc7, 0x11, 0x2c, 0xd0 } },
+	{ NULL, 0, 1,
+	  { 0xda, 0x39, 0xa3, 0xee, 0x5e, 0x6b, 0x4b, 0x0d, 0x32, 0x55,
+	    0xbf, 0xef, 0x95, 0x60, 0x18, 0x90, 0xaf, 0xd8, 0x07, 0x09 },
+	  { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+	    0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+	    0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+	    0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 } },
+	{ NULL, 1, 1,
+	  { 0xbf, 0x8b, 0x45, 0x30, 0xd8, 0xd2, 0x46, 0xdd, 0x74, 0xac,
+	    0x53, 0xa1, 0x34, 0x71, 0xbb, 0xa1, 0x79, 0x41, 0xdf, 0xf7 },
+	  { 0x4b, 0xf5, 0x12, 0x2f, 0x34, 0x45, 0x54, 0xc5,
+	    0x3b, 0xde, 0x2e, 0xbb, 0x8c, 0xd2, 0xb7, 0xe3,
+	    0xd1, 0x60, 0x0a, 0xd6, 0x31, 0xc3, 0x85, 0xa5,
+	    0xd7, 0xcc, 0xe2, 0x3c, 0x77, 0x85, 0x45, 0x9a } },
+	{ NULL, 55, 1,
+	  { 0x04, 0xbb, 0x34, 0xae, 0xf4, 0x88, 0x0b, 0x62, 0x5e, 0x6b,
+	    0x15, 0x64, 0xa0, 0x14, 0xab, 0xd2, 0x5f, 0xc0, 0x2b, 0xfe },
+	  { 0x16, 0xfa, 0x57, 0xa0, 0xa3, 0x42, 0x3a, 0x71,
+	    0x5d, 0x59, 0x45, 0x16, 0x33, 0x9f, 0x36, 0x18,
+	    0x9d, 0x6b, 0x5f, 0x93, 0x75, 0x4a, 0x97, 0x14,
+	    0xfe, 0xf2, 0x02, 0x61, 0x6a, 0x9f, 0xab, 0xfe } },
+	{ NULL, 56, 1,
+	  { 0x83, 0xb9, 0xfc, 0xb6, 0xd3, 0xe3, 0xb2, 0x0f, 0x37, 0x6a,
+	    0xb9, 0x89, 0xa1, 0xb6, 0x35, 0x3b, 0xcc, 0x6c, 0x0f, 0x44 },
+	  { 0xc3, 0x7b, 0x44, 0xe5, 0xf1, 0xb1, 0x85, 0x54,
+	    0xb3, 0x69, 0x66, 0xf4, 0xf8, 0xe0, 0x8b, 0xfb,
+	    0xf3, 0x16, 0x4c, 0x4b, 0x6c, 0x10, 0x37, 0x4d,
+	    0x12, 0xd8, 0x98, 0x50, 0x89, 0x20, 0x73, 0xc5 } },
+	{ NULL, 63, 1,
+	  { 0xab, 0x15, 0x09, 0x0e, 0x8d, 0xbe, 0x51, 0x2f, 0x37, 0x33,
+	    0x35, 0x0f, 0x96, 0x23, 0xab, 0x11, 0xf9, 0xb5, 0x16, 0x5b },
+	  { 0xbb, 0xba, 0x99, 0x2d, 0x2c, 0x85, 0xaf, 0x96,
+	    0x0f, 0xb2, 0x98, 0x7a, 0x1f, 0xd0, 0x5e, 0x0a,
+	    0xa8, 0x2a, 0x3d, 0xb3, 0xc7, 0x40, 0xdd, 0x89,
+	    0x82, 0xa9, 0xe2, 0x73, 0xb7, 0x5e, 0x36, 0xa3 } },
+	{ NULL, 64, 1,
+	  { 0x54, 0x30, 0x5e, 0xe7, 0xe4, 0xc7, 0xbc, 0x5a, 0x96, 0xaf,
+	    0xc6, 0xd1, 0x99, 0x4f, 0xc5, 0x2d, 0x9b, 0xcb, 0x66, 0x5f },
+	  { 0x66, 0xbd, 0x46, 0x33, 0xed, 0x6f, 0x71, 0xc4,
+	    0xec, 0xfa, 0x47, 0x63, 0xbf, 0x7b, 0xa1, 0xc8,
+	    0xec, 0x76, 0x12, 0xde, 0x9a, 0xa6, 0xc0, 0x57,
+	    0x8a, 0x7b, 0x67, 0x52, 0x07, 0xc7, 0x1e, 0x0b } },
+	{ NULL, 65, 1,
+	  { 0x59, 0x85, 0x42, 0x2a, 0x25, 0x35, 0x73, 0x71, 0xeb, 0xd2,
+	    0xa7, 0xf6, 0xec, 0xd7, 0xee, 0xbe, 0xd4, 0x3d, 0xb4, 0x2c },
+	  { 0x9f, 0x7d, 0xc4, 0x71, 0x07, 0xb7, 0x50, 0xa1,
+	    0xf3, 0xd3, 0x5d, 0xb5, 0xd9, 0x54, 0x7f, 0x24,
+	    0xef, 0x40, 0xda, 0x5b, 0x73, 0x1b, 0x95, 0x40,
+	    0xd4, 0xf4, 0x37, 0x10, 0xa1, 0x54, 0xf6, 0xc9 } },
+	{ NULL, 119, 1,
+	  { 0x68, 0x39, 0xd6, 0xc2, 0x7f, 0x22, 0xed, 0x88, 0x4a, 0xc4,
+	    0x3a, 0xe6, 0xbd, 0x3b, 0xfc, 0xee, 0x9e, 0x04, 0xb9, 0x38 },
+	  { 0xa3, 0xed, 0x30, 0x7b, 0x73, 0x0f, 0xa7, 0x7c,
+	    0x07, 0x53, 0x13, 0x00, 0xc6, 0xe4, 0xa2, 0x82,
+	    0x33, 0x00, 0x11, 0xd4, 0xd4, 0xca, 0xf6, 0xbb,
+	    0x7b, 0x63, 0xae, 0x05, 0x95, 0x0f, 0x4b, 0x66 } },
+	{ NULL, 120, 1,
+	  { 0x8c, 0x40, 0x51, 0x7a, 0x14, 0xab, 0x8b, 0x78, 0xfd, 0x4b,
+	    0x89, 0x58, 0xf4, 0xe3, 0x12, 0x54, 0xa3, 0x4c, 0x3f, 0xb0 },
+	  { 0x8e, 0x3b, 0x15, 0xd9, 0xfe, 0xa7, 0x47, 0x26,
+	    0x55, 0xaa, 0x06, 0x96, 0x20, 0xb7, 0xf8, 0xc2,
+	    0xe5, 0x5e, 0xe1, 0x49, 0x9f, 0x76, 0x32, 0x00,
+	    0xa7, 0x51, 0x5f, 0xe8, 0x26, 0xe9, 0x9d, 0x20 } },
+	{ NULL, 127, 1,
+	  { 0x77, 0x6f, 0x97, 0x28, 0xc5, 0x64, 0x93, 0x29, 0xe5, 0xdb,
+	    0x4b, 0xb6, 0x0a, 0x25, 0xea, 0x90, 0x39, 0x25, 0xa1, 0x12 },
+	  { 0x44, 0x48, 0x0f, 0xb9, 0x67, 0x28, 0x45, 0x17,
+	    0x7f, 0x53, 0x68, 0xa0, 0x8b, 0x69, 0xea, 0x26,
+	    0x32, 0x75, 0xf2, 0xa5, 0xec, 0x42, 0xe0, 0x6a,
+	    0x93, 0x33, 0x70, 0xfe, 0x0d, 0x29, 0x68, 0xa4 } },
+	{ NULL, 128, 1,
+	  { 0x22, 0x48, 0x5d, 0xc0, 0xd1, 0xe1, 0xd6, 0xe9, 0xe9, 0x3e,
+	    0x4a, 0x2a, 0x46, 0x67, 0xb8, 0xe9, 0x79, 0x45, 0x63, 0x79 },
+	  { 0xe4, 0x62, 0xc1, 0x30, 0xfe, 0xf8, 0xc9, 0x7e,
+	    0x34, 0xf7, 0xdc, 0x3f, 0xf3, 0xad, 0x2f, 0x8b,
+	    0x35, 0x33, 0xab, 0x84, 0x9a, 0xf2, 0x1c, 0x10,
+	    0x53, 0x15, 0x52, 0xa2, 0x85, 0x23, 0x87, 0xa4 } },
+	{ NULL, 129, 1,
+	  { 0xee, 0x30, 0x88, 0x5f, 0xf6, 0xaf, 0x88, 0xe8, 0x05, 0xc4,
+	    0xb2, 0xf5, 0x4f, 0xe0, 0xa2, 0x05, 0xa0, 0x9b, 0xf2, 0xcc },
+	  { 0xaa, 0x7e, 0xa4, 0xe8, 0xbf, 0x89, 0x14, 0x6a,
+	    0xeb, 0x67, 0xff, 0x19, 0x5f, 0xd8, 0x18, 0x2a,
+	    0x0e, 0x50, 0x4c, 0x9d, 0x58, 0x0a, 0xa7, 0xaf,
+	    0x8d, 0x2c, 0x86, 0x2e, 0x14, 0xb9, 0x84, 0x05 } },
+	{ NULL, 1000, 1,
+	  { 0xf5, 0x0d, 0x11, 0xc8, 0xae, 0x2b, 0x20, 0xfe, 0x25, 0x98,
+	    0xe9, 0x9a, 0x6a, 0x2c, 0xb8, 0x59, 0xe3, 0x02, 0x61, 0x5c },
+	  { 0x09, 0x5e, 0xcb, 0x62, 0xe3, 0x07, 0x93, 0xab,
+	    0x4b, 0x95, 0x4c, 0xd6, 0xa0, 0x58, 0x6d, 0x0c,
+	    0xc9, 0x1f, 0x7e, 0xa5, 0xb1, 0x33, 0x26, 0x94,
+	    0xd8, 0xda, 0x78, 0x0e, 0x98, 0x67, 0x6d, 0x78 } },
+};
+
+enum split {
+	SPLIT_NONE,
+	SPLIT_BYTES,
+	SPLIT_RANDOM,
+};
+
+static uint8_t pattern[1000];
+static struct a64_prog core, libpayload;
+static struct a64_prog *sha1_prog;
+static int errors;
+
+/* What sha_ce.c needs from the rest of the stage. */
+int do_printk(int msg_level, const char *fmt, ...)
+{
+	return 0;
+}
+
+uint64_t raw_read_aa64isar0_el1(void)
+{
+	return 1 << ID_AA64ISAR0_SHA1_SHIFT | 1 << ID_AA64ISAR0_SHA2_SHIFT;
+}
+
+uint32_t get_current_el(void)
+{
+	return EL3;
+}
+
+uint32_t raw_read_cptr_el3(void)
+{
+	return CPTR_EL3_TFP_ENABLE;
+}
+
+void raw_write_cptr_el3(uint32_t cptr_el3)
+{
+}
+
+/* Only the boot-time self-test compares with vboot's C code. */
+int vb2_digest_buffer(const uint8_t *buf, uint32_t size,
+		      enum vb2_hash_algorithm hash_alg, uint8_t *digest,
+		      uint32_t digest_size)
+{
+	return VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED;
+}
+
+void sha1_ce_transform(uint32_t state[5], const uint8_t *data, size_t blocks)
+{
+	if (a64_call(sha1_prog, "sha1_ce_transform", (uintptr_t)state,
+		     (uintptr_t)data, blocks))
+		errors++;
+}
+
+void sha256_ce_transform(uint32_t state[8], const uint8_t *data,
+			 size_t blocks)
+{
+	if (a64_call(&core, "sha256_ce_transform", (uintptr_t)state,
+		     (uintptr_t)data, blocks))
+		errors++;
+}
+
+static void extend(const uint8_t *buf, size_t len, enum split split)
+{
+	size_t chunk;
+
+	while (len) {
+		if (split == SPLIT_BYTES)
+			chunk = 1;
+		else if (split == SPLIT_RANDOM)
+			chunk = host_random() % 150;
+		else
+			chunk = len;
+		chunk = MIN(chunk, len);
+		vb2ex_hwcrypto_digest_extend(buf, chunk);
+		buf += chunk;
+		len -= chunk;
+	}
+}
+
+static void check(const struct vector *v, enum vb2_hash_algorithm alg,
+		  enum split split)
+{
+	const uint8_t *msg = v->msg ? (const uint8_t *)v->msg : pattern;
+	const uint8_t *expect = alg == VB2_HASH_SHA1 ? v->sha1 : v->sha256;
+	size_t size = alg == VB2_HASH_SHA1 ? VB2_SHA1_DIGEST_SIZE :
+		VB2_SHA256_DIGEST_SIZE;
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	int i;
+
+	if (vb2ex_hwcrypto_digest_init(alg, v->len * v->repeat)) {
+		host_printf("SHA CE not used\n");
+		errors++;
+		return;
+	}
+	for (i = 0; i < v->repeat; i++)
+		extend(msg, v->len, split);
+	vb2ex_hwcrypto_digest_finalize(digest, sizeof(digest));
+
+	if (memcmp(digest, expect, size)) {
+		host_printf("%s%s of %zu bytes%s%s is wrong\n",
+			    alg == VB2_HASH_SHA1 ? "SHA-1" : "SHA-256",
+			    sha1_prog == &libpayload ? " (libpayload)" : "",
+			    v->len * v->repeat,
+			    split == SPLIT_BYTES ? " byte by byte" : "",
+			    split == SPLIT_RANDOM ? " in chunks" : "");
+		errors++;
+	}
+}
+
+static void check_all(enum vb2_hash_algorithm alg, int count)
+{
+	int i, round;
+
+	for (i = 0; i < ARRAY_SIZE(vectors); i++) {
+		check(&vectors[i], alg, SPLIT_NONE);
+		if (vectors[i].repeat == 1)
+			check(&vectors[i], alg, SPLIT_BYTES);
+		for (round = 0; round < count; round++)
+			check(&vectors[i], alg, SPLIT_RANDOM);
+	}
+}
+
+/* Instructions run per byte, for a long message hashed in one go. */
+static void count_insns(enum vb2_hash_algorithm alg, struct a64_prog *prog)
+{
+	static uint8_t buf[64 * KiB];
+	uint8_t digest[VB2_SHA256_DIGEST_SIZE];
+	unsigned long long insns = prog->insns;
+	unsigned long long ce_insns = prog->ce_insns;
+
+	vb2ex_hwcrypto_digest_init(alg, sizeof(buf));
+	vb2ex_hwcrypto_digest_extend(buf, sizeof(buf));
+	vb2ex_hwcrypto_digest_finalize(digest, sizeof(digest));
+
+	insns = (prog->insns - insns) * 100 / sizeof(buf);
+	ce_insns = (prog->ce_insns - ce_insns) * 100 / sizeof(buf);
+	host_printf("%-7s %llu.%02llu instructions per byte, %llu.%02llu "
+		    "of them CE\n", alg == VB2_HASH_SHA1 ? "SHA-1" : "SHA-256",
+		    insns / 100, insns % 100, ce_insns / 100, ce_insns % 100);
+}
+
+const int test_count = 10;
+
+int test_main(const struct host_args *args)
+{
+	int i;
+
+	if (a64_load(&core, sha_ce_core_S) ||
+	    a64_load(&libpayload, libpayload_sha1_ce_S))
+		return 1;
+
+	for (i = 0; i < sizeof(pattern); i++)
+		pattern[i] = i * 7 + 1;
+
+	host_srandom(args->seed);
+	sha1_prog = &core;
+	check_all(VB2_HASH_SHA1, args->count);
+	check_all(VB2_HASH_SHA256, args->count);
+	sha1_prog = &libpayload;
+	check_all(VB2_HASH_SHA1, args->count);
+	sha1_prog = &core;
+
+	if (errors) {
+		host_printf("%d errors\n", errors);
+		return 1;
+	}
+
+	host_printf("%zu vectors, %d rounds of random chunks, digests ok\n",
+		    ARRAY_SIZE(vectors), args->count);
+	count_insns(VB2_HASH_SHA1, &core);
+	count_insns(VB2_HASH_SHA256, &core);
+
+	return 0;
+}
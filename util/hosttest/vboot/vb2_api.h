@@ -0,0 +1,49 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * The part of vboot's API the hwcrypto code uses, for tests that don't
+ * build vboot. The error codes have other values than vboot's.
+ */
+
+#ifndef VB2_API_H
+#define VB2_API_H
+
+#include <stdint.h>
+
+enum vb2_hash_algorithm {
+	VB2_HASH_INVALID = 0,
+	VB2_HASH_SHA1 = 1,
+	VB2_HASH_SHA256 = 2,
+	VB2_HASH_SHA512 = 3,
+};
+
+#define VB2_SHA1_DIGEST_SIZE	20
+#define VB2_SHA256_DIGEST_SIZE	32
+
+enum vb2_return_code {
+	VB2_SUCCESS = 0,
+	VB2_ERROR_SHA_FINALIZE_DIGEST_SIZE = 0x100,
+	VB2_ERROR_EX_HWCRYPTO_UNSUPPORTED = 0x200,
+};
+
+int vb2_digest_buffer(const uint8_t *buf, uint32_t size,
+		      enum vb2_hash_algorithm hash_alg, uint8_t *digest,
+		      uint32_t digest_size);
+
+int vb2ex_hwcrypto_digest_init(enum vb2_hash_algorithm hash_alg,
+			       uint32_t data_size);
+int vb2ex_hwcrypto_digest_extend(const uint8_t *buf, uint32_t size);
+int vb2ex_hwcrypto_digest_finalize(uint8_t *digest, uint32_t digest_size);
+
+#endif /* VB2_API_H */
@@ -0,0 +1,25 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/* The options of an x86 ramstage the tests build against. */
+
+#define CONFIG_ARCH_X86 1
+#define CONFIG_ARCH_RAMSTAGE_X86_32 1
+#define CONFIG_MAX_CPUS 1
+#define CONFIG_STACK_SIZE 0x1000
+#define CONFIG_EARLY_CBMEM_INIT 1
+#define CONFIG_PCI 1
+#define CONFIG_PCI_OPTION_ROM_RUN_YABEL 1
+#define CONFIG_ONBOARD_VGA_IS_PRIMARY 0
+#define CONFIG_MMCONF_BASE_ADDRESS 0xf0000000
+#define CONFIG_MMCONF_BUS_NUMBER 256
@@ -0,0 +1,326 @@
+/*
+ * This file is part of the coreboot project.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+/*
+ * Times x86emu running real mode code behind memory hooks that work like
+ * the ones of YABEL: every access first walks the address translation table
+ * of the device. The code is either a built-in loop or an Option ROM image
+ * captured from a card. Port I/O reads all ones and the BIOS interrupts
+ * return without doing anything, so a ROM runs until it returns, halts or
+ * has made too many port accesses.
+ *
+ * A checksum of the registers and of memory is printed after every run. It
+ * must be the same for builds with and without the fetch cache, and the
+ * built-in loop has to end with a known one.
+ */
+
+#include <console/console.h>
+#include <string.h>
+#include <x86emu/x86emu.h>
+#include <x86emu/regs.h>
+
+#include "hosttest.h"
+
+#define MEM_SIZE	(1024 * 1024)
+#define ROM_BASE	0xc0000
+#define ROM_MAX_SIZE	(128 * 1024)
+#define RETURN_STUB	0x600
+#define MAX_PORT_IO	1000000
+/* What the built-in loop leaves behind, with or without the cache. */
+#define LOOP_CHECKSUM	0x09d825ee
+
+static u8 mem[MEM_SIZE];
+static int port_io;
+
+int do_printk(int msg_level, const char *fmt, ...)
+{
+	return 0;
+}
+
+/* Same layout and lookup as translate_address_array in YABEL. */
+struct translate_address {
+	unsigned long address;
+	unsigned long size;
+	unsigned long offset;
+	int info;
+};
+
+#define TA_MEM	1
+#define TA_IO	2
+
+static struct translate_address translate_address_array[] = {
+	{ 0xe0000000, 0x10000000, 0, TA_MEM },	/* framebuffer */
+	{ 0xf0000000, 0x00040000, 0, TA_MEM },	/* MMIO */
+	{ 0xf0040000, 0x00020000, 0, TA_MEM },	/* expansion ROM */
+	{ 0x00001000, 0x00000100, 0, TA_IO },	/* I/O BAR */
+	{ 0x000003b0, 0x00000030, 0, TA_IO },	/* legacy VGA ports */
+	{ 0x000a0000, 0x00020000, 0, TA_MEM },	/* legacy VGA memory */
+};
+
+static int translate_address(int type, unsigned long *addr)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(translate_address_array); i++) {
+		const struct translate_address *ta =
+			&translate_address_array[i];
+
+		if (*addr >= ta->address && *addr <= ta->address + ta->size &&
+		    (ta->info & type)) {
+			*addr += ta->offset;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Device memory reads all ones and ignores writes. */
+static u8 X86API bench_rdb(u32 addr)
+{
+	unsigned long translated = addr;
+
+	if (translate_address(TA_MEM, &translated))
+		return 0xff;
+	return rdb(addr);
+}
+
+static u16 X86API bench_rdw(u32 addr)
+{
+	unsigned long translated = addr;
+
+	if (translate_address(TA_MEM, &translated))
+		return 0xffff;
+	return rdw(addr);
+}
+
+static u32 X86API bench_rdl(u32 addr)
+{
+	unsigned long translated = addr;
+
+	if (translate_address(TA_MEM, &translated))
+		return 0xffffffff;
+	return rdl(addr);
+}
+
+static void X86API bench_wrb(u32 addr, u8 val)
+{
+	unsigned long translated = addr;
+
+	if (!translate_address(TA_MEM, &translated))
+		wrb(addr, val);
+}
+
+static void X86API bench_wrw(u32 addr, u16 val)
+{
+	unsigned long translated = addr;
+
+	if (!translate_address(TA_MEM, &translated))
+		wrw(addr, val);
+}
+
+static void X86API bench_wrl(u32 addr, u32 val)
+{
+	unsigned long translated = addr;
+
+	if (!translate_address(TA_MEM, &translated))
+		wrl(addr, val);
+}
+
+static void count_port_io(void)
+{
+	if (++port_io == MAX_PORT_IO)
+		X86EMU_halt_sys();
+}
+
+static u8 X86API bench_inb(X86EMU_pioAddr addr)
+{
+	count_port_io();
+	return 0xff;
+}
+
+static u16 X86API bench_inw(X86EMU_pioAddr addr)
+{
+	count_port_io();
+	return 0xffff;
+}
+
+static u32 X86API bench_inl(X86EMU_pioAddr addr)
+{
+	count_port_io();
+	return 0xffffffff;
+}
+
+static void X86API bench_outb(X86EMU_pioAddr addr, u8 val)
+{
+	count_port_io();
+}
+
+static void X86API bench_outw(X86EMU_pioAddr addr, u16 val)
+{
+	count_port_io();
+}
+
+static void X86API bench_outl(X86EMU_pioAddr addr, u32 val)
+{
+	count_port_io();
+}
+
+static void X86API bench_int(int num)
+{
+}
+
+/*
+ * Sums up AX 200 * 65535 times, calling the PCI BIOS once per outer loop,
+ * then patches the immediate of the "mov dl, 0" behind it and runs that.
+ * DL is 0x42 if the write reached the code that is executed.
+ */
+static const u8 loop_code[] = {
+	0x31, 0xc0,			/* xor ax, ax */
+	0xbb, 0xc8, 0x00,		/* mov bx, 200 */
+	0xb9, 0xff, 0xff,		/* outer: mov cx, 0xffff */
+	0x01, 0xc8,			/* inner: add ax, cx */
+	0xe2, 0xfc,			/* loop inner */
+	0xcd, 0x1a,			/* int 0x1a */
+	0x4b,				/* dec bx */
+	0x75, 0xf4,			/* jnz outer */
+	0x2e, 0xc6, 0x06, 0x18, 0x00, 0x42, /* mov byte [cs:0x18], 0x42 */
+	0xb2, 0x00,			/* 0x17: mov dl, 0 */
+	0xf4,				/* hlt */
+};
+
+static void setup(void)
+{
+	static X86EMU_memFuncs mem_funcs = {
+		bench_rdb, bench_rdw, bench_rdl,
+		bench_wrb, bench_wrw, bench_wrl,
+	};
+	static X86EMU_pioFuncs pio_funcs = {
+		bench_inb, bench_inw, bench_inl,
+		bench_outb, bench_outw, bench_outl,
+	};
+	static X86EMU_intrFuncs intr_funcs[256];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(intr_funcs); i++)
+		intr_funcs[i] = bench_int;
+
+	memset(mem, 0, sizeof(mem));
+	memset(&M.x86, 0, sizeof(M.x86));
+	port_io = 0;
+
+	X86EMU_setMemBase(mem, sizeof(mem));
+	X86EMU_setupMemFuncs(&mem_funcs);
+	X86EMU_setupPioFuncs(&pio_funcs);
+	X86EMU_setupIntrFuncs(intr_funcs);
+
+	M.x86.R_SS = 0x0000;
+	M.x86.R_SP = 0x7000;
+	mem[RETURN_STUB] = 0xf4;	/* hlt */
+}
+
+static void push_word(u16 val)
+{
+	M.x86.R_SP -= 2;
+	mem[M.x86.R_SS * 16 + M.x86.R_SP] = val;
+	mem[M.x86.R_SS * 16 + M.x86.R_SP + 1] = val >> 8;
+}
+
+static void load_loop(void)
+{
+	memcpy(&mem[ROM_BASE], loop_code, sizeof(loop_code));
+	M.x86.R_CS = ROM_BASE >> 4;
+	M.x86.R_IP = 0;
+}
+
+/* Enter at offset 3 like the PCI BIOS does, with a far return to a hlt. */
+static void load_rom(const u8 *rom, long rom_size)
+{
+	memcpy(&mem[ROM_BASE], rom, rom_size);
+	push_word(RETURN_STUB >> 4);
+	push_word(RETURN_STUB & 0xf);
+	M.x86.R_CS = ROM_BASE >> 4;
+	M.x86.R_IP = 3;
+	M.x86.R_AX = 0x0100;		/* bus 1, devfn 0 */
+}
+
+static u32 checksum(void)
+{
+	u32 sum = M.x86.R_EAX ^ M.x86.R_EBX << 1 ^ M.x86.R_ECX << 2 ^
+		M.x86.R_EDX << 3 ^ M.x86.R_CS << 4 ^ M.x86.R_IP << 5;
+	int i;
+
+	for (i = 0; i < MEM_SIZE; i++)
+		sum = (sum << 5) + sum + mem[i];
+
+	return sum;
+}
+
+const int test_count = 1;
+
+int test_main(const struct host_args *args)
+{
+	const unsigned char *rom = args->file;
+	long rom_size = args->file_size;
+	int runs = args->count;
+	long long best = 0;
+	u32 sum = 0;
+	int i;
+
+	if (rom != NULL && (rom_size < 3 || rom_size > ROM_MAX_SIZE ||
+			    rom[0] != 0x55 || rom[1] != 0xaa)) {
+		host_printf("Not an Option ROM image\n");
+		return 1;
+	}
+
+	host_printf("x86emu %s fetch cache, %s\n",
+		    IS_ENABLED(CONFIG_X86EMU_FETCH_CACHE) ? "with" : "without",
+		    rom ? "Option ROM" : "built-in loop");
+
+	for (i = 0; i < runs; i++) {
+		long long start, time;
+
+		setup();
+		if (rom)
+			load_rom(rom, rom_size);
+		else
+			load_loop();
+
+		start = host_time_us();
+		X86EMU_exec();
+		time = host_time_us() - start;
+
+		if (i == 0 || time < best)
+			best = time;
+		sum = checksum();
+	}
+
+	if (rom && port_io >= MAX_PORT_IO)
+		host_printf("Stopped after %d port accesses\n", port_io);
+
+	host_printf("best of %d runs: %lld us, checksum %08x\n", runs, best,
+		    sum);
+
+	if (!rom && M.x86.R_DL != 0x42) {
+		host_printf("Self-modifying code ran stale: DL is %02x\n",
+			    M.x86.R_DL);
+		return 1;
+	}
+
+	if (!rom && sum != LOOP_CHECKSUM) {
+		host_printf("Wrong checksum, expected %08x\n", LOOP_CHECKSUM);
+		return 1;
+	}
+
+	return 0;
+}